@@ -1,21 +1,12 @@
 #include "battery.h"
 #include "compat-filesystem.h"
 #include "gmenu2x.h"
-#include "surfacecollection.h"
 #include "utilities.h"
 
-#include <SDL2/SDL.h>
 #include <cstdio>
-#include <sstream>
 
 
-/**
- * Reads the current battery state and returns a number representing its level
- * of charge.
- * @return A number representing battery charge: 0 means fully discharged,
- * 5 means fully charged, 6 represents running on external power.
- */
-unsigned short Battery::getBatteryLevel()
+unsigned short Battery::getBatteryLevel() const
 {
 	unsigned long voltage_min = 0, voltage_max = 1, voltage_now = 1;
 	FILE *handle;
@@ -92,7 +83,7 @@ unsigned short Battery::getBatteryLevel()
 	return (voltage_now - voltage_min) * 6 / (voltage_max - voltage_min);
 }
 
-Battery::Battery(GMenu2X& gmenu2x) : sc(gmenu2x.sc)
+Battery::Battery(GMenu2X& gmenu2x)
 {
 	std::vector<std::string> bat_paths;
 	std::vector<std::string> pw_paths;
@@ -117,31 +108,4 @@ Battery::Battery(GMenu2X& gmenu2x) : sc(gmenu2x.sc)
 			break;
 		}
 	}
-
-	lastUpdate = SDL_GetTicks();
-	update();
-}
-
-std::shared_ptr<OffscreenSurface> Battery::getIcon()
-{
-	// Check battery status every 60 seconds.
-	unsigned int now = SDL_GetTicks();
-	if (now - lastUpdate >= 60000) {
-		lastUpdate = now;
-		update();
-	}
-
-	return sc.skinRes(iconPath);
-}
-
-void Battery::update()
-{
-	unsigned short battlevel = getBatteryLevel();
-	if (battlevel > 5) {
-		iconPath = "imgs/battery/ac.png";
-	} else {
-		std::stringstream ss;
-		ss << "imgs/battery/" << battlevel << ".png";
-		ss >> iconPath;
-	}
 }
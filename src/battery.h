@@ -1,39 +1,27 @@
 #ifndef __BATTERY_H__
 #define __BATTERY_H__
 
-#include <memory>
 #include <string>
 
 class GMenu2X;
-class OffscreenSurface;
-class SurfaceCollection;
 
 
 /**
- * Keeps track of the battery status.
+ * Reads the battery status from sysfs.
  */
 class Battery {
 public:
 	Battery(GMenu2X& gmenu2x);
 
 	/**
-	 * Gets the icon that reflects the current battery status.
+	 * Reads the current battery state and returns a number representing its
+	 * level of charge: 0 means fully discharged, 5 means fully charged,
+	 * 6 represents running on external power.
+	 * Does not touch any GMenu2X state, so it can be called from any thread.
 	 */
-	std::shared_ptr<OffscreenSurface> getIcon();
-
-	/**
-	 * Forces an update of the battery status.
-	 * By default, the status is only updated once every 60 seconds.
-	 */
-	void update();
+	unsigned short getBatteryLevel() const;
 
 private:
-	unsigned short getBatteryLevel();
-
-	SurfaceCollection& sc;
-	std::string iconPath;
-	unsigned int lastUpdate;
-
 	std::string batterySysfs;
 	std::string powerSupplySysfs;
 };
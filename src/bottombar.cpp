@@ -3,12 +3,14 @@
 #include "bottombar.h"
 #include "clock.h"
 #include "gmenu2x.h"
-#include "compat-filesystem.h"
 
+#include <iomanip>
+#include <sstream>
+#include <string>
 #include <tuple>
 
 BottomBar::BottomBar(GMenu2X& gmenu2x)
-	: gmenu2x(gmenu2x), battery(gmenu2x), freeMiB(-1), totalMiB(-1),
+	: gmenu2x(gmenu2x), statusGeneration(0), freeMiB(-1), totalMiB(-1),
 	  cpufreq(0), hours(99), minutes(99), timeIs24(true), manualEnabled(false)
 {
 	setSize(0, gmenu2x.skinConfInt["bottomBarHeight"]);
@@ -17,19 +19,31 @@ BottomBar::BottomBar(GMenu2X& gmenu2x)
 
 	margin = gmenu2x.skinConfInt["bottomBarHeight"] / 2;
 
+	if (!gmenu2x.isReplaying()) {
+		sampler = std::make_unique<StatusSampler>(
+				Battery(gmenu2x), GMenu2X::getHome());
+		statusGeneration = sampler->generation();
+#ifdef ENABLE_CLOCK
+		clock = std::make_unique<Clock>(gmenu2x.timers);
+#endif
+	}
+
 	auto sd = std::make_shared<LayoutSurface>(gmenu2x.sc.skinRes("imgs/sd.png"));
 	sd->setMargins(margin, 0, 0, 0);
 	addChild(sd);
 
-	sd_text.reset();
-	updateDiskFreeText();
+	// The texts and the battery icon keep their place; their contents are
+	// replaced when they change.
+	sd_text = std::make_shared<LayoutSurface>();
+	addChild(sd_text);
 
 	auto cpu_icon = std::make_shared<LayoutSurface>(gmenu2x.sc.skinRes("imgs/cpu.png"));
 	cpu_icon->setMargins(margin, 0, 0, 0);
 	cpu = cpu_icon;
 	addChild(cpu);
 
-	cpu_text.reset();
+	cpu_text = std::make_shared<LayoutSurface>();
+	addChild(cpu_text);
 
 	manual = std::make_shared<LayoutSurface>(gmenu2x.sc.skinRes("imgs/manual.png"));
 	manual->setMargins(margin, 0, 0, 0);
@@ -39,20 +53,48 @@ BottomBar::BottomBar(GMenu2X& gmenu2x)
 	spacer->setBehave(LAY_HFILL);
 	addChild(spacer);
 
-	updateTimeText();
+	clock_text = std::make_shared<LayoutSurface>();
+	addChild(clock_text);
 
-	updateBatteryIcon();
+	battery_icon = std::make_shared<LayoutSurface>();
+	battery_icon->setMargins(margin, 0, 0, 0);
+	addChild(battery_icon);
+
+	if (sampler) {
+		auto status = sampler->status();
+		updateDiskFreeText(status);
+		updateTimeText();
+		updateBatteryIcon(status);
+	} else {
+		sd_text->hide();
+		clock_text->hide();
+		battery_icon->hide();
+	}
 
 	/* These are hidden by default */
 	cpu->hide();
+	cpu_text->hide();
 	manual->hide();
 }
 
+BottomBar::~BottomBar()
+{
+}
+
 void BottomBar::update()
 {
-	updateDiskFreeText();
+	if (!sampler)
+		return;
+
+	// This runs every frame: only look at the status if it changed.
+	const unsigned int generation = sampler->generation();
+	if (generation != statusGeneration) {
+		statusGeneration = generation;
+		auto status = sampler->status();
+		updateDiskFreeText(status);
+		updateBatteryIcon(status);
+	}
 	updateTimeText();
-	updateBatteryIcon();
 }
 
 void BottomBar::enableManualIcon(bool enable)
@@ -70,17 +112,7 @@ void BottomBar::showCpuFreq(unsigned long mhz)
 		std::ostringstream ss;
 		ss << mhz << "MHz";
 
-		auto text_s = gmenu2x.font->render(ss.str());
-		auto new_cpu_text = std::make_shared<LayoutSurface>(text_s);
-
-		if (cpu_text) {
-			addSibling(cpu_text, new_cpu_text);
-			removeChild(cpu_text);
-		} else {
-			addSibling(cpu, new_cpu_text);
-		}
-
-		cpu_text = new_cpu_text;
+		cpu_text->setSurface(gmenu2x.font->render(ss.str()));
 
 		cpu->show();
 		cpu_text->show();
@@ -92,31 +124,23 @@ void BottomBar::showCpuFreq(unsigned long mhz)
 
 void BottomBar::updateBattery()
 {
-	battery.update();
+	if (sampler)
+		sampler->refresh();
 }
 
-bool BottomBar::updateDiskFree()
+bool BottomBar::updateDiskFree(const StatusSampler::Status &status)
 {
-	unsigned long free = 0, total = 0;
-	std::error_code ec;
-	auto space = compat::filesystem::space(GMenu2X::getHome(), ec);
-
-	if (!ec) {
-		free = space.free / (1024 * 1024);
-		total = space.capacity / (1024 * 1024);
-	}
-
-	if (free == freeMiB && total == totalMiB)
+	if (status.freeMiB == freeMiB && status.totalMiB == totalMiB)
 		return false;
 
-	freeMiB = free;
-	totalMiB = total;
+	freeMiB = status.freeMiB;
+	totalMiB = status.totalMiB;
 	return true;
 }
 
-void BottomBar::updateDiskFreeText()
+void BottomBar::updateDiskFreeText(const StatusSampler::Status &status)
 {
-	if (!updateDiskFree())
+	if (!updateDiskFree(status))
 		return;
 
 	std::ostringstream ss;
@@ -127,26 +151,15 @@ void BottomBar::updateDiskFreeText()
 		ss << freeMiB << "/" << totalMiB << "MiB";
 	}
 
-	auto text_s = gmenu2x.font->render(ss.str());
-	auto new_sd_text = std::make_shared<LayoutSurface>(text_s);
-
-	if (sd_text) {
-		addSibling(sd_text, new_sd_text);
-		removeChild(sd_text);
-	} else {
-		addChild(new_sd_text);
-	}
-
-	sd_text = new_sd_text;
+	sd_text->setSurface(gmenu2x.font->render(ss.str()));
 }
 
 bool BottomBar::updateTime()
 {
 #ifdef ENABLE_CLOCK
 	unsigned new_hours, new_minutes;
-	Clock clock;
 
-	std::tie(new_hours, new_minutes) = clock.getCurrentTime();
+	std::tie(new_hours, new_minutes) = clock->getCurrentTime();
 
 	if (new_hours != hours || new_minutes != minutes) {
 		hours = new_hours;
@@ -173,38 +186,16 @@ void BottomBar::updateTimeText()
 	if (!timeIs24)
 		ss << (hours >= 12 ? "pm" : "am");
 
-	auto text_s = gmenu2x.font->render(ss.str());
-	auto new_clock_text = std::make_shared<LayoutSurface>(text_s);
-
-	new_clock_text->setMargins(margin, 0, margin, 0);
-
-	if (clock_text) {
-		addSibling(clock_text, new_clock_text);
-		removeChild(clock_text);
-	} else {
-		addChild(new_clock_text);
-	}
-
-	clock_text = new_clock_text;
+	clock_text->setSurface(gmenu2x.font->render(ss.str()));
+	clock_text->setMargins(margin, 0, margin, 0);
 }
 
-void BottomBar::updateBatteryIcon()
+void BottomBar::updateBatteryIcon(const StatusSampler::Status &status)
 {
-	auto icon = battery.getIcon();
-
-	if (battery_icon && battery_icon->getSurface() == icon)
-		return;
-
-	auto icon_item = std::make_shared<LayoutSurface>(icon);
-
-	icon_item->setMargins(margin, 0, 0, 0);
-
-	if (battery_icon) {
-		addSibling(battery_icon, icon_item);
-		removeChild(battery_icon);
-	} else {
-		addChild(icon_item);
-	}
+	auto icon = gmenu2x.sc.skinRes(status.batteryLevel > 5
+			? std::string("imgs/battery/ac.png")
+			: "imgs/battery/" + std::to_string(status.batteryLevel) + ".png");
 
-	battery_icon = icon_item;
+	if (battery_icon->getSurface() != icon)
+		battery_icon->setSurface(icon);
 }
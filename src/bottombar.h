@@ -3,13 +3,17 @@
 #ifndef BOTTOMBAR_H
 #define BOTTOMBAR_H
 
-#include "battery.h"
 #include "layer.h"
+#include "statussampler.h"
+
+#include <memory>
+
+class Clock;
 
 class BottomBar : public Layer {
 public:
 	BottomBar(GMenu2X& gmenu2x);
-	~BottomBar() {}
+	~BottomBar();
 
 	virtual void paint(Surface& s) {}
 	virtual bool handleButtonPress(InputManager::Button button) { return false; }
@@ -18,11 +22,20 @@ public:
 
 	void enableManualIcon(bool enable);
 	void showCpuFreq(unsigned long mhz = 0);
+	/** Samples the battery again soon. Async-signal-safe. */
 	void updateBattery();
 
 private:
 	GMenu2X& gmenu2x;
-	Battery battery;
+	/**
+	 * Not set during a replay: the status would make the frames depend on
+	 * the machine and the time of the run, so it is not shown then.
+	 */
+	std::unique_ptr<StatusSampler> sampler;
+	/** Generation of the status that is shown. */
+	unsigned int statusGeneration;
+	/** Only set if the clock is enabled and the status is shown. */
+	std::unique_ptr<Clock> clock;
 	unsigned long freeMiB, totalMiB, cpufreq;
 	unsigned int hours, minutes, margin;
 	bool timeIs24, manualEnabled, cpuFreqEnabled;
@@ -30,12 +43,12 @@ private:
 	std::shared_ptr<LayoutSurface> sd_text, clock_text,
 		battery_icon, cpu, cpu_text, manual;
 
-	bool updateDiskFree();
+	bool updateDiskFree(const StatusSampler::Status &status);
 	bool updateTime();
 
-	void updateDiskFreeText();
+	void updateDiskFreeText(const StatusSampler::Status &status);
 	void updateTimeText();
-	void updateBatteryIcon();
+	void updateBatteryIcon(const StatusSampler::Status &status);
 };
 
 #endif /* BOTTOMBAR_H */
@@ -16,11 +16,16 @@ BrowseDialog::BrowseDialog(
 		GMenu2X& gmenu2x,
 		const string &title, const string &subtitle)
 	: Dialog(gmenu2x)
+	, selected(0)
 	, title(title)
 	, subtitle(subtitle)
+	, bg(*gmenu2x.bg)
 {
 	buttonBox.add(unique_ptr<IconButton>(new IconButton(
 			gmenu2x, "skin:imgs/buttons/left.png")));
+	buttonBox.add(unique_ptr<IconButton>(new IconButton(
+			gmenu2x, "skin:imgs/buttons/right.png",
+			gmenu2x.tr["Jump"])));
 	buttonBox.add(unique_ptr<IconButton>(new IconButton(
 			gmenu2x, "skin:imgs/buttons/cancel.png",
 			gmenu2x.tr["Up one folder"],
@@ -44,18 +49,6 @@ BrowseDialog::BrowseDialog(
 	iconGoUp = gmenu2x.sc.skinRes("imgs/go-up.png");
 	iconFolder = gmenu2x.sc.skinRes("imgs/folder.png");
 	iconFile = gmenu2x.sc.skinRes("imgs/file.png");
-}
-
-BrowseDialog::~BrowseDialog()
-{
-}
-
-bool BrowseDialog::exec()
-{
-	string path = getPath();
-	if (path.empty() || !fileExists(path)
-		|| path.compare(0, sizeof(GMENU2X_CARD_ROOT), GMENU2X_CARD_ROOT) != 0)
-		setPath(GMENU2X_CARD_ROOT);
 
 	const int topBarHeight = gmenu2x.skinConfInt["topBarHeight"];
 	rowHeight = gmenu2x.font->getLineSpacing() + 1; // gp2x=15+1 / pandora=19+1
@@ -68,14 +61,31 @@ bool BrowseDialog::exec()
 		static_cast<Uint16>(gmenu2x.height() - topBarHeight - 25)
 	};
 
-	selected = 0;
-	close = false;
-	while (!close) {
-		paint();
-		handleInput();
-	}
+	drawTitleIcon(bg, "icons/explorer.png", true);
+	writeTitle(bg, title);
+	writeSubTitle(bg, subtitle);
+	buttonBox.paint(bg, 5, gmenu2x.height() - 1);
+	bg.convertToDisplayFormat();
+}
+
+BrowseDialog::~BrowseDialog()
+{
+}
+
+void BrowseDialog::setPath(const string &path)
+{
+	if (path.empty() || !fileExists(path)
+		|| path.compare(0, sizeof(GMENU2X_CARD_ROOT), GMENU2X_CARD_ROOT) != 0)
+		openDirectory(GMENU2X_CARD_ROOT);
+	else
+		openDirectory(path);
+}
 
-	return result;
+void BrowseDialog::openDirectory(const string &path)
+{
+	this->path = path;
+	fl.browse(path);
+	onChangeDir();
 }
 
 BrowseDialog::Action BrowseDialog::getAction(InputManager::Button button)
@@ -91,7 +101,10 @@ BrowseDialog::Action BrowseDialog::getAction(InputManager::Button button)
 			return BrowseDialog::ACT_SCROLLUP;
 		case InputManager::ALTRIGHT:
 			return BrowseDialog::ACT_SCROLLDOWN;
+		case InputManager::RIGHT:
+			return BrowseDialog::ACT_NEXTGROUP;
 		case InputManager::LEFT:
+			return BrowseDialog::ACT_PREVGROUP;
 		case InputManager::CANCEL:
 			return BrowseDialog::ACT_GOUP;
 		case InputManager::ACCEPT:
@@ -103,9 +116,8 @@ BrowseDialog::Action BrowseDialog::getAction(InputManager::Button button)
 	}
 }
 
-void BrowseDialog::handleInput()
+bool BrowseDialog::handleButtonPress(InputManager::Button button)
 {
-	InputManager::Button button = gmenu2x.input.waitForPressedButton();
 	BrowseDialog::Action action = getAction(button);
 
 	if (action == BrowseDialog::ACT_SELECT && fl[selected] == "..") {
@@ -139,6 +151,12 @@ void BrowseDialog::handleInput()
 		else
 			selected += numRows-2;
 		break;
+	case BrowseDialog::ACT_PREVGROUP:
+		selected = fl.prevGroup(selected);
+		break;
+	case BrowseDialog::ACT_NEXTGROUP:
+		selected = fl.nextGroup(selected);
+		break;
 	case BrowseDialog::ACT_GOUP:
 		directoryUp();
 		break;
@@ -154,6 +172,26 @@ void BrowseDialog::handleInput()
 	default:
 		break;
 	}
+	return true;
+}
+
+bool BrowseDialog::handleButtonPress(InputManager::Button button,
+		unsigned int count)
+{
+	const unsigned int size = fl.size();
+	if (size == 0)
+		return Layer::handleButtonPress(button, count);
+
+	switch (getAction(button)) {
+	case BrowseDialog::ACT_UP:
+		selected = (selected + size - count % size) % size;
+		return true;
+	case BrowseDialog::ACT_DOWN:
+		selected = (selected + count) % size;
+		return true;
+	default:
+		return Layer::handleButtonPress(button, count);
+	}
 }
 
 void BrowseDialog::directoryUp()
@@ -175,7 +213,7 @@ void BrowseDialog::directoryUp()
 		quit();
 	} else {
 		selected = 0;
-		setPath(path.substr(0, p));
+		openDirectory(path.substr(0, p));
 	}
 }
 
@@ -186,40 +224,34 @@ void BrowseDialog::directoryEnter()
 		path += "/";
 	}
 
-	setPath(path + fl[selected]);
+	openDirectory(path + fl[selected]);
 
 	selected = 0;
 }
 
 void BrowseDialog::confirm()
 {
-	result = true;
-	close = true;
+	dismiss();
+	if (onConfirm && canConfirm()) {
+		onConfirm(getPath(), selected < fl.size() ? getFile() : string());
+	}
 }
 
 void BrowseDialog::quit()
 {
-	result = false;
-	close = true;
+	dismiss();
 }
 
-void BrowseDialog::paint()
+void BrowseDialog::paint(Surface& s)
 {
-	OutputSurface& s = *gmenu2x.s;
-
 	unsigned int i, iY;
 	unsigned int firstElement, lastElement;
 	unsigned int offsetY;
 
-	OffscreenSurface bg(*gmenu2x.bg);
-	drawTitleIcon(bg, "icons/explorer.png", true);
-	writeTitle(bg, title);
-	writeSubTitle(bg, subtitle);
-	buttonBox.paint(bg, 5, gmenu2x.height() - 1);
-
-	bg.convertToDisplayFormat();
 	bg.blit(s, 0, 0);
 
+	beforeFileList(s);
+
 	// TODO(MtH): I have no idea what the right value of firstElement would be,
 	//            but originally it was undefined and that is never a good idea.
 	firstElement = 0;
@@ -262,6 +294,5 @@ void BrowseDialog::paint()
 	}
 	s.clearClipRect();
 
-	gmenu2x.drawScrollBar(numRows,fl.size(), firstElement);
-	s.flip();
+	gmenu2x.drawScrollBar(s, numRows, fl.size(), firstElement);
 }
@@ -25,22 +25,53 @@
 #include "dialog.h"
 #include "filelister.h"
 #include "inputmanager.h"
+#include "layer.h"
+#include "surface.h"
 
 #include <SDL2/SDL.h>
+#include <functional>
 #include <string>
 
-class OffscreenSurface;
+class BrowseDialog : public Layer, protected Dialog {
+public:
+	/** Called with the path and the selected file, if any. */
+	typedef std::function<void(const std::string &, const std::string &)>
+			Callback;
+
+	/** Sets what to do once the selection has been confirmed. */
+	void setOnConfirm(Callback callback) { onConfirm = std::move(callback); }
+
+	// Layer implementation:
+	virtual bool isModal() const { return true; }
+	virtual void paint(Surface& s);
+	virtual bool handleButtonPress(InputManager::Button button);
+	virtual bool handleButtonPress(InputManager::Button button,
+			unsigned int count);
+
+	const std::string &getPath() {
+		return path;
+	}
+	std::string getFile() {
+		return fl[selected];
+	}
 
-class BrowseDialog : protected Dialog {
 protected:
 	BrowseDialog(GMenu2X& gmenu2x,
 			const std::string &title, const std::string &subtitle);
 	virtual ~BrowseDialog();
 
-	void setPath(const std::string &path) {
-		this->path = path;
-		fl.browse(path);
-	}
+	/**
+	 * Sets the directory to start in: the given one, or the root of the
+	 * card if the directory does not exist or lies outside of it.
+	 */
+	void setPath(const std::string &path);
+
+	/** Called on every repaint, before the file list is drawn. */
+	virtual void beforeFileList(Surface&) {}
+	/** Called after a different directory has been opened. */
+	virtual void onChangeDir() {}
+	/** Returns true iff the current selection may be confirmed. */
+	virtual bool canConfirm() { return true; }
 
 	FileLister fl;
 	unsigned int selected;
@@ -54,11 +85,13 @@ private:
 		ACT_DOWN,
 		ACT_SCROLLUP,
 		ACT_SCROLLDOWN,
+		ACT_PREVGROUP,
+		ACT_NEXTGROUP,
 		ACT_GOUP,
 		ACT_CONFIRM,
 	};
 
-	bool close, result;
+	Callback onConfirm;
 
 	std::string title;
 	std::string subtitle;
@@ -74,26 +107,17 @@ private:
 	std::shared_ptr<OffscreenSurface> iconFile;
 
 	ButtonBox buttonBox;
+	/** Background with the title and the buttons. */
+	OffscreenSurface bg;
 
 	Action getAction(InputManager::Button button);
-	void handleInput();
 
-	void paint();
+	void openDirectory(const std::string &path);
 
 	void directoryUp();
 	void directoryEnter();
 	void confirm();
 	void quit();
-
-public:
-	bool exec();
-
-	const std::string &getPath() {
-		return path;
-	}
-	std::string getFile() {
-		return fl[selected];
-	}
 };
 
 #endif // INPUTDIALOG_H
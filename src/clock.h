@@ -1,24 +1,23 @@
 #ifndef __CLOCK_H__
 #define __CLOCK_H__
 
-#include <memory>
+#include "timerscheduler.h"
+
 #include <string>
 #include <tuple>
 
 
 /**
  * A keeper of wall clock time with minute accuracy.
- * Sends a user event on every minute boundary, to force a repaint of the
- * clock display.
+ * Requests a repaint on every minute boundary, to update the clock display.
  */
 class Clock {
 public:
-	/**
-	 * Used by implementation; please ignore.
-	 */
-	class Timer;
+	Clock(TimerScheduler &timers);
+	~Clock();
 
-	Clock();
+	Clock(const Clock&) = delete;
+	Clock& operator=(const Clock&) = delete;
 
 	/**
 	 * Gets a string representation of the current time.
@@ -29,7 +28,15 @@ public:
 	std::tuple<unsigned int, unsigned int> getCurrentTime();
 
 private:
-	std::shared_ptr<Timer> timer;
+	/**
+	 * Reads the time. Returns the number of milliseconds until the next
+	 * minute boundary.
+	 */
+	unsigned int update();
+
+	TimerScheduler &timers;
+	TimerScheduler::TimerId timer;
+	unsigned int hours, minutes;
 };
 
 #endif /* __CLOCK_H__ */
@@ -72,11 +72,11 @@ ContextMenu::ContextMenu(GMenu2X &gmenu2x, Menu &menu)
 
 #ifndef HAVE_LIBOPK
 	options.push_back(std::make_shared<MenuOption>(
-			tr["Add section"],
+			std::string(tr["Add section"]),
 			std::bind(&GMenu2X::addSection, &gmenu2x)));
 	if (menu.sectionLinks()->empty()) {
 		options.push_back(std::make_shared<MenuOption>(
-				tr["Delete section"],
+				std::string(tr["Delete section"]),
 				std::bind(&GMenu2X::deleteSection, &gmenu2x)));
 	}
 #endif
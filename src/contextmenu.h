@@ -21,6 +21,7 @@ public:
 
 	// Layer implementation:
 	virtual bool runAnimations();
+	virtual bool isModal() const { return true; }
 	virtual void paint(Surface &s);
 	virtual bool handleButtonPress(InputManager::Button button);
 
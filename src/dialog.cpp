@@ -25,14 +25,14 @@ void Dialog::drawTitleIcon(Surface& s, const std::string &icon, bool skinRes)
 	i->blit(s, 4, (gmenu2x.skinConfInt["topBarHeight"] - 32) / 2);
 }
 
-void Dialog::writeTitle(Surface& s, const std::string &title)
+void Dialog::writeTitle(Surface& s, compat::string_view title)
 {
 	gmenu2x.font->write(s, title, 40, 0, Font::HAlignLeft, Font::VAlignTop);
 }
 
-void Dialog::writeSubTitle(Surface& s, const std::string &subtitle)
+void Dialog::writeSubTitle(Surface& s, compat::string_view subtitle)
 {
-	std::string wrapped = wordWrap(*gmenu2x.font, subtitle, gmenu2x.width() - 48);
+	std::string wrapped = wordWrap(*gmenu2x.font, std::string(subtitle), gmenu2x.width() - 48);
 	gmenu2x.font->write(s, wrapped, 40,
 			gmenu2x.skinConfInt["topBarHeight"]
 				- gmenu2x.font->getTextHeight(wrapped),
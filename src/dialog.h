@@ -1,6 +1,8 @@
 #ifndef __DIALOG_H__
 #define __DIALOG_H__
 
+#include "compat-string_view.h"
+
 #include <string>
 
 class GMenu2X;
@@ -13,8 +15,8 @@ public:
 
 protected:
 	void drawTitleIcon(Surface& s, const std::string &icon, bool skinRes = false);
-	void writeTitle(Surface& s, const std::string &title);
-	void writeSubTitle(Surface& s, const std::string &subtitle);
+	void writeTitle(Surface& s, compat::string_view title);
+	void writeSubTitle(Surface& s, compat::string_view subtitle);
 
 	GMenu2X& gmenu2x;
 };
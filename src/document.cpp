@@ -0,0 +1,186 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#include "document.h"
+
+#include "debug.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef HAVE_LIBOPK
+#include <opk.h>
+#endif
+
+using namespace std;
+
+shared_ptr<Document> Document::open(const string &path)
+{
+#ifdef HAVE_LIBOPK
+	auto pos = path.find('#');
+	if (pos != path.npos) {
+		struct OPK *opk = opk_open(path.substr(0, pos).c_str());
+		if (!opk) {
+			WARNING("Unable to open OPK '%s'\n", path.substr(0, pos).c_str());
+			return make_shared<Document>("<error opening " + path + ">");
+		}
+
+		void *buf;
+		size_t len;
+		int err = opk_extract_file(opk, path.substr(pos + 1).c_str(), &buf, &len);
+		opk_close(opk);
+		if (err < 0) {
+			WARNING("Unable to extract '%s'\n", path.c_str());
+			return make_shared<Document>("<error reading " + path + ">");
+		}
+		string text(static_cast<char *>(buf), len);
+		free(buf);
+		return make_shared<Document>(std::move(text));
+	}
+#endif
+
+	int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return make_shared<Document>("<error opening " + path + ">");
+
+	shared_ptr<Document> doc(new Document());
+	struct stat st;
+	if (fstat(fd, &st) < 0) {
+		doc.reset(new Document("<error reading " + path + ">"));
+	} else if (st.st_size > 0) {
+		doc->mapping = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (doc->mapping == MAP_FAILED) {
+			doc.reset(new Document("<error reading " + path + ">"));
+		} else {
+			doc->data = static_cast<const char *>(doc->mapping);
+			doc->length = st.st_size;
+		}
+	}
+	close(fd);
+	return doc;
+}
+
+shared_ptr<Document> Document::readTail(const string &path, size_t maxLength)
+{
+	int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return make_shared<Document>("<error opening " + path + ">");
+
+	struct stat st;
+	if (fstat(fd, &st) < 0) {
+		close(fd);
+		return make_shared<Document>("<error reading " + path + ">");
+	}
+
+	const size_t size = st.st_size;
+	const size_t offset = size > maxLength ? size - maxLength : 0;
+	string text(size - offset, '\0');
+	size_t done = 0;
+	while (done < text.size()) {
+		ssize_t n = pread(fd, &text[done], text.size() - done, offset + done);
+		if (n <= 0) {
+			if (n < 0 && errno == EINTR)
+				continue;
+			// The file may have been truncated meanwhile.
+			break;
+		}
+		done += n;
+	}
+	close(fd);
+	text.resize(done);
+
+	if (offset) {
+		DEBUG("Showing the last %zu of %zu bytes of '%s'\n",
+				done, size, path.c_str());
+		// Drop the partial first line.
+		const size_t newline = text.find('\n');
+		text.replace(0, newline == string::npos ? 0 : newline + 1, "[...]\n");
+	}
+	return make_shared<Document>(std::move(text));
+}
+
+Document::Document()
+	: mapping(MAP_FAILED)
+	, data(nullptr)
+	, length(0)
+	, indexed(false)
+{
+}
+
+Document::Document(string text)
+	: storage(std::move(text))
+	, mapping(MAP_FAILED)
+	, data(storage.data())
+	, length(storage.size())
+	, indexed(false)
+{
+}
+
+Document::~Document()
+{
+	if (mapping != MAP_FAILED)
+		munmap(mapping, length);
+}
+
+void Document::indexLines(size_t n)
+{
+	if (lineStarts.empty() && !indexed) {
+		if (length == 0) {
+			indexed = true;
+			return;
+		}
+		lineStarts.push_back(0);
+	}
+
+	while (!indexed && lineStarts.size() <= n) {
+		const size_t start = lineStarts.back();
+		auto newline = static_cast<const char *>(
+				memchr(data + start, '\n', length - start));
+		if (!newline || size_t(newline + 1 - data) == length) {
+			indexed = true;
+		} else {
+			lineStarts.push_back(newline + 1 - data);
+		}
+	}
+}
+
+size_t Document::lineCount()
+{
+	indexLines(~size_t(0) - 1);
+	return lineStarts.size();
+}
+
+bool Document::hasLine(size_t n)
+{
+	indexLines(n);
+	return n < lineStarts.size();
+}
+
+size_t Document::lineEnd(size_t n)
+{
+	indexLines(n + 1);
+	if (n + 1 < lineStarts.size())
+		return lineStarts[n + 1] - 1;
+	if (length && data[length - 1] == '\n')
+		return length - 1;
+	return length;
+}
+
+compat::string_view Document::line(size_t n)
+{
+	return lines(n, n);
+}
+
+compat::string_view Document::lines(size_t first, size_t last)
+{
+	indexLines(last + 1);
+	if (first > last || first >= lineStarts.size())
+		return {};
+	const size_t start = lineStarts[first];
+	return { data + start, lineEnd(min(last, lineStarts.size() - 1)) - start };
+}
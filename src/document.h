@@ -0,0 +1,84 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#ifndef DOCUMENT_H
+#define DOCUMENT_H
+
+#include "compat-string_view.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Read-only text shared by the text viewers.
+ *
+ * Files are memory mapped instead of read, so opening a document costs the
+ * same regardless of its size and only the pages that are looked at take up
+ * memory. Lines are indexed on demand, as far as they are asked for.
+ *
+ * Accessing a mapped file that was truncated after it was opened raises
+ * SIGBUS, so only static files should be opened this way; files that are
+ * written to while they are shown, like the log, should be opened with
+ * readTail() instead.
+ *
+ * Lines are separated by '\n'; a final '\n' ends the last line instead of
+ * starting an empty one.
+ */
+class Document {
+public:
+	/**
+	 * Maps the given file, which can be a "file.opk#path" reference to a
+	 * file inside an OPK. Like readFileAsString(), this never fails: on
+	 * errors, the document contains the error message instead.
+	 */
+	static std::shared_ptr<Document> open(const std::string &path);
+
+	/**
+	 * Reads at most the last maxLength bytes of the given file, starting at
+	 * a line boundary, so that opening a huge file stays cheap. A document
+	 * that was cut short starts with a "[...]" line. This never fails
+	 * either.
+	 */
+	static std::shared_ptr<Document> readTail(
+			const std::string &path, size_t maxLength);
+
+	explicit Document(std::string text);
+	~Document();
+
+	Document(const Document&) = delete;
+	Document& operator=(const Document&) = delete;
+
+	compat::string_view text() const { return { data, length }; }
+
+	/** Returns the number of lines, which indexes the whole document. */
+	size_t lineCount();
+
+	/** Returns whether there is a line n, indexing only up to that line. */
+	bool hasLine(size_t n);
+
+	/** Returns the given line without its line separator, or an empty
+	  * view past the last line. */
+	compat::string_view line(size_t n);
+
+	/** Returns the text from the start of the first line to the end of the
+	  * last line of the given range, without the final line separator. */
+	compat::string_view lines(size_t first, size_t last);
+
+private:
+	Document();
+
+	/** Extends the line index to the first n + 1 lines, if there are. */
+	void indexLines(size_t n);
+	size_t lineEnd(size_t n);
+
+	std::string storage;
+	void *mapping;
+	const char *data;
+	size_t length;
+
+	std::vector<size_t> lineStarts;
+	bool indexed;
+};
+
+#endif // DOCUMENT_H
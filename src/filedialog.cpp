@@ -40,11 +40,6 @@ FileDialog::FileDialog(
 	setPath(path);
 }
 
-bool FileDialog::exec() {
-	bool ret = BrowseDialog::exec();
-	if (ret && fl.isDirectory(selected)) {
-		// FileDialog must only pick regular files.
-		ret = false;
-	}
-	return ret;
+bool FileDialog::canConfirm() {
+	return selected < fl.size() && fl.isFile(selected);
 }
@@ -29,7 +29,10 @@ public:
 			GMenu2X& gmenu2x, const std::string &text,
 			const std::string &filter="*", const std::string &file="",
 			const std::string &title = "File Dialog");
-	bool exec();
+
+protected:
+	// FileDialog must only pick regular files.
+	virtual bool canConfirm();
 };
 
 #endif // FILEDIALOG_H
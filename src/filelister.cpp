@@ -31,6 +31,7 @@
 #include <errno.h>
 #include <iostream>
 #include <algorithm>
+#include <cctype>
 #include <cstring>
 #include <set>
 
@@ -69,6 +70,7 @@ bool FileLister::browse(const string& path, bool clean)
 	if (clean) {
 		directories.clear();
 		files.clear();
+		groups.clear();
 	}
 
 	string slashedPath = path;
@@ -162,9 +164,43 @@ bool FileLister::browse(const string& path, bool clean)
 		moveNames(move(fileSet), files);
 	}
 
+	indexGroups();
 	return true;
 }
 
+static char firstLetter(const string& name)
+{
+	return name.empty() ? '\0' : tolower(static_cast<unsigned char>(name[0]));
+}
+
+void FileLister::indexGroups()
+{
+	groups.clear();
+	for (size_t i = 0; i < directories.size(); i++) {
+		if (i == 0 || firstLetter(directories[i]) != firstLetter(directories[i - 1]))
+			groups.push_back(i);
+	}
+	const auto dirCount = directories.size();
+	for (size_t i = 0; i < files.size(); i++) {
+		if (i == 0 || firstLetter(files[i]) != firstLetter(files[i - 1]))
+			groups.push_back(dirCount + i);
+	}
+}
+
+size_t FileLister::nextGroup(size_t x) const
+{
+	auto it = upper_bound(groups.begin(), groups.end(), x);
+	return it == groups.end() ? 0 : *it;
+}
+
+size_t FileLister::prevGroup(size_t x) const
+{
+	if (groups.empty())
+		return 0;
+	auto it = lower_bound(groups.begin(), groups.end(), x);
+	return it == groups.begin() ? groups.back() : *--it;
+}
+
 string FileLister::operator[](size_t x)
 {
 	const auto dirCount = directories.size();
@@ -30,6 +30,10 @@ private:
 	bool showDirectories, showUpdir, showFiles;
 
 	std::vector<std::string> directories, files;
+	/** Indices where a new first letter starts, see nextGroup() and prevGroup(). */
+	std::vector<size_t> groups;
+
+	void indexGroups();
 
 public:
 	FileLister();
@@ -50,6 +54,21 @@ public:
 	bool isFile(size_t x) const { return x >= directories.size(); }
 	bool isDirectory(size_t x) const { return x < directories.size(); }
 
+	/**
+	 * Returns the index of the first entry after the given one whose name
+	 * starts with a different letter, wrapping around to 0 at the end.
+	 * Directories and files are indexed separately, so the first file
+	 * starts a group of its own.
+	 */
+	size_t nextGroup(size_t x) const;
+
+	/**
+	 * Returns the index of the last group start before the given entry,
+	 * wrapping around to the last group at the start. This undoes
+	 * nextGroup().
+	 */
+	size_t prevGroup(size_t x) const;
+
 	void setFilter(const std::string &filter);
 
 	void setShowDirectories(bool enabled) { showDirectories = enabled; }
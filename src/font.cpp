@@ -15,7 +15,10 @@
 Font::Font(Font &&other) noexcept
     : font(other.font),
       lineSpacing(other.lineSpacing),
-      spec_(std::move(other.spec_)) {
+      kerning(other.kerning),
+      spec_(std::move(other.spec_)),
+      latin1Advances(other.latin1Advances),
+      advances(std::move(other.advances)) {
 	other.font = nullptr;
 }
 
@@ -27,7 +30,10 @@ Font &Font::operator=(Font &&other) noexcept {
 	font = other.font;
 	other.font = nullptr;
 	lineSpacing = other.lineSpacing;
+	kerning = other.kerning;
 	spec_ = std::move(other.spec_);
+	latin1Advances = other.latin1Advances;
+	advances = std::move(other.advances);
 	return *this;
 }
 
@@ -48,13 +54,60 @@ bool Font::Load(FontSpec spec)
 	} else {
 		WARNING("Unable to open font '%s'\n", spec_.path.c_str());
 		SDL_ClearError();
+		TTF_Quit();
 		return false;
 	}
 
 	lineSpacing = TTF_FontLineSkip(font);
+	kerning = TTF_GetFontKerning(font) != 0;
+	latin1Advances.fill(-1);
+	advances.clear();
 	return true;
 }
 
+int Font::getAdvance(char32_t code_point) const
+{
+	if (code_point < latin1Advances.size()
+			&& latin1Advances[code_point] >= 0)
+		return latin1Advances[code_point];
+	if (code_point >= latin1Advances.size()) {
+		auto it = advances.find(code_point);
+		if (it != advances.end())
+			return it->second;
+	}
+
+	int advance = 0;
+	if (font) {
+#if SDL_TTF_VERSION_ATLEAST(2, 0, 18)
+		TTF_GlyphMetrics32(font, code_point,
+				nullptr, nullptr, nullptr, nullptr, &advance);
+#else
+		if (code_point <= 0xFFFF)
+			TTF_GlyphMetrics(font, code_point,
+					nullptr, nullptr, nullptr, nullptr, &advance);
+#endif
+	}
+
+	if (code_point < latin1Advances.size())
+		latin1Advances[code_point] = advance;
+	else
+		advances[code_point] = advance;
+	return advance;
+}
+
+int Font::getKerning(char32_t previous, char32_t code_point) const
+{
+	if (!kerning || !font || !previous)
+		return 0;
+#if SDL_TTF_VERSION_ATLEAST(2, 0, 18)
+	return TTF_GetFontKerningSizeGlyphs32(font, previous, code_point);
+#else
+	if (previous > 0xFFFF || code_point > 0xFFFF)
+		return 0;
+	return TTF_GetFontKerningSizeGlyphs(font, previous, code_point);
+#endif
+}
+
 Font::~Font()
 {
 	if (font) {
@@ -63,7 +116,7 @@ Font::~Font()
 	}
 }
 
-int Font::writeLine(Surface& surface, const std::uint16_t *text, int x, int y,
+int Font::writeLine(Surface& surface, const char *text, int x, int y,
                     HAlign halign, VAlign valign) const {
 	if (*text == 0) {
 		// SDL_ttf will return a nullptr when rendering the empty string.
@@ -82,7 +135,7 @@ int Font::writeLine(Surface& surface, const std::uint16_t *text, int x, int y,
 	}
 
 	SDL_Color color = { 0, 0, 0, 0 };
-	SDL_Surface *s = TTF_RenderUNICODE_Blended(font, text, color);
+	SDL_Surface *s = TTF_RenderUTF8_Blended(font, text, color);
 	if (!s) {
 		ERROR("Font rendering failed: %s\n", SDL_GetError());
 		SDL_ClearError();
@@ -136,7 +189,7 @@ int Font::writeLine(Surface& surface, const std::uint16_t *text, int x, int y,
 	color.g = 0xff;
 	color.b = 0xff;
 
-	s = TTF_RenderUNICODE_Blended(font, text, color);
+	s = TTF_RenderUTF8_Blended(font, text, color);
 	if (!s) {
 		ERROR("Font rendering failed: %s\n", SDL_GetError());
 		SDL_ClearError();
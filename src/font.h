@@ -4,14 +4,20 @@
 #ifndef FONT_H
 #define FONT_H
 
+#include <array>
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <unordered_map>
 
 #include <SDL2/SDL_ttf.h>
 
 #include "font_spec.h"
 
+#ifndef SDL_TTF_VERSION_ATLEAST
+#define SDL_TTF_VERSION_ATLEAST(X, Y, Z) 0
+#endif
+
 class FontStack;
 class OffscreenSurface;
 class Surface;
@@ -44,26 +50,48 @@ public:
 		return lineSpacing;
 	}
 
-	bool HasGlyph(std::uint16_t code_point) const {
-		return TTF_GlyphIsProvided(font, code_point);
+	bool HasGlyph(char32_t code_point) const {
+#if SDL_TTF_VERSION_ATLEAST(2, 0, 18)
+		return TTF_GlyphIsProvided32(font, code_point);
+#else
+		return code_point <= 0xFFFF && TTF_GlyphIsProvided(font, code_point);
+#endif
 	}
 
 	const FontSpec& spec() const { return spec_; }
 
+	/**
+	 * Returns the horizontal advance of the glyph for a code point in pixels.
+	 * Advances are cached, so this is cheap to call for every character.
+	 */
+	int getAdvance(char32_t code_point) const;
+
+	/**
+	 * Returns the kerning adjustment between two consecutive code points,
+	 * or 0 if kerning is disabled for this font.
+	 */
+	int getKerning(char32_t previous, char32_t code_point) const;
+
 private:
 	Font(TTF_Font *font);
 
 	/**
-	 * Draws a single line of text on a surface in this font.
+	 * Draws a single line of zero-terminated UTF-8 text on a surface in this
+	 * font.
 	 * @return The width of the text in pixels.
 	 */
-	int writeLine(Surface& surface, const std::uint16_t *text, int x, int y,
+	int writeLine(Surface& surface, const char *text, int x, int y,
 	              HAlign halign, VAlign valign) const;
 
 	TTF_Font *font;
 	int lineSpacing;
+	bool kerning;
 	FontSpec spec_;
 
+	/** Advances of Latin-1 code points; -1 where not looked up yet. */
+	mutable std::array<std::int16_t, 256> latin1Advances;
+	mutable std::unordered_map<char32_t, int> advances;
+
 	friend class FontStack;
 };
 
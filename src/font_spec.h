@@ -4,6 +4,16 @@
 #include <cstddef>
 #include <string>
 
+// The font used when the skin does not specify one.
+#define DEFAULT_FONT_PATH "/usr/share/fonts/truetype/dejavu/DejaVuSansCondensed.ttf"
+#define DEFAULT_FONT_SIZE 12
+
+// Fonts for the code points that the skin font lacks, as a list of
+// `,{path,size}` initializers to append to the skin font.
+#ifndef DEFAULT_FALLBACK_FONTS
+#define DEFAULT_FALLBACK_FONTS ,{"/usr/share/fonts/truetype/droid/DroidSansFallbackFull.ttf",13},{"/usr/share/fonts/truetype/droid/DroidSansFallback.ttf",13}
+#endif
+
 struct FontSpec {
 	std::string path;
 	unsigned int size;
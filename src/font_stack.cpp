@@ -1,41 +1,43 @@
 #include "font_stack.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstring>
 #include <iterator>
+#include <memory>
 #include <type_traits>
 #include <unordered_map>
 
 #include "debug.h"
 #include "split_by_char.h"
 #include "surface.h"
+#include "utf8.h"
 
 namespace {
 
-// Decodes UTF-8 into a 0-terminated vector of code points.
-// Only supports BMP as that's what SDL_ttf supports.
-std::vector<std::uint16_t> DecodeUtf8(compat::string_view utf8) {
-	std::vector<std::uint16_t> result;
-	for (std::size_t i = 0; i < utf8.size(); ++i) {
-		std::uint16_t ch = static_cast<unsigned char>(utf8[i]);
-		if (ch >= 0xF0) {
-			ch = static_cast<std::uint16_t>(utf8[i] & 0x07) << 18;
-			ch |= static_cast<std::uint16_t>(utf8[++i] & 0x3F) << 12;
-			ch |= static_cast<std::uint16_t>(utf8[++i] & 0x3F) << 6;
-			ch |= static_cast<std::uint16_t>(utf8[++i] & 0x3F);
-		} else if (ch >= 0xE0) {
-			ch = static_cast<std::uint16_t>(utf8[i] & 0x0F) << 12;
-			ch |= static_cast<std::uint16_t>(utf8[++i] & 0x3F) << 6;
-			ch |= static_cast<std::uint16_t>(utf8[++i] & 0x3F);
-		} else if (ch >= 0xC0) {
-			ch = static_cast<std::uint16_t>(utf8[i] & 0x1F) << 6;
-			ch |= static_cast<std::uint16_t>(utf8[++i] & 0x3F);
+// A zero-terminated copy of a line of text. Typical labels fit in the
+// inline buffer, so no heap allocation is needed for them.
+class ZeroTerminatedCopy {
+ public:
+	explicit ZeroTerminatedCopy(compat::string_view text) {
+		if (text.size() >= sizeof(inline_)) {
+			heap_.reset(new char[text.size() + 1]);
+			data_ = heap_.get();
 		}
-		result.push_back(ch);
+		std::memcpy(data_, text.data(), text.size());
+		data_[text.size()] = 0;
+		size_ = text.size();
 	}
-	result.push_back(0);
-	return result;
-}
+
+	compat::string_view view() const { return {data_, size_}; }
+
+ private:
+	char inline_[256];
+	std::unique_ptr<char[]> heap_;
+	char *data_ = inline_;
+	std::size_t size_;
+};
 
 bool FontSpecsEq(const std::vector<Font> &fonts,
                  const std::vector<FontSpec> &specs) {
@@ -45,19 +47,6 @@ bool FontSpecsEq(const std::vector<Font> &fonts,
 	return true;
 }
 
-template <std::size_t N>
-void BuildCodePointToFontMap(const std::vector<Font> &fonts,
-                             std::array<const Font *, N> *map) {
-	for (std::size_t cp = 0; cp < N; ++cp) {
-		(*map)[cp] = &fonts[0];
-		for (const auto &font : fonts) {
-			if (!font.HasGlyph(cp)) continue;
-			(*map)[cp] = &font;
-			break;
-		}
-	}
-}
-
 std::uint8_t *get_pixel8(const SDL_Surface *s, int row, int col) {
 	const std::uintptr_t row_addr =
 	    reinterpret_cast<std::uintptr_t>(s->pixels) + row * s->pitch;
@@ -134,6 +123,10 @@ SDL_Surface *drawOutline(const SDL_Surface *s) {
 }  // namespace
 
 bool FontStack::LoadFonts(std::initializer_list<FontSpec> specs) {
+	return LoadFonts(std::vector<FontSpec>(specs));
+}
+
+bool FontStack::LoadFonts(const std::vector<FontSpec> &specs) {
 	// Build a map of fonts that we currently have.
 	std::unordered_map<FontSpec, Font *> existing_fonts;
 	existing_fonts.reserve(fonts_.size());
@@ -172,75 +165,128 @@ bool FontStack::LoadFonts(std::initializer_list<FontSpec> specs) {
 	}
 	fonts_ = std::move(fonts);
 
-	BuildCodePointToFontMap(fonts_, &code_point_to_font_);
+	blocks_.clear();
+	block_index_.clear();
+	if (fonts_.size() > 1) block_index_.assign(kBlockCount, kUnresolvedBlock);
+	ascii_font_ = FontFor(0);
+	for (char32_t cp = 1; cp < 0x80; ++cp) {
+		if (FontFor(cp) != ascii_font_) {
+			ascii_font_ = nullptr;
+			break;
+		}
+	}
 
 	return true;
 }
 
-void FontStack::ForEachSlice(
-    const std::vector<std::uint16_t> &code_points,
-    std::function<void(const FontStack::Slice &slice)> fn) const {
-	if (code_points[0] == 0) return;
+const Font *FontStack::FontFor(char32_t code_point) const {
+	if (fonts_.size() == 1 || code_point > kMaxCodePoint) return &fonts_[0];
+	std::uint16_t &entry = block_index_[code_point >> kBlockBits];
+	if (entry == kUnresolvedBlock) entry = ResolveBlock(code_point >> kBlockBits);
+	if (entry == kPrimaryBlock) return &fonts_[0];
+	return &fonts_[blocks_[entry - 2][code_point & (kBlockSize - 1)]];
+}
+
+std::uint16_t FontStack::ResolveBlock(std::size_t block) const {
+	// Font indices are stored in a byte; further fonts are never used.
+	const std::size_t font_count = std::min<std::size_t>(fonts_.size(), 256);
+	const char32_t first = static_cast<char32_t>(block << kBlockBits);
+	std::array<std::uint8_t, kBlockSize> map;
+	bool primary = true;
+	for (std::size_t i = 0; i < kBlockSize; ++i) {
+		map[i] = 0;
+		for (std::size_t f = 0; f < font_count; ++f) {
+			if (!fonts_[f].HasGlyph(first + i)) continue;
+			map[i] = static_cast<std::uint8_t>(f);
+			break;
+		}
+		if (map[i] != 0) primary = false;
+	}
+	if (primary) return kPrimaryBlock;
+	blocks_.push_back(map);
+	return static_cast<std::uint16_t>(blocks_.size() + 1);
+}
+
+template <typename Fn>
+void FontStack::ForEachSlice(compat::string_view text, Fn &&fn) const {
+	if (text.empty()) return;
 	if (fonts_.size() == 1) {
-		fn(Slice{code_points.data(), code_points.size() - 1, &fonts_[0]});
+		fn(Slice{text.data(), text.size(), &fonts_[0]});
 		return;
 	}
-	const Font *prev_font = code_point_to_font_[code_points[0]];
-	Slice cur_slice{code_points.data(), 1, prev_font};
-	for (std::size_t i = 1; i < code_points.size(); ++i) {
-		auto &cp = code_points[i];
-		if (cp == 0) break;
-		const Font *cur_font = code_point_to_font_[cp];
-		if (cur_font == prev_font) {
-			++cur_slice.text_size;
+	const Font *slice_font = nullptr;
+	std::size_t slice_start = 0, pos = 0;
+	while (pos < text.size()) {
+		const Font *font;
+		std::size_t next = pos;
+		const std::size_t ascii =
+		    ascii_font_ != nullptr ? AsciiPrefixLength(text.substr(pos)) : 0;
+		if (ascii != 0) {
+			font = ascii_font_;
+			next += ascii;
 		} else {
-			fn(cur_slice);
-			cur_slice = Slice{&cp, 1, cur_font};
-			prev_font = cur_font;
+			font = FontFor(DecodeUtf8(text, &next));
 		}
+		if (font != slice_font) {
+			if (slice_font != nullptr)
+				fn(Slice{text.data() + slice_start, pos - slice_start, slice_font});
+			slice_font = font;
+			slice_start = pos;
+		}
+		pos = next;
 	}
-	fn(cur_slice);
+	fn(Slice{text.data() + slice_start, pos - slice_start, slice_font});
 }
 
-void FontStack::ForEachSliceZeroTerminated(
-    std::vector<std::uint16_t> &code_points,
-    std::function<void(const Slice &slice)> fn) const {
-	ForEachSlice(code_points, [&fn](const Slice &slice) {
-		// Safe cast, slice.text points to an offset of `code_points`.
-		auto &end = const_cast<std::uint16_t *>(slice.text)[slice.text_size];
-		const std::uint16_t cp = end;
+template <typename Fn>
+void FontStack::ForEachSliceZeroTerminated(compat::string_view text,
+                                           Fn &&fn) const {
+	ZeroTerminatedCopy copy(text);
+	ForEachSlice(copy.view(), [&fn](const Slice &slice) {
+		// Safe cast, slice.text points to an offset of `copy`.
+		auto &end = const_cast<char *>(slice.text)[slice.text_size];
+		const char c = end;
 		end = 0;
 		fn(slice);
-		end = cp;
+		end = c;
 	});
 }
-void FontStack::ForEachSlice(
-    compat::string_view text,
-    std::function<void(const FontStack::Slice &slice)> fn) const {
-	auto code_points = DecodeUtf8(text);
-	ForEachSlice(code_points, std::move(fn));
-}
-
-void FontStack::ForEachSliceZeroTerminated(
-    compat::string_view text,
-    std::function<void(const FontStack::Slice &slice)> fn) const {
-	auto code_points = DecodeUtf8(text);
-	ForEachSliceZeroTerminated(code_points, std::move(fn));
-}
 
 int FontStack::getTextWidth(compat::string_view text) const {
 	std::size_t start = 0;
 	int max_width = 0;
 	for (compat::string_view line : SplitByChar(text, '\n')) {
-		ForEachSliceZeroTerminated(line, [&max_width](const Slice &slice) {
+		int line_width = 0;
+		ForEachSliceZeroTerminated(line, [&line_width](const Slice &slice) {
 			int w;
-			TTF_SizeUNICODE(slice.font->font, slice.text, &w, nullptr);
-			max_width = std::max(max_width, w);
+			TTF_SizeUTF8(slice.font->font, slice.text, &w, nullptr);
+			line_width += w;
 		});
+		max_width = std::max(max_width, line_width);
 	}
 	return max_width;
 }
 
+std::unique_ptr<FontStack> FontStack::duplicate() const {
+	std::vector<FontSpec> specs;
+	specs.reserve(fonts_.size());
+	for (const auto &font : fonts_) specs.push_back(font.spec());
+	std::unique_ptr<FontStack> copy(new FontStack());
+	copy->LoadFonts(specs);
+	return copy;
+}
+
+std::size_t FontStack::getFittingLength(compat::string_view text,
+                                        int max_width) const {
+	std::size_t fitting = 0;
+	forEachPrefixWidth(text, [&](char32_t, std::size_t end, int width) {
+		if (width > max_width) return false;
+		fitting = end;
+		return true;
+	});
+	return fitting;
+}
+
 int FontStack::getTextHeight(compat::string_view text) const {
 	std::size_t start = 0;
 	int height = 0;
@@ -273,13 +319,21 @@ int FontStack::write(Surface &surface, compat::string_view text, int x, int y,
 
 std::shared_ptr<OffscreenSurface> FontStack::render(
     compat::string_view text) const {
+	SDL_Surface *raw = rasterize(text);
+	if (raw == nullptr) return std::shared_ptr<OffscreenSurface>();
+	auto surface = OffscreenSurface::fromSurface(raw);
+	SDL_FreeSurface(raw);
+	return surface;
+}
+
+SDL_Surface *FontStack::rasterize(compat::string_view text) const {
 	std::vector<SDL_Surface *> surfaces;
 	int width = 0, height = 0;
 	ForEachSliceZeroTerminated(text, [&](const Slice &slice) {
-		SDL_Surface *s = TTF_RenderUNICODE_Shaded(slice.font->font, slice.text,
-		                                          SDL_Color{}, SDL_Color{});
+		SDL_Surface *s = TTF_RenderUTF8_Shaded(slice.font->font, slice.text,
+		                                       SDL_Color{}, SDL_Color{});
 		if (s == nullptr) {
-			ERROR("TTF_RenderUNICODE_Shaded: %s\n", SDL_GetError());
+			ERROR("TTF_RenderUTF8_Shaded: %s\n", SDL_GetError());
 			SDL_ClearError();
 			return;
 		}
@@ -287,7 +341,7 @@ std::shared_ptr<OffscreenSurface> FontStack::render(
 		width += s->w;
 		height = std::max(height, s->h);
 	});
-	if (surfaces.empty()) return std::shared_ptr<OffscreenSurface>();
+	if (surfaces.empty()) return nullptr;
 
 	SDL_Surface *concatenated;
 	if (surfaces.size() == 1) {
@@ -310,5 +364,5 @@ std::shared_ptr<OffscreenSurface> FontStack::render(
 
 	SDL_Surface *result = drawOutline(concatenated);
 	SDL_FreeSurface(concatenated);
-	return std::shared_ptr<OffscreenSurface>(new OffscreenSurface(result));
+	return result;
 }
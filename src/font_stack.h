@@ -2,15 +2,16 @@
 #define _FONT_STACK_H_
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
-#include <functional>
 #include <initializer_list>
-#include <limits>
+#include <memory>
 #include <vector>
 
 #include "compat-string_view.h"
 #include "font.h"
 #include "font_spec.h"
+#include "utf8.h"
 
 class OffscreenSurface;
 
@@ -18,6 +19,11 @@ class FontStack {
  public:
 	// Returns true if any of the fonts have changed.
 	bool LoadFonts(std::initializer_list<FontSpec> specs);
+	bool LoadFonts(const std::vector<FontSpec> &specs);
+
+	// Returns a stack of the same fonts with their own font handles, which
+	// can be used from another thread. Must be called from the main thread.
+	std::unique_ptr<FontStack> duplicate() const;
 
 	int getTextWidth(compat::string_view text) const;
 	int getTextHeight(compat::string_view text) const;
@@ -29,41 +35,84 @@ class FontStack {
 
 	std::shared_ptr<OffscreenSurface> render(compat::string_view text) const;
 
+	// Renders `text` into a new software surface, which the caller must free.
+	// Unlike `render`, this does not use the renderer, so it can be called
+	// from another thread, on a stack returned by `duplicate`.
+	SDL_Surface *rasterize(compat::string_view text) const;
+
+	// Calls `fn(code_point, end, width)` for each code point of the single
+	// line `text`, where `end` is the offset just past the code point and
+	// `width` the width of `text.substr(0, end)`. Widths are computed from
+	// cached glyph advances and kerning, so a whole line costs one pass.
+	// Iteration stops early if `fn` returns false.
+	template <typename Fn>
+	void forEachPrefixWidth(compat::string_view text, Fn &&fn) const {
+		int width = 0;
+		char32_t previous = 0;
+		const Font *previous_font = nullptr;
+		for (std::size_t pos = 0; pos < text.size();) {
+			const char32_t code_point = DecodeUtf8(text, &pos);
+			const Font *font = FontFor(code_point);
+			if (font == previous_font)
+				width += font->getKerning(previous, code_point);
+			width += font->getAdvance(code_point);
+			previous = code_point;
+			previous_font = font;
+			if (!fn(code_point, pos, width)) return;
+		}
+	}
+
+	// Returns the length in bytes of the longest prefix of the single line
+	// `text` that is at most `max_width` pixels wide.
+	std::size_t getFittingLength(compat::string_view text, int max_width) const;
+
  private:
 	struct Slice {
-		const std::uint16_t *text;
-		std::size_t text_size;
+		// UTF-8 text, pointing into the string passed to `ForEachSlice`.
+		const char *text;
+		std::size_t text_size;  // in bytes
 		const Font *font;
 	};
 
 	// Calls the given function for each span of same-font code points.
-	void ForEachSlice(const std::vector<std::uint16_t> &code_points,
-	                  std::function<void(const Slice &slice)> fn) const;
-
-	// Same as above but accepts a string_view. Slices must not be captured.
-	void ForEachSlice(compat::string_view text,
-	                  std::function<void(const Slice &slice)> fn) const;
+	// Slices must not be captured.
+	template <typename Fn>
+	void ForEachSlice(compat::string_view text, Fn &&fn) const;
 
 	// Same as `ForEachSlice` but `slice.text[slice.text_size]` is guaranteed to
 	// be 0.
-	void ForEachSliceZeroTerminated(
-	    std::vector<std::uint16_t> &code_points,
-	    std::function<void(const Slice &slice)> fn) const;
+	template <typename Fn>
+	void ForEachSliceZeroTerminated(compat::string_view text, Fn &&fn) const;
+
+	// Returns the font that is used to draw the given code point.
+	const Font *FontFor(char32_t code_point) const;
 
-	// Same as above but accepts a string_view. Slices must not be captured.
-	void ForEachSliceZeroTerminated(
-	    compat::string_view text,
-	    std::function<void(const Slice &slice)> fn) const;
+	// Code points are mapped to fonts in blocks of `kBlockSize`, which are
+	// resolved on first use.
+	static constexpr std::size_t kBlockBits = 9;
+	static constexpr std::size_t kBlockSize = std::size_t{1} << kBlockBits;
+	static constexpr char32_t kMaxCodePoint = 0x10FFFF;
+	static constexpr std::size_t kBlockCount = (kMaxCodePoint + 1) >> kBlockBits;
+	static constexpr std::uint16_t kUnresolvedBlock = 0;
+	static constexpr std::uint16_t kPrimaryBlock = 1;
+
+	// Maps the given block and returns its entry for `block_index_`.
+	std::uint16_t ResolveBlock(std::size_t block) const;
 
 	// Fonts in the order of priority. Lower index means higher priority.
 	std::vector<Font> fonts_;
 
-	// A map from code point to the font that contains it.
-	// If no font contains a given code point, maps to the first font.
-	//
-	// Only covers BMP because SDL 1 does not support anything else.
-	std::array<const Font *, std::numeric_limits<std::uint16_t>::max() + 1>
-	    code_point_to_font_;
+	// For each block: `kUnresolvedBlock`, `kPrimaryBlock` if the first font
+	// draws all of it (including the code points no font contains), or 2 plus
+	// the index of its map in `blocks_`. Empty with a single font.
+	mutable std::vector<std::uint16_t> block_index_;
+
+	// Per code point of a block, the index in `fonts_` of its font.
+	mutable std::vector<std::array<std::uint8_t, kBlockSize>> blocks_;
+
+	// The font that all of ASCII maps to, or nullptr if ASCII is drawn with
+	// more than one font. Lets runs of ASCII skip the per-character lookup.
+	const Font *ascii_font_;
 
 	// The maximum of line spacings of all fonts.
 	int line_spacing_;
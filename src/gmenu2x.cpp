@@ -24,6 +24,7 @@
 #include "buildopts.h"
 #include "cpu.h"
 #include "debug.h"
+#include "document.h"
 #include "filedialog.h"
 #include "filelister.h"
 #include "font_stack.h"
@@ -46,9 +47,12 @@
 #include "menusettingrgba.h"
 #include "menusettingstring.h"
 #include "messagebox.h"
+#include "perfhud.h"
 #include "powersaver.h"
+#include "replay.h"
 #include "settingsdialog.h"
 #include "textdialog.h"
+#include "textrenderer.h"
 #include "wallpaperdialog.h"
 #include "utilities.h"
 
@@ -58,6 +62,7 @@
 #include <sstream>
 #include <fstream>
 #include <algorithm>
+#include <chrono>
 #include <system_error>
 
 #include <stdlib.h>
@@ -67,18 +72,12 @@
 #include <signal.h>
 
 #include <errno.h>
+#include <getopt.h>
 
 //for browsing the filesystem
 #include <sys/stat.h>
 #include <sys/types.h>
 
-#define DEFAULT_FONT_PATH "/usr/share/fonts/truetype/dejavu/DejaVuSansCondensed.ttf"
-#define DEFAULT_FONT_SIZE 12
-
-#ifndef DEFAULT_FALLBACK_FONTS
-#define DEFAULT_FALLBACK_FONTS ,{"/usr/share/fonts/truetype/droid/DroidSansFallbackFull.ttf",13},{"/usr/share/fonts/truetype/droid/DroidSansFallback.ttf",13}
-#endif
-
 using namespace std;
 
 static GMenu2X *app;
@@ -126,8 +125,8 @@ static void quit_all(int err) {
 
 static void update_battery(int err)
 {
+	// Wakes up the status sampler, which requests a repaint if needed.
 	app->bottomBar->updateBattery();
-	request_repaint();
 }
 
 const string GMenu2X::getHome()
@@ -144,7 +143,48 @@ static void set_handler(int signal, void (*handler)(int))
 	sigaction(signal, &sig, NULL);
 }
 
-int main(int /*argc*/, char * /*argv*/[]) {
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"Usage: %s [--replay SCRIPT --record FILE]\n"
+		"With --replay, the buttons are read from SCRIPT instead of the input\n"
+		"devices, SDL's dummy video driver is used unless SDL_VIDEODRIVER is\n"
+		"set, and the time and checksum of every frame are written to FILE\n"
+		"as JSON. See replay.h for the script format.\n",
+		argv0);
+}
+
+int main(int argc, char *argv[]) {
+	static const struct option options[] = {
+		{ "replay", required_argument, nullptr, 'r' },
+		{ "record", required_argument, nullptr, 'o' },
+		{ "help", no_argument, nullptr, 'h' },
+		{ nullptr, 0, nullptr, 0 },
+	};
+	const char *script = nullptr, *record = nullptr;
+	int opt;
+	while ((opt = getopt_long(argc, argv, "", options, nullptr)) != -1) {
+		switch (opt) {
+		case 'r': script = optarg; break;
+		case 'o': record = optarg; break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+	if (optind != argc || !script != !record) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	std::unique_ptr<Replay> replay;
+	if (script) {
+		replay = Replay::load(script, record);
+		if (!replay)
+			return EXIT_FAILURE;
+		setenv("SDL_VIDEODRIVER", "dummy", 0);
+	}
+
 	INFO("---- GMenu2X starting ----\n");
 
 	set_handler(SIGINT, &quit_all);
@@ -168,13 +208,11 @@ int main(int /*argc*/, char * /*argv*/[]) {
 
 	DEBUG("Home path: %s.\n", gmenu2x_home.c_str());
 
-	GMenu2X::run();
-
-	return EXIT_FAILURE;
+	return GMenu2X::run(std::move(replay));
 }
 
-void GMenu2X::run() {
-	auto menu = new GMenu2X();
+int GMenu2X::run(std::unique_ptr<Replay> replay) {
+	auto menu = new GMenu2X(replay.get());
 	app = menu;
 	DEBUG("Starting main()\n");
 	menu->mainLoop();
@@ -186,6 +224,13 @@ void GMenu2X::run() {
 	SDL_Quit();
 	unsetenv("SDL_FBCON_DONT_CLEAR");
 
+	if (replay) {
+		if (toLaunch)
+			INFO("Not launching anything during a replay\n");
+		delete toLaunch;
+		return replay->write() ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
 	if (toLaunch) {
 		toLaunch->exec();
 		// If control gets here, execution failed. Since we already destructed
@@ -193,13 +238,18 @@ void GMenu2X::run() {
 		// respawn the menu.
 		delete toLaunch;
 	}
+	return EXIT_FAILURE;
 }
 
-GMenu2X::GMenu2X() : input(*this), sc(this)
+GMenu2X::GMenu2X(Replay *replay) : input(*this), sc(this)
 {
 	useSelectionPng = false;
+	replaying = replay != nullptr;
+	quitting = false;
+	compositeDepth = 0;
 
 	powerSaver = PowerSaver::getInstance();
+	powerSaver->setTimerScheduler(&timers);
 	layout = std::make_unique<Layout>();
 	top = layout->topItem();
 
@@ -227,6 +277,12 @@ GMenu2X::GMenu2X() : input(*this), sc(this)
 		exit(EXIT_FAILURE);
 	}
 
+	if (replay) {
+		// Video drivers without displays, like the dummy one, do not list
+		// any of our resolutions, so take the one that the script asks for.
+		s = OutputSurface::open("GMenu2X",
+				replay->screenWidth(), replay->screenHeight(), 0);
+	} else
 #if defined(G2X_BUILD_OPTION_SCREEN_WIDTH) && defined(G2X_BUILD_OPTION_SCREEN_HEIGHT)
 	s = OutputSurface::open(G2X_BUILD_OPTION_SCREEN_WIDTH, G2X_BUILD_OPTION_SCREEN_HEIGHT, 0);
 #else
@@ -245,6 +301,13 @@ GMenu2X::GMenu2X() : input(*this), sc(this)
 
 	DEBUG("%ux%u main window created\n", width(), height());
 
+	if (replay) {
+		input.setReplay(replay);
+		s->setPresentHook([replay](OutputSurface &s) {
+			replay->framePresenting(s);
+		});
+	}
+
 	top->setSize(width(), height());
 	top->setContainer(LAY_FLEX | LAY_COLUMN);
 
@@ -302,6 +365,7 @@ GMenu2X::GMenu2X() : input(*this), sc(this)
 }
 
 GMenu2X::~GMenu2X() {
+	powerSaver->setTimerScheduler(nullptr);
 	fflush(NULL);
 	sc.clear();
 
@@ -348,7 +412,13 @@ bool GMenu2X::initFont() {
 	if (size == 0)
 		size = DEFAULT_FONT_SIZE;
 	if (font == nullptr) font = std::make_unique<FontStack>();
-	return font->LoadFonts({FontSpec{std::move(path), size} DEFAULT_FALLBACK_FONTS });
+	const bool changed = font->LoadFonts(
+			{FontSpec{std::move(path), size} DEFAULT_FALLBACK_FONTS });
+	if (textRenderer == nullptr)
+		textRenderer = std::make_unique<TextRenderer>(*font, replaying);
+	else if (changed)
+		textRenderer->fontChanged();
+	return changed;
 }
 
 void GMenu2X::initMenu() {
@@ -357,34 +427,34 @@ void GMenu2X::initMenu() {
 
 	// Add action links in the applications section.
 	auto appIdx = menu->sectionNamed("applications");
-	menu->addActionLink(appIdx, tr["Explorer"],
+	menu->addActionLink(appIdx, string(tr["Explorer"]),
 			bind(&GMenu2X::explorer, this),
-			tr["Launch an application"],
+			string(tr["Launch an application"]),
 			"skin:icons/explorer.png");
 
 	// Add action links in the settings section.
 	auto settingIdx = menu->sectionNamed("settings");
 	menu->addActionLink(settingIdx, "GMenu2X",
 			bind(&GMenu2X::showSettings, this),
-			tr["Configure GMenu2X's options"],
+			string(tr["Configure GMenu2X's options"]),
 			"skin:icons/configure.png");
-	menu->addActionLink(settingIdx, tr["Skin"],
+	menu->addActionLink(settingIdx, string(tr["Skin"]),
 			bind(&GMenu2X::skinMenu, this),
-			tr["Configure skin"],
+			string(tr["Configure skin"]),
 			"skin:icons/skin.png");
-	menu->addActionLink(settingIdx, tr["Wallpaper"],
+	menu->addActionLink(settingIdx, string(tr["Wallpaper"]),
 			bind(&GMenu2X::changeWallpaper, this),
-			tr["Change GMenu2X wallpaper"],
+			string(tr["Change GMenu2X wallpaper"]),
 			"skin:icons/wallpaper.png");
 	if (fileExists(getLogFile())) {
-		menu->addActionLink(settingIdx, tr["Log Viewer"],
+		menu->addActionLink(settingIdx, string(tr["Log Viewer"]),
 				bind(&GMenu2X::viewLog, this),
-				tr["Displays last launched program's output"],
+				string(tr["Displays last launched program's output"]),
 				"skin:icons/ebook.png");
 	}
-	menu->addActionLink(settingIdx, tr["About"],
+	menu->addActionLink(settingIdx, string(tr["About"]),
 			bind(&GMenu2X::about, this),
-			tr["Info about GMenu2X"],
+			string(tr["Info about GMenu2X"]),
 			"skin:icons/about.png");
 
 	menu->skinUpdated();
@@ -397,28 +467,32 @@ void GMenu2X::initMenu() {
 }
 
 void GMenu2X::about() {
-	string text(readFileAsString(GMENU2X_SYSTEM_DIR "/about.txt"));
 	string build_date("Build date: " __DATE__);
-	TextDialog td(*this, "GMenu2X", build_date, "icons/about.png", text);
-	td.exec();
+	layers.push_back(make_shared<TextDialog>(
+			*this, "GMenu2X", build_date, "icons/about.png",
+			Document::open(GMENU2X_SYSTEM_DIR "/about.txt")));
 }
 
 void GMenu2X::viewLog() {
-	string text(readFileAsString(getLogFile()));
-
-	TextDialog td(*this, tr["Log Viewer"],
-			tr["Displays last launched program's output"],
-			"icons/ebook.png", text);
-	td.exec();
-
-	MessageBox mb(*this, tr["Do you want to delete the log file?"],
-			 "icons/ebook.png");
-	mb.setButton(InputManager::ACCEPT, tr["Yes"]);
-	mb.setButton(InputManager::CANCEL, tr["No"]);
-	if (mb.exec() == InputManager::ACCEPT) {
-		unlink(getLogFile().c_str());
-		menu->deleteSelectedLink();
-	}
+	// Programs may still write to the log, so it is read instead of mapped.
+	// Only its end is read: that is what is of interest, and it keeps
+	// opening a huge log quick and cheap.
+	constexpr size_t MAX_LOG_VIEW = 1 << 20;
+	auto td = make_shared<TextDialog>(*this, string(tr["Log Viewer"]),
+			string(tr["Displays last launched program's output"]),
+			"icons/ebook.png",
+			Document::readTail(getLogFile(), MAX_LOG_VIEW));
+	td->setOnClose([this] {
+		auto mb = make_shared<MessageBox>(*this,
+				tr["Do you want to delete the log file?"], "icons/ebook.png");
+		mb->setButton(InputManager::ACCEPT, tr["Yes"], [this] {
+			unlink(getLogFile().c_str());
+			menu->deleteSelectedLink();
+		});
+		mb->setButton(InputManager::CANCEL, tr["No"]);
+		layers.push_back(mb);
+	});
+	layers.push_back(td);
 }
 
 void GMenu2X::readConfig() {
@@ -445,7 +519,9 @@ void GMenu2X::sanitizeConfig() {
 	evalIntConf( confInt, "trimExt", 0, 0,1);
 	evalIntConf( confInt, "backlightTimeout", 15, 0,120 );
 	evalIntConf( confInt, "buttonRepeatRate", 10, 0, 20 );
+	evalIntConf( confInt, "buttonRepeatAccel", 4, 0, 6 );
 	evalIntConf( confInt, "videoBpp", 32, 16, 32 );
+	evalIntConf( confInt, "perfHud", 0, 0, 1 );
 
 	if (confStr["tvoutEncoding"] != "PAL")
 		confStr["tvoutEncoding"] = "NTSC";
@@ -574,34 +650,77 @@ void GMenu2X::writeTmp(int selelem, const string &selectordir) {
 
 void GMenu2X::mainLoop() {
 	// Recover last session
-	readTmp();
-	if (lastSelectorElement > -1 && menu->selLinkApp() &&
-				(!menu->selLinkApp()->getSelectorDir().empty()
-				 || !lastSelectorDir.empty()))
-		menu->selLinkApp()->selector(lastSelectorElement, lastSelectorDir);
+	if (!replaying) {
+		readTmp();
+		if (lastSelectorElement > -1 && menu->selLinkApp() &&
+					(!menu->selLinkApp()->getSelectorDir().empty()
+					 || !lastSelectorDir.empty()))
+			menu->selLinkApp()->selector(lastSelectorElement, lastSelectorDir);
+	}
 
-	while (true) {
+	if (confInt["perfHud"])
+		perfHud = std::make_unique<PerfHud>(*this);
+
+	runLoop(nullptr);
+}
+
+void GMenu2X::runLoop(const Layer *until) {
+	// A press of ALTLEFT that is held back until it is known whether it
+	// starts the chord that toggles the performance overlay.
+	bool altLeftHeld = false;
+	while (!quitting) {
 		// Remove dismissed layers from the stack.
+		bool done = false;
 		for (auto it = layers.begin(); it != layers.end(); ) {
 			if ((*it)->getStatus() == Layer::Status::DISMISSED) {
+				done |= it->get() == until;
 				it = layers.erase(it);
+				compositeDepth = 0;
 			} else {
 				++it;
 			}
 		}
+		if (done) {
+			break;
+		}
 
 		// Run animations.
 		bool animating = false;
-		for (auto layer : layers) {
-			animating |= layer->runAnimations();
+		const size_t modal = topModalLayer();
+		for (size_t i = 0; i < layers.size(); i++) {
+			if (layers[i]->runAnimations()) {
+				animating = true;
+				if (i < modal)
+					compositeDepth = 0;
+			}
 		}
 
 		// Paint layers.
-		for (auto layer : layers)
-			layer->paint(*s);
-		layout->run();
-		layout->render(*s);
+		using Clock = std::chrono::steady_clock;
+		const auto before = Surface::getRenderStats();
+		const auto frameStart = Clock::now();
+		if (perfHud)
+			perfHud->beginFrame();
+		Clock::duration layoutTime, renderTime;
+		paintLayers(layoutTime, renderTime);
+		const auto hudStart = Clock::now();
+		if (perfHud)
+			perfHud->paint(*s);
+		const auto flipStart = Clock::now();
 		s->flip();
+		const auto frameEnd = Clock::now();
+		const auto &after = Surface::getRenderStats();
+		const Surface::RenderStats frameStats = {
+			after.drawCalls - before.drawCalls,
+			after.textureBinds - before.textureBinds,
+			after.targetSwitches - before.targetSwitches,
+		};
+		if (perfHud) {
+			// Leave out the overlay itself, including its draws.
+			perfHud->endFrame(layoutTime, renderTime, frameEnd - flipStart,
+					(hudStart - frameStart) + (frameEnd - flipStart),
+					frameStats);
+		}
 
 		// Exit main loop once we have something to launch.
 		if (toLaunch) {
@@ -614,32 +733,166 @@ void GMenu2X::mainLoop() {
 		const bool wait = !animating;
 		do {
 			gotEvent = input.getButton(&button, wait);
-		} while (wait && !gotEvent);
-		if (gotEvent) {
-			if (button == InputManager::QUIT) {
-				break;
-			}
-			for (auto it = layers.rbegin(); it != layers.rend(); ++it) {
-				if ((*it)->handleButtonPress(button)) {
-					break;
-				}
-			}
+		} while (wait && !gotEvent && !(altLeftHeld
+				&& !input.isPressed(InputManager::ALTLEFT)));
+		if (gotEvent && button == InputManager::QUIT) {
+			quitting = true;
+			break;
+		}
+
+		// Holding ALTLEFT and pressing ALTRIGHT toggles the overlay. Since
+		// ALTLEFT has an action of its own, its press is only handed to the
+		// layers once it is released or another button comes in.
+		if (gotEvent && button == InputManager::ALTRIGHT
+				&& (altLeftHeld || input.isPressed(InputManager::ALTLEFT))) {
+			altLeftHeld = false;
+			togglePerfHud();
+			continue;
+		}
+		if (altLeftHeld && (gotEvent
+				|| !input.isPressed(InputManager::ALTLEFT))) {
+			altLeftHeld = false;
+			handleButtonPress(InputManager::ALTLEFT, 1);
+		}
+		if (!gotEvent) {
+			continue;
+		}
+		// A replay has no held buttons, so there is no chord to wait for.
+		if (button == InputManager::ALTLEFT && !replaying) {
+			altLeftHeld = true;
+			continue;
+		}
+
+		// Whatever requested the repaint may be below a modal layer.
+		if (button == InputManager::REPAINT) {
+			compositeDepth = 0;
+		}
+		// Act on all queued moves before painting again, so that slow
+		// frames do not make the input lag behind.
+		unsigned int presses = 1;
+		if (button == InputManager::UP || button == InputManager::DOWN
+				|| button == InputManager::LEFT
+				|| button == InputManager::RIGHT) {
+			presses += input.coalesce(button);
+		}
+		handleButtonPress(button, presses);
+	}
+}
+
+void GMenu2X::handleButtonPress(InputManager::Button button,
+		unsigned int presses)
+{
+	for (size_t i = layers.size(); i-- > 0; ) {
+		const bool belowModal = i < topModalLayer();
+		// This may push new layers, or run a nested loop through
+		// runModal() that takes layers off the stack, so keep the layer
+		// alive and do not touch layers after it.
+		const auto layer = layers[i];
+		const size_t depth = layers.size();
+		if (layer->handleButtonPress(button, presses)) {
+			if (belowModal)
+				compositeDepth = 0;
+			break;
+		}
+		if (layers.size() != depth) {
+			compositeDepth = 0;
+			break;
+		}
+	}
+}
+
+size_t GMenu2X::topModalLayer() const
+{
+	for (size_t i = layers.size(); i-- > 1; ) {
+		if (layers[i]->isModal())
+			return i;
+	}
+	return 0;
+}
+
+void GMenu2X::paintLayers(std::chrono::steady_clock::duration &layoutTime,
+		std::chrono::steady_clock::duration &renderTime)
+{
+	const size_t modal = topModalLayer();
+	if (!modal) {
+		composite.reset();
+		for (auto layer : layers)
+			paintLayer(*layer, *s);
+		paintStatus(layoutTime, renderTime);
+		return;
+	}
+
+	if (compositeDepth != modal) {
+		if (!composite)
+			composite = OffscreenSurface::emptySurface(*this, width(), height());
+		if (composite) {
+			for (size_t i = 0; i < modal; i++)
+				paintLayer(*layers[i], *composite);
+			compositeDepth = modal;
 		}
 	}
+
+	if (composite) {
+		const auto start = std::chrono::steady_clock::now();
+		composite->blit(*s, 0, 0);
+		if (perfHud)
+			perfHud->layerPainted(nullptr,
+					std::chrono::steady_clock::now() - start);
+	} else {
+		for (size_t i = 0; i < modal; i++)
+			paintLayer(*layers[i], *s);
+	}
+	// The status bar belongs to the layers below; modal layers cover it.
+	paintStatus(layoutTime, renderTime);
+	for (size_t i = modal; i < layers.size(); i++)
+		paintLayer(*layers[i], *s);
+}
+
+void GMenu2X::paintStatus(std::chrono::steady_clock::duration &layoutTime,
+		std::chrono::steady_clock::duration &renderTime)
+{
+	using Clock = std::chrono::steady_clock;
+	const auto layoutStart = Clock::now();
+	layout->run();
+	const auto renderStart = Clock::now();
+	layout->render(*s);
+	layoutTime = renderStart - layoutStart;
+	renderTime = Clock::now() - renderStart;
+}
+
+void GMenu2X::paintLayer(Layer &layer, Surface &target)
+{
+	if (!perfHud) {
+		layer.paint(target);
+		return;
+	}
+	const auto start = std::chrono::steady_clock::now();
+	layer.paint(target);
+	perfHud->layerPainted(&layer, std::chrono::steady_clock::now() - start);
+}
+
+void GMenu2X::togglePerfHud()
+{
+	if (perfHud)
+		perfHud.reset();
+	else
+		perfHud = std::make_unique<PerfHud>(*this);
 }
 
 void GMenu2X::explorer() {
-	FileDialog fd(*this, tr["Select an application"], "sh,bin,py,elf,");
-	if (fd.exec()) {
+	auto fd = make_shared<FileDialog>(
+			*this, string(tr["Select an application"]), "sh,bin,py,elf,");
+	fd->setOnConfirm([this](const string &path, const string &file) {
 		if (confInt["saveSelection"] && (confInt["section"]!=menu->selSectionIndex() || confInt["link"]!=menu->selLinkIndex()))
 			writeConfig();
 
-		string command = cmdclean(fd.getPath()+"/"+fd.getFile());
-		chdir(fd.getPath().c_str());
+		string command = cmdclean(path+"/"+file);
+		chdir(path.c_str());
 
 		toLaunch.reset(new Launcher(
 				vector<string> { "/bin/sh", "-c", command }));
-	}
+	});
+	layers.push_back(fd);
 }
 
 void GMenu2X::queueLaunch(
@@ -649,6 +902,26 @@ void GMenu2X::queueLaunch(
 	layers.push_back(launchLayer);
 }
 
+void GMenu2X::pushLayer(shared_ptr<Layer> layer) {
+	layers.push_back(std::move(layer));
+}
+
+void GMenu2X::runModal(shared_ptr<Layer> layer) {
+	const Layer *until = layer.get();
+	layers.push_back(std::move(layer));
+	runLoop(until);
+
+	// The loop also stops on quitting or when something is to be launched,
+	// with the layer still on the stack; the outer loop then stops as well,
+	// but must not find the layer there.
+	auto it = find_if(layers.begin(), layers.end(),
+			[until](const shared_ptr<Layer>& l) { return l.get() == until; });
+	if (it != layers.end()) {
+		layers.erase(it);
+		compositeDepth = 0;
+	}
+}
+
 void GMenu2X::showHelpPopup() {
 	layers.push_back(make_shared<HelpPopup>(*this));
 }
@@ -692,6 +965,10 @@ void GMenu2X::showSettings() {
 			*this, tr["Button repeat rate"],
 			tr["Set button repetitions per second"],
 			&confInt["buttonRepeatRate"], 0, 20)));
+	sd.addSetting(unique_ptr<MenuSetting>(new MenuSettingInt(
+			*this, tr["Button repeat acceleration"],
+			tr["Double the repeat rate every second a button is held, up to this many times"],
+			&confInt["buttonRepeatAccel"], 0, 6)));
 	if (brightnessmanager->available()) {
 		sd.addSetting(unique_ptr<MenuSetting>(new MenuSettingInt(
 				*this, tr["Brightness level"],
@@ -861,18 +1138,24 @@ void GMenu2X::showContextMenu() {
 }
 
 void GMenu2X::changeWallpaper() {
-	WallpaperDialog wp(*this);
-	if (wp.exec() && confStr["wallpaper"] != wp.wallpaper) {
-		confStr["wallpaper"] = wp.wallpaper;
-		initBG();
-		writeConfig();
-	}
+	auto wp = make_shared<WallpaperDialog>(*this);
+	wp->setOnSelect([this](const string &wallpaper) {
+		if (confStr["wallpaper"] != wallpaper) {
+			confStr["wallpaper"] = wallpaper;
+			initBG();
+			writeConfig();
+		}
+	});
+	layers.push_back(wp);
 }
 
 void GMenu2X::addLink() {
-	FileDialog fd(*this, tr["Select an application"], "sh,bin,py,elf,");
-	if (fd.exec())
-		menu->addLink(fd.getPath(), fd.getFile());
+	auto fd = make_shared<FileDialog>(
+			*this, string(tr["Select an application"]), "sh,bin,py,elf,");
+	fd->setOnConfirm([this](const string &path, const string &file) {
+		menu->addLink(path, file);
+	});
+	layers.push_back(fd);
 }
 
 void GMenu2X::editLink() {
@@ -910,7 +1193,7 @@ void GMenu2X::editLink() {
 		sd.addSetting(unique_ptr<MenuSetting>(new MenuSettingImage(
 				*this, tr["Icon"],
 				tr.translate("Select an icon for this link", linkTitle.c_str(), NULL),
-				&linkIcon, "png")));
+				&linkIcon, "png,qoi")));
 		sd.addSetting(unique_ptr<MenuSetting>(new MenuSettingFile(
 				*this, tr["Manual"],
 				tr["Select a manual or README file"],
@@ -971,11 +1254,12 @@ void GMenu2X::editLink() {
 
 void GMenu2X::deleteLink() {
 	if (menu->selLinkApp()!=NULL) {
-		MessageBox mb(*this, tr.translate("Deleting $1",menu->selLink()->getTitle().c_str(),NULL)+"\n"+tr["Are you sure?"], menu->selLink()->getIconPath());
-		mb.setButton(InputManager::ACCEPT, tr["Yes"]);
-		mb.setButton(InputManager::CANCEL, tr["No"]);
-		if (mb.exec() == InputManager::ACCEPT)
+		auto mb = make_shared<MessageBox>(*this, tr.translate("Deleting $1",menu->selLink()->getTitle().c_str(),NULL)+"\n"+string(tr["Are you sure?"]), menu->selLink()->getIconPath());
+		mb->setButton(InputManager::ACCEPT, tr["Yes"], [this] {
 			menu->deleteSelectedLink();
+		});
+		mb->setButton(InputManager::CANCEL, tr["No"]);
+		layers.push_back(mb);
 	}
 }
 
@@ -995,7 +1279,7 @@ void GMenu2X::deleteSection()
 }
 
 int GMenu2X::drawButton(Surface& surface, const string &btn,
-			const string &text, int x, int y) {
+			compat::string_view text, int x, int y) {
 	int w = 0;
 	auto icon = sc["skin:imgs/buttons/" + btn + ".png"];
 	if (icon) {
@@ -1013,7 +1297,7 @@ int GMenu2X::drawButton(Surface& surface, const string &btn,
 }
 
 int GMenu2X::drawButtonRight(Surface& surface, const string &btn,
-			     const string &text, int x, int y) {
+			     compat::string_view text, int x, int y) {
 	int w = 0;
 	auto icon = sc["skin:imgs/buttons/" + btn + ".png"];
 	if (icon) {
@@ -1030,7 +1314,8 @@ int GMenu2X::drawButtonRight(Surface& surface, const string &btn,
 	return x - w;
 }
 
-void GMenu2X::drawScrollBar(uint32_t pageSize, uint32_t totalSize, uint32_t pagePos) {
+void GMenu2X::drawScrollBar(Surface& surface,
+		uint32_t pageSize, uint32_t totalSize, uint32_t pagePos) {
 	if (totalSize <= pageSize) {
 		// Everything fits on one screen, no scroll bar needed.
 		return;
@@ -1041,16 +1326,27 @@ void GMenu2X::drawScrollBar(uint32_t pageSize, uint32_t totalSize, uint32_t page
 	top += 1;
 	height -= 2;
 
-	s->rectangle(width() - 8, top, 7, height,
-		     skinConfColors[COLOR_SELECTION_BG]);
+	surface.rectangle(width() - 8, top, 7, height,
+			skinConfColors[COLOR_SELECTION_BG]);
 	top += 2;
 	height -= 4;
 
 	const uint32_t barSize = std::max(height * pageSize / totalSize, 4u);
 	const uint32_t barPos = (height - barSize) * pagePos / (totalSize - pageSize);
 
-	s->box(width() - 6, top + barPos, 3, barSize,
-	       skinConfColors[COLOR_SELECTION_BG]);
+	surface.box(width() - 6, top + barPos, 3, barSize,
+			skinConfColors[COLOR_SELECTION_BG]);
+}
+
+void GMenu2X::drawBar(Surface& surface, Surface const& bar, int y) {
+	if (bar.width() == 1) {
+		// Stretching a single column is one draw call instead of one per
+		// pixel of screen width.
+		bar.blitScaled(surface, SDL_Rect{ 0, y, int(width()), bar.height() });
+	} else {
+		for (unsigned int x = 0; x < width(); x += bar.width())
+			bar.blit(surface, x, y);
+	}
 }
 
 void GMenu2X::drawTopBar(Surface& surface) {
@@ -1058,8 +1354,7 @@ void GMenu2X::drawTopBar(Surface& surface) {
 	if (!skinConfInt["topBarBgUseColor"])
 		bar = sc.skinRes("imgs/topbar.png", false);
 	if (bar) {
-		for (unsigned int x = 0; x < width(); x++)
-			bar->blit(surface, x, 0);
+		drawBar(surface, *bar, 0);
 	} else {
 		const int h = skinConfInt["topBarHeight"];
 		surface.box(0, 0, width(), h,
@@ -1072,8 +1367,7 @@ void GMenu2X::drawBottomBar(Surface& surface) {
 	if (!skinConfInt["bottomBarBgUseColor"])
 		bar = sc.skinRes("imgs/bottombar.png", false);
 	if (bar) {
-		for (unsigned int x = 0; x < width(); x++)
-			bar->blit(surface, x, height() - bar->height());
+		drawBar(surface, *bar, height() - bar->height());
 	} else {
 		const int h = skinConfInt["bottomBarHeight"];
 		surface.box(0, height() - h, width(), h,
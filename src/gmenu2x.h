@@ -22,6 +22,7 @@
 #define GMENU2X_H
 
 #include "buildopts.h"
+#include "compat-string_view.h"
 #include "contextmenu.h"
 #include "cpu.h"
 #include "surfacecollection.h"
@@ -29,8 +30,10 @@
 #include "inputmanager.h"
 #include "powersaver.h"
 #include "surface.h"
+#include "timerscheduler.h"
 #include "utilities.h"
 
+#include <chrono>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -48,6 +51,9 @@ class Layout;
 class LayoutItem;
 class MediaMonitor;
 class Menu;
+class PerfHud;
+class Replay;
+class TextRenderer;
 
 const int LOOP_DELAY = 30000;
 
@@ -74,8 +80,45 @@ private:
 	std::unique_ptr<BrightnessManager> brightnessmanager;
 
 	std::unique_ptr<Launcher> toLaunch;
+	/** True while running a replay, which should not depend on earlier runs. */
+	bool replaying;
 
 	std::vector<std::shared_ptr<Layer>> layers;
+	/**
+	 * Composite of the layers below the topmost modal layer, which is only
+	 * repainted when one of them changes. Only set while a modal layer is
+	 * shown; compositeDepth is the number of layers in it, 0 if invalid.
+	 */
+	std::shared_ptr<OffscreenSurface> composite;
+	size_t compositeDepth;
+
+	/** Set when the main loop is to stop, also from within runModal(). */
+	bool quitting;
+
+	/**
+	 * Runs the main loop until the given layer is dismissed, or until
+	 * something is launched or the menu quits.
+	 */
+	void runLoop(const Layer *until);
+	/** Hands a button press to the layers, from the top down. */
+	void handleButtonPress(InputManager::Button button, unsigned int presses);
+
+	/** Returns the index of the topmost modal layer, or 0 if there is none. */
+	size_t topModalLayer() const;
+	/**
+	 * Paints the layer stack with the status bar layout on top of the
+	 * layers below the topmost modal layer, and reports how long the
+	 * layout took to run and to render.
+	 */
+	void paintLayers(std::chrono::steady_clock::duration &layoutTime,
+			std::chrono::steady_clock::duration &renderTime);
+	void paintStatus(std::chrono::steady_clock::duration &layoutTime,
+			std::chrono::steady_clock::duration &renderTime);
+	void paintLayer(Layer &layer, Surface &target);
+
+	/** Performance overlay; only set while it is shown. */
+	std::unique_ptr<PerfHud> perfHud;
+	void togglePerfHud();
 
 	std::unique_ptr<Layout> layout;
 	std::shared_ptr<LayoutItem> top;
@@ -109,15 +152,30 @@ private:
 	}
 
 public:
-	static void run();
+	/**
+	 * Runs the menu until it quits or launches something. With a replay,
+	 * the buttons come from its script, the frames are recorded in it and
+	 * nothing is launched; the result is then the exit status.
+	 */
+	static int run(std::unique_ptr<Replay> replay = nullptr);
 
-	GMenu2X();
+	/**
+	 * With a replay, the buttons come from its script and the frames are
+	 * recorded in it, from the first one on.
+	 */
+	GMenu2X(Replay *replay = nullptr);
 	~GMenu2X();
 
 	static const std::string getLogFile() {
 		return getHome() + "/gmenu2x.log";
 	}
 
+	/**
+	 * True while running a replay: anything shown must then only depend on
+	 * the script, not on the machine or on timing.
+	 */
+	bool isReplaying() const { return replaying; }
+
 	const unsigned int getUiScale() const {
 		return const_cast<ConfIntHash&>(skinConfInt)["uiScale"] ?: 1;
 	}
@@ -148,6 +206,8 @@ public:
 		return std::make_pair(top, s->height() - top - bottom);
 	}
 
+	/** Timers of the main thread; outlives the members that use it. */
+	TimerScheduler timers;
 	std::shared_ptr<BottomBar> bottomBar;
 	std::shared_ptr<PowerSaver> powerSaver;
 	InputManager input;
@@ -173,6 +233,8 @@ public:
 	/** Background with empty top bar and a partially filled bottom bar. */
 	std::shared_ptr<OffscreenSurface> bgmain;
 	std::unique_ptr<FontStack> font;
+	/** Renders the texts of the links in the background. */
+	std::unique_ptr<TextRenderer> textRenderer;
 
 	//Status functions
 	void mainLoop();
@@ -193,6 +255,23 @@ public:
 	void queueLaunch(std::unique_ptr<Launcher>&& launcher,
 					 std::shared_ptr<Layer> launchLayer);
 
+	/** Shows the given layer on top of the others. */
+	void pushLayer(std::shared_ptr<Layer> layer);
+
+	/**
+	 * Shows the given layer and runs the main loop until it is dismissed.
+	 * This is for callers that have to wait for the layer before they can
+	 * return to the main loop, like the settings edited from within a
+	 * SettingsDialog; all others should use pushLayer().
+	 *
+	 * The nested loop runs inside the button handler of a layer further
+	 * down, and may remove any dismissed layer, including that one; the
+	 * outer loop keeps the layer alive and stops passing on the press when
+	 * the stack changed. When the nested loop stops for quitting or for a
+	 * launch, the layer is taken off the stack before returning.
+	 */
+	void runModal(std::shared_ptr<Layer> layer);
+
 	void saveSelection();
 	void writeConfig();
 	void writeSkinConfig();
@@ -204,10 +283,13 @@ public:
 	void addSection();
 	void deleteSection();
 
-	int drawButton(Surface& s, const std::string &btn, const std::string &text, int x=5, int y=-10);
-	int drawButtonRight(Surface& s, const std::string &btn, const std::string &text, int x=5, int y=-10);
-	void drawScrollBar(uint32_t pageSize, uint32_t totalSize, uint32_t pagePos);
+	int drawButton(Surface& s, const std::string &btn, compat::string_view text, int x=5, int y=-10);
+	int drawButtonRight(Surface& s, const std::string &btn, compat::string_view text, int x=5, int y=-10);
+	void drawScrollBar(Surface& s, uint32_t pageSize, uint32_t totalSize,
+			uint32_t pagePos);
 
+	/** Fills the width of the screen with copies of a bar image. */
+	void drawBar(Surface& s, Surface const& bar, int y);
 	void drawTopBar(Surface& s);
 	void drawBottomBar(Surface& s);
 
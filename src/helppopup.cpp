@@ -41,7 +41,7 @@ void HelpPopup::paint(Surface& s) {
 	posY += 10;
 
 	for (unsigned int i = 0; i < nb_strings; i++) {
-		font.write(s, tr[strings[i]], 20, posY);
+		font.write(s, tr.get(strings[i]), 20, posY);
 		posY += spacing;
 	}
 }
@@ -17,6 +17,7 @@ public:
 	HelpPopup(GMenu2X& gmenu2x);
 
 	// Layer implementation:
+	virtual bool isModal() const { return true; }
 	virtual void paint(Surface& s);
 	virtual bool handleButtonPress(InputManager::Button button);
 
@@ -8,7 +8,7 @@ using namespace std;
 
 
 IconButton::IconButton(
-		GMenu2X& gmenu2x, const string &icon, const string &label,
+		GMenu2X& gmenu2x, const string &icon, compat::string_view label,
 		Action action)
 	: gmenu2x(gmenu2x)
 	, icon(icon)
@@ -1,6 +1,7 @@
 #ifndef ICONBUTTON_H
 #define ICONBUTTON_H
 
+#include "compat-string_view.h"
 #include "gmenu2x.h"
 
 #include <SDL2/SDL.h>
@@ -18,7 +19,7 @@ public:
 	typedef std::function<void(void)> Action;
 
 	IconButton(GMenu2X& gmenu2x,
-			const std::string &icon, const std::string &label = "",
+			const std::string &icon, compat::string_view label = "",
 			Action action = nullptr);
 
 	SDL_Rect getRect() { return rect; }
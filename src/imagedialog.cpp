@@ -37,7 +37,8 @@ ImageDialog::ImageDialog(
 		GMenu2X& gmenu2x, const string &text,
 		const string &filter, const string &file)
 	: FileDialog(gmenu2x, text, filter, file, "Image Browser"),
-	previews(&gmenu2x)
+	previews(GMenu2X::getHome() + "/thumbnails",
+			gmenu2x.width() / 4, gmenu2x.height() / 4)
 {
 
 	string path;
@@ -54,9 +55,20 @@ ImageDialog::~ImageDialog() {
 	previews.clear();
 }
 
-void ImageDialog::beforeFileList() {
-	if (fl.isFile(selected) && fileExists(getPath()+"/"+fl[selected]))
-		previews[getPath()+"/"+fl[selected]]->blitRight(*gmenu2x.s, 310, 43);
+void ImageDialog::beforeFileList(Surface& s) {
+	if (fl.isFile(selected) && fileExists(getPath()+"/"+fl[selected])) {
+		auto preview = previews.get(getPath()+"/"+fl[selected]);
+		if (preview) {
+			preview->blitRight(s, gmenu2x.width() - 10,
+					gmenu2x.skinConfInt["topBarHeight"] + 3);
+		}
+	}
+
+	// Have the neighbours ready when the selection moves.
+	for (unsigned int i : { selected + 1, selected - 1 }) {
+		if (i < fl.size() && fl.isFile(i))
+			previews.prefetch(getPath()+"/"+fl[i]);
+	}
 }
 
 void ImageDialog::onChangeDir() {
@@ -22,20 +22,20 @@
 #define IMAGEDIALOG_H
 
 #include "filedialog.h"
-#include "surfacecollection.h"
+#include "thumbnailcache.h"
 
 #include <string>
 
 class ImageDialog : public FileDialog {
 protected:
-	SurfaceCollection previews;
+	ThumbnailCache previews;
 public:
 	ImageDialog(
 			GMenu2X& gmenu2x, const std::string &text,
 			const std::string &filter = "", const std::string &file = "");
 	virtual ~ImageDialog();
 
-	virtual void beforeFileList();
+	virtual void beforeFileList(Surface& s);
 	virtual void onChangeDir();
 };
 
@@ -10,8 +10,17 @@
 
 #include <SDL2/SDL.h>
 #include <png.h>
+#include <algorithm>
 #include <cassert>
+#include <cstdio>
+#include <cstring>
 #include <memory>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #ifdef HAVE_LIBOPK
 #include <opk.h>
@@ -25,7 +34,12 @@ static void __readFromOpk(png_structp png_ptr, png_bytep ptr, png_size_t length)
 }
 #endif
 
-SDL_Surface *loadPNG(const std::string &path, bool loadAlpha) {
+/**
+ * Decodes the columns [x, x + cropWidth) of a PNG file; a cropWidth of 0
+ * selects the full width.
+ */
+static SDL_Surface *decodePNG(const std::string &path, bool loadAlpha,
+		unsigned int x, unsigned int cropWidth) {
 	// Declare these with function scope and initialize them to NULL,
 	// so we can use a single cleanup block at the end of the function.
 	SDL_Surface *surface = NULL;
@@ -118,6 +132,10 @@ SDL_Surface *loadPNG(const std::string &path, bool loadAlpha) {
 		png_set_bgr(png); // BGRA in memory becomes ARGB in register
 	}
 
+	// - let libpng combine the passes of interlaced images
+	int passes;
+	passes = png_set_interlace_handling(png);
+
 	// Update the image info to the post-conversion state.
 	png_read_update_info(png, info);
 	png_get_IHDR(
@@ -125,8 +143,17 @@ SDL_Surface *loadPNG(const std::string &path, bool loadAlpha) {
 	assert(bitDepth == 8);
 	assert(colorType == PNG_COLOR_TYPE_RGB_ALPHA);
 
+	if (cropWidth == 0) {
+		cropWidth = width;
+	} else if (x >= width) {
+		WARNING("Requested columns are outside of the image\n");
+		goto cleanup;
+	} else if (cropWidth > width - x) {
+		cropWidth = width - x;
+	}
+
 	// Refuse to load outrageously large images.
-	if (width > 65536) {
+	if (cropWidth > 65536) {
 		WARNING("Refusing to load image because it is too wide\n");
 		goto cleanup;
 	}
@@ -137,7 +164,7 @@ SDL_Surface *loadPNG(const std::string &path, bool loadAlpha) {
 
 	// Allocate [A]RGB surface to hold the image.
 	surface = SDL_CreateRGBSurface(
-		0, width, height, 32,
+		0, cropWidth, height, 32,
 		0x00FF0000, 0x0000FF00, 0x000000FF, loadAlpha ? 0xFF000000 : 0x00000000
 		);
 	if (!surface) {
@@ -147,7 +174,32 @@ SDL_Surface *loadPNG(const std::string &path, bool loadAlpha) {
 
 	// Note: GCC 4.9 doesn't want to jump over 'rowPointers' with goto
 	//       if it is in the outer scope.
-	{
+	if (cropWidth < width && passes == 1) {
+		// Read row by row, keeping only the requested columns, so memory
+		// use does not depend on the width of the image.
+		auto row = std::make_unique<png_byte[]>(png_get_rowbytes(png, info));
+
+		for (png_uint_32 y = 0; y < height; y++) {
+			png_read_row(png, row.get(), NULL);
+			memcpy(static_cast<png_bytep>(surface->pixels) + y * surface->pitch,
+					row.get() + x * 4, cropWidth * 4);
+		}
+	} else if (cropWidth < width) {
+		// Interlaced images need all rows to combine the passes.
+		const size_t rowBytes = png_get_rowbytes(png, info);
+		auto pixels = std::make_unique<png_byte[]>(rowBytes * height);
+		auto rowPointers = std::make_unique<png_bytep[]>(height);
+
+		for (png_uint_32 y = 0; y < height; y++) {
+			rowPointers[y] = pixels.get() + y * rowBytes;
+		}
+		png_read_image(png, rowPointers.get());
+
+		for (png_uint_32 y = 0; y < height; y++) {
+			memcpy(static_cast<png_bytep>(surface->pixels) + y * surface->pitch,
+					rowPointers[y] + x * 4, cropWidth * 4);
+		}
+	} else {
 		// Compute row pointers.
 		auto rowPointers = std::make_unique<png_bytep[]>(height);
 
@@ -177,3 +229,472 @@ cleanup:
 
 	return surface;
 }
+
+SDL_Surface *loadPNG(const std::string &path, bool loadAlpha) {
+	return decodePNG(path, loadAlpha, 0, 0);
+}
+
+// QOI ("Quite OK Image") support.
+// Format reference: https://qoiformat.org/qoi-specification.pdf
+// QOI decodes several times faster than PNG, since there is no inflate
+// step; the files are somewhat larger.
+
+namespace {
+
+constexpr unsigned int QOI_HEADER_SIZE = 14;
+constexpr unsigned int QOI_PADDING_SIZE = 8;
+
+constexpr unsigned char QOI_OP_INDEX = 0x00; // 00xxxxxx
+constexpr unsigned char QOI_OP_DIFF  = 0x40; // 01xxxxxx
+constexpr unsigned char QOI_OP_LUMA  = 0x80; // 10xxxxxx
+constexpr unsigned char QOI_OP_RUN   = 0xC0; // 11xxxxxx
+constexpr unsigned char QOI_OP_RGB   = 0xFE; // 11111110
+constexpr unsigned char QOI_OP_RGBA  = 0xFF; // 11111111
+constexpr unsigned char QOI_MASK_2   = 0xC0; // 11000000
+
+const unsigned char qoiPadding[QOI_PADDING_SIZE] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+struct QoiPixel {
+	unsigned char r, g, b, a;
+
+	bool operator==(const QoiPixel &other) const {
+		return r == other.r && g == other.g && b == other.b && a == other.a;
+	}
+	bool operator!=(const QoiPixel &other) const {
+		return !(*this == other);
+	}
+	unsigned int hash() const {
+		return (r * 3 + g * 5 + b * 7 + a * 11) % 64;
+	}
+};
+
+inline uint32_t readBE32(const unsigned char *p) {
+	return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16)
+		| (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+inline void writeBE32(unsigned char *p, uint32_t v) {
+	p[0] = v >> 24;
+	p[1] = v >> 16;
+	p[2] = v >> 8;
+	p[3] = v;
+}
+
+/**
+ * The contents of an image file. Plain files are mapped into memory;
+ * paths of the form "file.opk#inner" are extracted from the OPK package.
+ */
+class ImageData {
+public:
+	explicit ImageData(const std::string &path);
+	~ImageData();
+	ImageData(const ImageData&) = delete;
+	ImageData& operator=(const ImageData&) = delete;
+
+	bool ok() const { return bytes != nullptr; }
+	const unsigned char *data() const { return bytes; }
+	size_t size() const { return length; }
+
+private:
+	const unsigned char *bytes = nullptr;
+	size_t length = 0;
+	void *mapping = MAP_FAILED;
+	std::vector<unsigned char> buffer;
+};
+
+ImageData::ImageData(const std::string &path) {
+#ifdef HAVE_LIBOPK
+	auto pos = path.find('#');
+	if (pos != path.npos) {
+		struct OPK *opk = opk_open(path.substr(0, pos).c_str());
+		if (!opk) {
+			ERROR("Unable to open OPK\n");
+			return;
+		}
+
+		void *extracted;
+		size_t extractedLength;
+		int ret = opk_extract_file(opk, path.substr(pos + 1).c_str(),
+					&extracted, &extractedLength);
+		opk_close(opk);
+		if (ret < 0) {
+			ERROR("Unable to extract image from OPK\n");
+			return;
+		}
+
+		auto begin = static_cast<unsigned char *>(extracted);
+		buffer.assign(begin, begin + extractedLength);
+		free(extracted);
+		bytes = buffer.data();
+		length = buffer.size();
+		return;
+	}
+#endif
+
+	int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return;
+
+	struct stat st;
+	if (fstat(fd, &st) == 0 && st.st_size > 0) {
+		mapping = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapping != MAP_FAILED) {
+			bytes = static_cast<const unsigned char *>(mapping);
+			length = st.st_size;
+		}
+	}
+	close(fd);
+}
+
+ImageData::~ImageData() {
+	if (mapping != MAP_FAILED)
+		munmap(mapping, length);
+}
+
+bool hasSuffix(const std::string &str, const char *suffix) {
+	size_t len = strlen(suffix);
+	return str.size() >= len
+		&& strcasecmp(str.c_str() + str.size() - len, suffix) == 0;
+}
+
+} // namespace
+
+/**
+ * Decodes the columns [x0, x0 + cropWidth) of a QOI image; a cropWidth of 0
+ * selects the full width.
+ */
+static SDL_Surface *decodeQOIColumns(const void *buffer, size_t size,
+		bool loadAlpha, unsigned int x0, unsigned int cropWidth) {
+	auto data = static_cast<const unsigned char *>(buffer);
+	if (size < QOI_HEADER_SIZE + QOI_PADDING_SIZE
+			|| memcmp(data, "qoif", 4) != 0) {
+		WARNING("Not a QOI image\n");
+		return NULL;
+	}
+
+	uint32_t width = readBE32(data + 4);
+	uint32_t height = readBE32(data + 8);
+	unsigned char channels = data[12];
+	if (width == 0 || height == 0 || channels < 3 || channels > 4) {
+		WARNING("Invalid QOI header\n");
+		return NULL;
+	}
+
+	if (cropWidth == 0) {
+		cropWidth = width;
+	} else if (x0 >= width) {
+		WARNING("Requested columns are outside of the image\n");
+		return NULL;
+	} else if (cropWidth > width - x0) {
+		cropWidth = width - x0;
+	}
+
+	// Same limits as for PNG.
+	if (cropWidth > 65536) {
+		WARNING("Refusing to load image because it is too wide\n");
+		return NULL;
+	}
+	if (height > 2048) {
+		WARNING("Refusing to load image because it is too high\n");
+		return NULL;
+	}
+
+	SDL_Surface *surface = SDL_CreateRGBSurface(
+		0, cropWidth, height, 32,
+		0x00FF0000, 0x0000FF00, 0x000000FF, loadAlpha ? 0xFF000000 : 0x00000000
+		);
+	if (!surface) {
+		// Failed to create surface, probably out of memory.
+		return NULL;
+	}
+
+	QoiPixel index[64];
+	memset(index, 0, sizeof(index));
+	QoiPixel px = { 0, 0, 0, 255 };
+	unsigned int run = 0;
+
+	const size_t end = size - QOI_PADDING_SIZE;
+	size_t p = QOI_HEADER_SIZE;
+
+	for (uint32_t y = 0; y < height; y++) {
+		auto row = reinterpret_cast<uint32_t *>(
+			static_cast<unsigned char *>(surface->pixels) + y * surface->pitch);
+
+		for (uint32_t x = 0; x < width; x++) {
+			if (run > 0) {
+				run--;
+			} else {
+				if (p >= end) goto truncated;
+				unsigned char b1 = data[p++];
+
+				if (b1 == QOI_OP_RGB) {
+					if (p + 3 > end) goto truncated;
+					px.r = data[p++];
+					px.g = data[p++];
+					px.b = data[p++];
+				} else if (b1 == QOI_OP_RGBA) {
+					if (p + 4 > end) goto truncated;
+					px.r = data[p++];
+					px.g = data[p++];
+					px.b = data[p++];
+					px.a = data[p++];
+				} else if ((b1 & QOI_MASK_2) == QOI_OP_INDEX) {
+					px = index[b1];
+				} else if ((b1 & QOI_MASK_2) == QOI_OP_DIFF) {
+					px.r += ((b1 >> 4) & 0x03) - 2;
+					px.g += ((b1 >> 2) & 0x03) - 2;
+					px.b += ( b1       & 0x03) - 2;
+				} else if ((b1 & QOI_MASK_2) == QOI_OP_LUMA) {
+					if (p + 1 > end) goto truncated;
+					unsigned char b2 = data[p++];
+					int vg = (b1 & 0x3F) - 32;
+					px.r += vg - 8 + ((b2 >> 4) & 0x0F);
+					px.g += vg;
+					px.b += vg - 8 +  (b2       & 0x0F);
+				} else { // QOI_OP_RUN
+					run = b1 & 0x3F;
+				}
+
+				index[px.hash()] = px;
+			}
+
+			// Note: relies on unsigned wrap-around for x < x0.
+			if (x - x0 < cropWidth) {
+				row[x - x0] = (uint32_t(px.a) << 24) | (uint32_t(px.r) << 16)
+					| (uint32_t(px.g) << 8) | uint32_t(px.b);
+			}
+		}
+	}
+
+	return surface;
+
+truncated:
+	WARNING("QOI image data is truncated\n");
+	SDL_FreeSurface(surface);
+	return NULL;
+}
+
+SDL_Surface *decodeQOI(const void *data, size_t size, bool loadAlpha) {
+	return decodeQOIColumns(data, size, loadAlpha, 0, 0);
+}
+
+SDL_Surface *loadQOI(const std::string &path, bool loadAlpha) {
+	ImageData data(path);
+	if (!data.ok())
+		return NULL;
+
+	return decodeQOI(data.data(), data.size(), loadAlpha);
+}
+
+bool saveQOI(SDL_Surface *surface, const std::string &path) {
+	SDL_Surface *converted = NULL;
+	if (surface->format->format != SDL_PIXELFORMAT_ARGB8888) {
+		converted = SDL_ConvertSurfaceFormat(
+			surface, SDL_PIXELFORMAT_ARGB8888, 0);
+		if (!converted) {
+			ERROR("Unable to convert surface: %s\n", SDL_GetError());
+			return false;
+		}
+		surface = converted;
+	}
+
+	const unsigned int width = surface->w, height = surface->h;
+	bool hasAlpha = false;
+
+	std::vector<unsigned char> data;
+	// Worst case is one QOI_OP_RGBA per pixel.
+	data.reserve(QOI_HEADER_SIZE + width * height * 5 + QOI_PADDING_SIZE);
+	data.resize(QOI_HEADER_SIZE);
+	memcpy(data.data(), "qoif", 4);
+	writeBE32(data.data() + 4, width);
+	writeBE32(data.data() + 8, height);
+	data[13] = 0; // sRGB with linear alpha
+
+	QoiPixel index[64];
+	memset(index, 0, sizeof(index));
+	QoiPixel prev = { 0, 0, 0, 255 };
+	unsigned int run = 0;
+
+	for (unsigned int y = 0; y < height; y++) {
+		auto row = reinterpret_cast<const uint32_t *>(
+			static_cast<const unsigned char *>(surface->pixels)
+			+ y * surface->pitch);
+
+		for (unsigned int x = 0; x < width; x++) {
+			uint32_t argb = row[x];
+			QoiPixel px = {
+				static_cast<unsigned char>(argb >> 16),
+				static_cast<unsigned char>(argb >> 8),
+				static_cast<unsigned char>(argb),
+				static_cast<unsigned char>(argb >> 24),
+			};
+			hasAlpha |= px.a != 255;
+
+			if (px == prev) {
+				run++;
+				if (run == 62) {
+					data.push_back(QOI_OP_RUN | (run - 1));
+					run = 0;
+				}
+				continue;
+			}
+
+			if (run > 0) {
+				data.push_back(QOI_OP_RUN | (run - 1));
+				run = 0;
+			}
+
+			unsigned int h = px.hash();
+			if (index[h] == px) {
+				data.push_back(QOI_OP_INDEX | h);
+			} else {
+				index[h] = px;
+
+				if (px.a == prev.a) {
+					signed char vr = px.r - prev.r;
+					signed char vg = px.g - prev.g;
+					signed char vb = px.b - prev.b;
+					signed char vg_r = vr - vg;
+					signed char vg_b = vb - vg;
+
+					if (vr > -3 && vr < 2 && vg > -3 && vg < 2
+							&& vb > -3 && vb < 2) {
+						data.push_back(QOI_OP_DIFF | (vr + 2) << 4
+								| (vg + 2) << 2 | (vb + 2));
+					} else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32
+							&& vg_b > -9 && vg_b < 8) {
+						data.push_back(QOI_OP_LUMA | (vg + 32));
+						data.push_back((vg_r + 8) << 4 | (vg_b + 8));
+					} else {
+						data.push_back(QOI_OP_RGB);
+						data.push_back(px.r);
+						data.push_back(px.g);
+						data.push_back(px.b);
+					}
+				} else {
+					data.push_back(QOI_OP_RGBA);
+					data.push_back(px.r);
+					data.push_back(px.g);
+					data.push_back(px.b);
+					data.push_back(px.a);
+				}
+			}
+			prev = px;
+		}
+	}
+	if (run > 0)
+		data.push_back(QOI_OP_RUN | (run - 1));
+	data.insert(data.end(), qoiPadding, qoiPadding + QOI_PADDING_SIZE);
+	data[12] = hasAlpha ? 4 : 3;
+
+	if (converted)
+		SDL_FreeSurface(converted);
+
+	FILE *fp = fopen(path.c_str(), "wb");
+	if (!fp) {
+		ERROR("Unable to open %s for writing\n", path.c_str());
+		return false;
+	}
+	bool ok = fwrite(data.data(), 1, data.size(), fp) == data.size();
+	ok &= fclose(fp) == 0;
+	if (!ok)
+		ERROR("Unable to write %s\n", path.c_str());
+	return ok;
+}
+
+std::string qoiSiblingPath(const std::string &path) {
+	if (!hasSuffix(path, ".png"))
+		return "";
+	return path.substr(0, path.size() - 3) + "qoi";
+}
+
+bool imageFileExists(const std::string &path) {
+	if (access(path.c_str(), F_OK) == 0)
+		return true;
+
+	std::string qoiPath = qoiSiblingPath(path);
+	return !qoiPath.empty() && access(qoiPath.c_str(), F_OK) == 0;
+}
+
+/**
+ * Returns the path of the file that actually holds the given image:
+ * a ".png" path is replaced by the path of its QOI sibling, if that exists.
+ */
+static std::string resolveImagePath(const std::string &path) {
+	// OPK packages are read-only and usually only ship PNG, so don't go
+	// looking for converted siblings inside them.
+	if (path.find('#') == path.npos) {
+		std::string qoiPath = qoiSiblingPath(path);
+		if (!qoiPath.empty() && access(qoiPath.c_str(), F_OK) == 0)
+			return qoiPath;
+	}
+	return path;
+}
+
+SDL_Surface *loadImageFile(const std::string &path, bool loadAlpha) {
+	if (hasSuffix(path, ".qoi"))
+		return loadQOI(path, loadAlpha);
+
+	std::string resolved = resolveImagePath(path);
+	if (resolved != path) {
+		SDL_Surface *surface = loadQOI(resolved, loadAlpha);
+		if (surface)
+			return surface;
+		WARNING("Failed to load %s, falling back to PNG\n",
+				resolved.c_str());
+	}
+
+	return loadPNG(path, loadAlpha);
+}
+
+bool getImageSize(const std::string &path,
+		unsigned int *width, unsigned int *height) {
+	std::string resolved = resolveImagePath(path);
+
+	// Both formats have the dimensions at a fixed place in the header:
+	// PNG in the IHDR chunk, which must come first.
+	unsigned char header[24];
+	size_t length;
+#ifdef HAVE_LIBOPK
+	if (resolved.find('#') != resolved.npos) {
+		// Members of an OPK package can only be extracted as a whole.
+		ImageData data(resolved);
+		if (!data.ok())
+			return false;
+		length = std::min(data.size(), sizeof(header));
+		memcpy(header, data.data(), length);
+	} else
+#endif
+	{
+		FILE *fp = fopen(resolved.c_str(), "rb");
+		if (!fp)
+			return false;
+		length = fread(header, 1, sizeof(header), fp);
+		fclose(fp);
+	}
+
+	if (length >= QOI_HEADER_SIZE && memcmp(header, "qoif", 4) == 0) {
+		*width = readBE32(header + 4);
+		*height = readBE32(header + 8);
+		return true;
+	}
+	if (length == sizeof(header) && png_sig_cmp(header, 0, 8) == 0
+			&& memcmp(header + 12, "IHDR", 4) == 0) {
+		*width = readBE32(header + 16);
+		*height = readBE32(header + 20);
+		return true;
+	}
+	return false;
+}
+
+SDL_Surface *loadImageColumns(const std::string &path,
+		unsigned int x, unsigned int width, bool loadAlpha) {
+	std::string resolved = resolveImagePath(path);
+	if (hasSuffix(resolved, ".qoi")) {
+		ImageData data(resolved);
+		if (!data.ok())
+			return NULL;
+		return decodeQOIColumns(data.data(), data.size(), loadAlpha, x, width);
+	}
+	return decodePNG(resolved, loadAlpha, x, width);
+}
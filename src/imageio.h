@@ -1,6 +1,7 @@
 #ifndef IMAGEIO_H
 #define IMAGEIO_H
 
+#include <cstddef>
 #include <string>
 
 struct SDL_Surface;
@@ -9,4 +10,46 @@ struct SDL_Surface;
   */
 SDL_Surface *loadPNG(const std::string &path, bool loadAlpha = true);
 
+/** Loads an image from a QOI file into a newly allocated 32bpp RGBA surface.
+  */
+SDL_Surface *loadQOI(const std::string &path, bool loadAlpha = true);
+
+/** Decodes a QOI image held in memory into a newly allocated 32bpp RGBA
+  * surface.
+  */
+SDL_Surface *decodeQOI(const void *data, size_t size, bool loadAlpha = true);
+
+/** Writes a surface to a QOI file.
+  * @return True iff the file was written successfully.
+  */
+bool saveQOI(SDL_Surface *surface, const std::string &path);
+
+/** Returns the path of the QOI file that may replace the given PNG file,
+  * or an empty string if the path does not name a PNG file.
+  */
+std::string qoiSiblingPath(const std::string &path);
+
+/** Returns true if the given image file, or its QOI replacement, exists.
+  */
+bool imageFileExists(const std::string &path);
+
+/** Loads an image file in any supported format into a newly allocated 32bpp
+  * RGBA surface. A ".png" path is served from a ".qoi" file next to it if
+  * there is one; the PNG file is used if the QOI file is missing or broken.
+  */
+SDL_Surface *loadImageFile(const std::string &path, bool loadAlpha = true);
+
+/** Reads the dimensions of an image file without decoding it.
+  * @return True iff the dimensions could be determined.
+  */
+bool getImageSize(const std::string &path,
+		unsigned int *width, unsigned int *height);
+
+/** Loads the columns [x, x + width) of an image file into a newly allocated
+  * 32bpp RGBA surface. For non-interlaced images, memory use is bounded by
+  * the requested width instead of the width of the entire image.
+  */
+SDL_Surface *loadImageColumns(const std::string &path,
+		unsigned int x, unsigned int width, bool loadAlpha = true);
+
 #endif
@@ -0,0 +1,72 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#include "imagemanualdialog.h"
+
+#include "font_stack.h"
+#include "gmenu2x.h"
+#include "surface.h"
+
+#include <string>
+
+using namespace std;
+
+ImageManualDialog::ImageManualDialog(GMenu2X& gmenu2x, const string &path)
+	: gmenu2x(gmenu2x)
+	, pages(path, gmenu2x.width())
+	, page(0)
+{
+	if (!pageCount())
+		return;
+
+	bg = OffscreenSurface::loadImage(gmenu2x, gmenu2x.confStr["wallpaper"]);
+	if (!bg) {
+		bg = OffscreenSurface::emptySurface(gmenu2x, gmenu2x.width(), gmenu2x.height());
+	}
+	bg->convertToDisplayFormat();
+}
+
+void ImageManualDialog::paint(Surface& s)
+{
+	if (bg) {
+		bg->blit(s, 0, 0);
+	}
+	auto tile = pages.getTile(page);
+	if (tile) {
+		tile->blit(s, 0, 0);
+	}
+
+	gmenu2x.drawBottomBar(s);
+	int x = 5;
+	x = gmenu2x.drawButton(s, "left", "", x);
+	x = gmenu2x.drawButton(s, "right", gmenu2x.tr["Change page"], x);
+	x = gmenu2x.drawButton(s, "cancel", "", x);
+	x = gmenu2x.drawButton(s, "start", gmenu2x.tr["Exit"], x);
+	(void)x;
+
+	const string pageStatus = string(gmenu2x.tr["Page"]) + ": "
+			+ to_string(page + 1) + "/" + to_string(pageCount());
+	gmenu2x.font->write(s, pageStatus,
+			gmenu2x.width() - 10, gmenu2x.height() - 10,
+			Font::HAlignRight, Font::VAlignMiddle);
+}
+
+bool ImageManualDialog::handleButtonPress(InputManager::Button button)
+{
+	switch (button) {
+		case InputManager::SETTINGS:
+		case InputManager::CANCEL:
+			dismiss();
+			break;
+		case InputManager::LEFT:
+			if (page > 0)
+				page--;
+			break;
+		case InputManager::RIGHT:
+			if (page + 1 < pageCount())
+				page++;
+			break;
+		default:
+			break;
+	}
+	return true;
+}
@@ -0,0 +1,39 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#ifndef IMAGEMANUALDIALOG_H
+#define IMAGEMANUALDIALOG_H
+
+#include "layer.h"
+#include "tiledimage.h"
+
+#include <memory>
+#include <string>
+
+class GMenu2X;
+class OffscreenSurface;
+
+/**
+ * Shows a manual that is a wide image, one screen wide page at a time.
+ */
+class ImageManualDialog : public Layer {
+public:
+	ImageManualDialog(GMenu2X& gmenu2x, const std::string &path);
+
+	/** Returns the number of pages, or 0 if the image cannot be read. */
+	unsigned int pageCount() const { return pages.tileCount(); }
+
+	// Layer implementation:
+	virtual bool isModal() const { return true; }
+	virtual void paint(Surface& s);
+	virtual bool handleButtonPress(InputManager::Button button);
+
+private:
+	GMenu2X& gmenu2x;
+	// Pages are decoded one screen-sized tile at a time, so memory use
+	// does not depend on the length of the manual.
+	TiledImage pages;
+	std::shared_ptr<OffscreenSurface> bg;
+	unsigned int page;
+};
+
+#endif // IMAGEMANUALDIALOG_H
@@ -39,7 +39,7 @@ static bool utf8Code(unsigned char c)
 }
 
 InputDialog::InputDialog(GMenu2X& gmenu2x, InputManager &inputMgr_,
-		const string &text,
+		compat::string_view text,
 		const string &startvalue, const string &title, const string &icon)
 	: Dialog(gmenu2x)
 	, inputMgr(inputMgr_)
@@ -191,6 +191,7 @@ bool InputDialog::exec() {
 				close = true;
 				break;
 			case InputManager::MENU:
+			case InputManager::QUIT:
 				ok = false;
 				close = true;
 				break;
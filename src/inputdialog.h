@@ -33,7 +33,7 @@ class InputManager;
 class InputDialog : protected Dialog {
 public:
 	InputDialog(GMenu2X& gmenu2x, InputManager &inputMgr,
-			const std::string &text, const std::string &startvalue="",
+			compat::string_view text, const std::string &startvalue="",
 			const std::string &title="", const std::string &icon="");
 
 	bool exec();
@@ -24,7 +24,10 @@
 #include "utilities.h"
 #include "powersaver.h"
 #include "menu.h"
+#include "replay.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <fstream>
 
@@ -59,6 +62,14 @@ bool InputManager::init(Menu *menu)
 
 InputManager::InputManager(GMenu2X& gmenu2x)
 	: gmenu2x(gmenu2x)
+	, replay(nullptr)
+	, quitRequested(false)
+	, repeatTimer(gmenu2x.timers.add([this] { return repeatTimerExpired(); }))
+	, repeatRate(0)
+	, repeatAcceleration(0)
+	, repeating(false)
+	, repeatsDue(0)
+	, repeatFraction(0)
 {
 #ifndef SDL_JOYSTICK_DISABLED
 	int i;
@@ -71,7 +82,7 @@ InputManager::InputManager(GMenu2X& gmenu2x)
 	for (i = 0; i < SDL_NumJoysticks(); i++) {
 		struct Joystick joystick = {
 			SDL_JoystickOpen(i), false, false, false, false,
-			SDL_HAT_CENTERED, 0, this,
+			SDL_HAT_CENTERED,
 		};
 		joysticks.push_back(joystick);
 	}
@@ -82,6 +93,7 @@ InputManager::InputManager(GMenu2X& gmenu2x)
 
 InputManager::~InputManager()
 {
+	gmenu2x.timers.remove(repeatTimer);
 #ifndef SDL_JOYSTICK_DISABLED
 	for (auto it : joysticks)
 		SDL_JoystickClose(it.joystick);
@@ -151,67 +163,126 @@ InputManager::Button InputManager::waitForPressedButton() {
 	return button;
 }
 
-static int repeatRateMs(int repeatRate)
-{
-	return repeatRate == 0 ? 0 : 1000 / repeatRate;
+void InputManager::repeatRateChanged() {
+	// The repeats of the keyboard driver are ignored, so that all buttons
+	// repeat alike; see startRepeat().
+	repeatRate = gmenu2x.confInt["buttonRepeatRate"];
+	repeatAcceleration = gmenu2x.confInt["buttonRepeatAccel"];
+	if (!repeatRate)
+		stopRepeat();
 }
 
-void InputManager::repeatRateChanged() {
-	// SDL2 doesn't have SDL_EnableKeyRepeat, key repeat is handled differently
-	// The repeat timing is now managed through our timer callbacks
+#ifndef SDL_JOYSTICK_DISABLED
+static bool hatButton(Uint8 value, InputManager::Button *button)
+{
+	switch (value) {
+		case SDL_HAT_UP:
+			*button = InputManager::UP;
+			return true;
+		case SDL_HAT_DOWN:
+			*button = InputManager::DOWN;
+			return true;
+		case SDL_HAT_LEFT:
+			*button = InputManager::LEFT;
+			return true;
+		case SDL_HAT_RIGHT:
+			*button = InputManager::RIGHT;
+			return true;
+		default:
+			return false;
+	}
 }
+#endif
 
 bool InputManager::pollButton(Button *button) {
 	return getButton(button, false);
 }
 
+static bool isRepeatable(InputManager::Button button)
+{
+	switch (button) {
+		case InputManager::UP:
+		case InputManager::DOWN:
+		case InputManager::LEFT:
+		case InputManager::RIGHT:
+		case InputManager::ALTLEFT:
+		case InputManager::ALTRIGHT:
+			return true;
+		default:
+			return false;
+	}
+}
+
 bool InputManager::getButton(Button *button, bool wait) {
-	//TODO: when an event is processed, program a new event
-	//in some time, and when it occurs, do a key repeat
+	// Keep reporting a request to quit, so that the loops of nested dialogs
+	// all get to see it and return in turn.
+	if (quitRequested) {
+		*button = QUIT;
+		return true;
+	}
+
+	if (replay)
+		return getReplayButton(button, wait);
 
 #ifndef SDL_JOYSTICK_DISABLED
 	if (joysticks.size() > 0)
 		SDL_JoystickUpdate();
 #endif
 
+	// Timers are due before any events they push, so run them first and
+	// only sleep until the next one is due.
+	const int timeout = gmenu2x.timers.run();
+
+	dropReleasedRepeats();
+	if (repeatsDue) {
+		repeatsDue--;
+		*button = repeatButton;
+		return true;
+	}
+
 	SDL_Event event;
-	if (wait)
-		SDL_WaitEvent(&event);
-	else if (!SDL_PollEvent(&event))
+	if (wait) {
+		const bool gotEvent = SDL_WaitEventTimeout(&event, timeout);
+		if (!gotEvent)
+			return false;
+	} else if (!SDL_PollEvent(&event)) {
 		return false;
+	}
 
 	bool is_kb = false, is_js = false;
 	switch(event.type) {
 		case SDL_KEYDOWN:
+			// Held buttons are repeated by startRepeat() instead.
+			if (event.key.repeat)
+				return false;
 			is_kb = true;
 			break;
+		case SDL_KEYUP:
+			if (repeating && buttonMap[repeatButton].kb_mapped
+					&& (unsigned int)event.key.keysym.scancode
+							== buttonMap[repeatButton].kb_code)
+				stopRepeat();
+			return false;
 #ifndef SDL_JOYSTICK_DISABLED
 		case SDL_JOYHATMOTION: {
 				Joystick *joystick = &joysticks[event.jaxis.which];
 				joystick->hatState = event.jhat.value;
 
-				switch (event.jhat.value) {
-					case SDL_HAT_CENTERED:
-						stopTimer(joystick);
-						return false;
-					case SDL_HAT_UP:
-						*button = UP;
-						break;
-					case SDL_HAT_DOWN:
-						*button = DOWN;
-						break;
-					case SDL_HAT_LEFT:
-						*button = LEFT;
-						break;
-					case SDL_HAT_RIGHT:
-						*button = RIGHT;
-						break;
+				if (event.jhat.value == SDL_HAT_CENTERED) {
+					stopRepeat();
+					return false;
 				}
-				startTimer(joystick);
+				hatButton(event.jhat.value, button);
 			}
 		case SDL_JOYBUTTONDOWN:
 			is_js = true;
 			break;
+		case SDL_JOYBUTTONUP:
+			if (repeating && buttonMap[repeatButton].js_mapped
+					&& (unsigned int)event.jbutton.button
+							== buttonMap[repeatButton].js_code)
+				stopRepeat();
+			return false;
 		case SDL_JOYAXISMOTION: {
 				is_js = true;
 
@@ -241,12 +312,11 @@ bool InputManager::getButton(Button *button, bool wait) {
 								!otherAxisState[AXIS_STATE_POSITIVE] && (
 									axisState[AXIS_STATE_NEGATIVE] ||
 									axisState[AXIS_STATE_POSITIVE]))
-						stopTimer(joystick);
+						stopRepeat();
 
 					axisState[0] = axisState[1] = false;
 					return false;
 				}
-				startTimer(joystick);
 				break;
 			}
 #endif
@@ -256,6 +326,7 @@ bool InputManager::getButton(Button *button, bool wait) {
 
 		case SDL_QUIT:
 			*button = QUIT;
+			quitRequested = true;
 			return true;
 
 		default:
@@ -286,6 +357,11 @@ bool InputManager::getButton(Button *button, bool wait) {
 	if (i == BUTTON_TYPE_SIZE)
 		return false;
 
+	if (isRepeatable(*button))
+		startRepeat(*button);
+	else
+		stopRepeat();
+
 	bool screenState = PowerSaver::getInstance()->getScreenState();
 	if (wait) {
 		PowerSaver::getInstance()->resetScreenTimer();
@@ -297,53 +373,167 @@ bool InputManager::getButton(Button *button, bool wait) {
 	return true;
 }
 
-Uint32 keyRepeatCallback(Uint32 timeout, void *d)
+bool InputManager::getReplayButton(Button *button, bool wait)
 {
-	struct Joystick *joystick = (struct Joystick *) d;
-	return joystick->inputManager->joystickRepeatCallback(timeout, joystick);
+	const int timeout = gmenu2x.timers.run();
+
+	// Only the events that are not buttons are taken from SDL.
+	SDL_Event event;
+	while (SDL_PollEvent(&event)) {
+		if (event.type == SDL_USEREVENT || event.type == SDL_QUIT) {
+			*button = event.type == SDL_QUIT ? QUIT : REPAINT;
+			quitRequested = *button == QUIT;
+			replay->eventDelivered(*button);
+			return true;
+		}
+	}
+
+	int delay;
+	if (replay->nextButton(button, &delay)) {
+		quitRequested = *button == QUIT;
+		return true;
+	}
+
+	if (wait) {
+		SDL_WaitEventTimeout(nullptr,
+				timeout < 0 ? delay : std::min(timeout, delay));
+	}
+	return false;
 }
 
-void InputManager::startTimer(Joystick *joystick)
+unsigned int InputManager::coalesce(Button button)
 {
-	if (joystick->timer)
-		return;
+	if (replay || button >= BUTTON_TYPE_SIZE)
+		return 0;
+
+	unsigned int presses = 0;
+	dropReleasedRepeats();
+	if (repeating && repeatButton == button) {
+		presses += repeatsDue;
+		repeatsDue = 0;
+	}
 
-	joystick->timer = SDL_AddTimer(INPUT_KEY_REPEAT_DELAY,
-				keyRepeatCallback, joystick);
+	auto const& entry = buttonMap[button];
+	if (!entry.kb_mapped)
+		return presses;
+
+	// Only take the events of this very key: anything else stays queued,
+	// so that other keys are still seen in order and isPressed() does not
+	// miss their state changes.
+	SDL_Event event;
+	while (SDL_PeepEvents(&event, 1, SDL_PEEKEVENT,
+				SDL_FIRSTEVENT, SDL_LASTEVENT) == 1) {
+		if ((event.type != SDL_KEYDOWN && event.type != SDL_KEYUP)
+				|| (unsigned int)event.key.keysym.scancode != entry.kb_code)
+			break;
+
+		SDL_PeepEvents(&event, 1, SDL_GETEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT);
+		if (event.type == SDL_KEYUP) {
+			if (repeating && repeatButton == button)
+				stopRepeat();
+		} else if (!event.key.repeat) {
+			startRepeat(button);
+			presses++;
+		}
+	}
+	return presses;
 }
 
-Uint32 InputManager::joystickRepeatCallback([[maybe_unused]] Uint32 timeout, struct Joystick *joystick)
+void InputManager::startRepeat(Button button)
 {
-	Uint8 hatState;
-
-	if (joystick->axisState[1][AXIS_STATE_NEGATIVE])
-		hatState = SDL_HAT_UP;
-	else if (joystick->axisState[1][AXIS_STATE_POSITIVE])
-		hatState = SDL_HAT_DOWN;
-	else if (joystick->axisState[0][AXIS_STATE_NEGATIVE])
-		hatState = SDL_HAT_LEFT;
-	else if (joystick->axisState[0][AXIS_STATE_POSITIVE])
-		hatState = SDL_HAT_RIGHT;
+	repeating = repeatRate > 0;
+	repeatButton = button;
+	repeatsDue = 0;
+	// The first repeat is due right when the delay is over.
+	repeatStart = lastRepeat =
+			Clock::now() + std::chrono::milliseconds(INPUT_KEY_REPEAT_DELAY);
+	repeatFraction = 1;
+	if (repeating)
+		gmenu2x.timers.start(repeatTimer, INPUT_KEY_REPEAT_DELAY);
 	else
-		hatState = joystick->hatState;
-
-	SDL_JoyHatEvent e = {
-		SDL_JOYHATMOTION,
-		// Should this be the current time?
-		0, // timestamp
-		(Uint8) SDL_JoystickInstanceID(joystick->joystick),
-		0,
-		hatState,
-	};
-	SDL_PushEvent((SDL_Event *) &e);
-
-	return repeatRateMs(gmenu2x.confInt["buttonRepeatRate"]);
+		gmenu2x.timers.stop(repeatTimer);
 }
 
-void InputManager::stopTimer(Joystick *joystick)
+void InputManager::stopRepeat()
 {
-	if (joystick->timer) {
-		SDL_RemoveTimer(joystick->timer);
-		joystick->timer = 0;
+	repeating = false;
+	repeatsDue = 0;
+	gmenu2x.timers.stop(repeatTimer);
+}
+
+unsigned int InputManager::repeatTimerExpired()
+{
+	if (!repeating)
+		return 0;
+
+	using namespace std::chrono;
+	const auto now = max(Clock::now(), lastRepeat);
+
+	// The rate doubles every second, up to the configured number of times.
+	const double held = duration<double>(now - repeatStart).count();
+	const double rate = repeatRate * exp2(min(held, double(repeatAcceleration)));
+	repeatFraction += duration<double>(now - lastRepeat).count() * rate;
+	lastRepeat = now;
+
+	const unsigned int due = (unsigned int) repeatFraction;
+	repeatFraction -= due;
+	const unsigned int maxDue =
+			max(1u, (unsigned int) (rate * INPUT_MAX_DUE_REPEATS_MS / 1000));
+	repeatsDue = min(repeatsDue + due, maxDue);
+
+	// Waking up more often than a frame would not show any sooner.
+	return max(16u, (unsigned int) ((1 - repeatFraction) * 1000 / rate));
+}
+
+void InputManager::dropReleasedRepeats()
+{
+	if (!repeatsDue)
+		return;
+
+	// The device state is ahead of the event queue, so the release shows
+	// here before its event is read; otherwise accelerated repeats would
+	// keep moving the selection after the button is let go.
+	SDL_PumpEvents();
+	if (isPressed(repeatButton))
+		return;
+#ifndef SDL_JOYSTICK_DISABLED
+	for (auto const& joystick : joysticks) {
+		Button button;
+		if (hatButton(SDL_JoystickGetHat(joystick.joystick, 0), &button)
+				&& button == repeatButton)
+			return;
+		const Sint16 x = SDL_JoystickGetAxis(joystick.joystick, 0);
+		const Sint16 y = SDL_JoystickGetAxis(joystick.joystick, 1);
+		if ((repeatButton == LEFT && x < -20000)
+				|| (repeatButton == RIGHT && x > 20000)
+				|| (repeatButton == UP && y < -20000)
+				|| (repeatButton == DOWN && y > 20000))
+			return;
 	}
+#endif
+	stopRepeat();
 }
+
+bool InputManager::isPressed(Button button) const
+{
+	if (button >= BUTTON_TYPE_SIZE)
+		return false;
+
+	auto const& entry = buttonMap[button];
+	if (entry.kb_mapped) {
+		int numKeys;
+		const Uint8 *keys = SDL_GetKeyboardState(&numKeys);
+		if (int(entry.kb_code) < numKeys && keys[entry.kb_code])
+			return true;
+	}
+#ifndef SDL_JOYSTICK_DISABLED
+	if (entry.js_mapped) {
+		for (auto const& joystick : joysticks) {
+			if (SDL_JoystickGetButton(joystick.joystick, entry.js_code))
+				return true;
+		}
+	}
+#endif
+	return false;
+}
+
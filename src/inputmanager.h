@@ -21,16 +21,23 @@
 #ifndef INPUTMANAGER_H
 #define INPUTMANAGER_H
 
+#include "timerscheduler.h"
+
 #include <SDL2/SDL.h>
+#include <chrono>
 #include <string>
 #include <vector>
 #include <array>
 
 #define INPUT_KEY_REPEAT_DELAY 250
+/* Repeats that can be due at once, in milliseconds worth of repeats; the
+ * rest is dropped, so that scrolling stops soon after the button is released
+ * even if the frames cannot keep up. */
+#define INPUT_MAX_DUE_REPEATS_MS 250
 
 class GMenu2X;
 class Menu;
-class InputManager;
+class Replay;
 
 #ifndef SDL_JOYSTICK_DISABLED
 #define AXIS_STATE_POSITIVE 0
@@ -39,8 +46,6 @@ struct Joystick {
 	SDL_Joystick *joystick;
 	bool axisState[2][2];
 	Uint8 hatState;
-	SDL_TimerID timer;
-	InputManager *inputManager;
 };
 #endif
 
@@ -63,12 +68,47 @@ public:
 	bool init(Menu *menu);
 	Button waitForPressedButton();
 	void repeatRateChanged();
-	Uint32 joystickRepeatCallback(Uint32 timeout, struct Joystick *joystick);
 	bool pollButton(Button *button);
 	bool getButton(Button *button, bool wait);
 
+	/**
+	 * Returns true iff the given button is currently held down, on the
+	 * keyboard or on any joystick. This reflects the events that have been
+	 * read so far, so it can be used to detect button combinations.
+	 */
+	bool isPressed(Button button) const;
+
+	/**
+	 * Removes the presses of the given button that directly follow in the
+	 * queue, as well as its due repeats, so that they can be handled before
+	 * the next frame is painted. Returns the number of presses removed.
+	 * Stops at the first event that is not about this button's key.
+	 */
+	unsigned int coalesce(Button button);
+
+	/**
+	 * Takes the buttons from the given replay instead of the input devices,
+	 * or from the devices again if nullptr.
+	 */
+	void setReplay(Replay *replay) { this->replay = replay; }
+
 private:
 	bool readConfFile(const std::string &conffile);
+	bool getReplayButton(Button *button, bool wait);
+
+	/**
+	 * Repeats the given button from the keyboard or a joystick until it is
+	 * released, or another button is pressed. The longer it is held, the
+	 * faster it repeats.
+	 */
+	void startRepeat(Button button);
+	void stopRepeat();
+	unsigned int repeatTimerExpired();
+	/**
+	 * Drops the due repeats if the repeated button has been released
+	 * meanwhile, even if its release event has not been read yet.
+	 */
+	void dropReleasedRepeats();
 
 	struct ButtonMapEntry {
 		bool kb_mapped, js_mapped;
@@ -79,11 +119,24 @@ private:
 	Menu *menu;
 
 	std::array<ButtonMapEntry, BUTTON_TYPE_SIZE> buttonMap;
+	Replay *replay;
+	/** Set once QUIT was reported; it is then reported for good. */
+	bool quitRequested;
+
+	using Clock = std::chrono::steady_clock;
+	TimerScheduler::TimerId repeatTimer;
+	/** Repeats per second to start with, 0 to not repeat. */
+	int repeatRate;
+	/** How many times the rate doubles, once per second held. */
+	int repeatAcceleration;
+	bool repeating;
+	Button repeatButton;
+	Clock::time_point repeatStart, lastRepeat;
+	/** Repeats that are due but not returned yet, and the fraction of one. */
+	unsigned int repeatsDue;
+	double repeatFraction;
 #ifndef SDL_JOYSTICK_DISABLED
 	std::vector<Joystick> joysticks;
-
-	void startTimer(Joystick *joystick);
-	void stopTimer(Joystick *joystick);
 #endif
 };
 
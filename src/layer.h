@@ -26,6 +26,13 @@ public:
 	 */
 	virtual bool runAnimations() { return false; }
 
+	/**
+	 * Returns true iff this layer takes all input while it is shown, so the
+	 * layers below it can only change by animating or by requesting a
+	 * repaint. Those layers are then painted once and reused.
+	 */
+	virtual bool isModal() const { return false; }
+
 	/**
 	 * Paints this layer on the given surface.
 	 */
@@ -37,6 +44,20 @@ public:
 	 */
 	virtual bool handleButtonPress(InputManager::Button button) = 0;
 
+	/**
+	 * Handles a number of presses of the same button in a row.
+	 * Layers that can take several steps at once should override this;
+	 * by default the presses are handled one by one.
+	 * Returns true iff the presses were fully handled by this layer.
+	 */
+	virtual bool handleButtonPress(InputManager::Button button,
+			unsigned int count) {
+		bool handled = false;
+		while (count--)
+			handled = handleButtonPress(button);
+		return handled;
+	}
+
 	Status getStatus() { return status; }
 
 protected:
@@ -22,9 +22,15 @@ Layout::~Layout()
 void Layout::run()
 {
 	top_item->updateAll();
-
-	lay_reset_context(&ctx);
-	top_item->populate(this);
+	if (!top_item->dirty)
+		return;
+
+	if (top_item->relink) {
+		lay_reset_context(&ctx);
+		top_item->populate(this);
+	} else {
+		top_item->updateNodes(this);
+	}
 	lay_run_context(&ctx);
 	top_item->readSettings(this);
 }
@@ -47,13 +53,69 @@ LayoutItem::LayoutItem()
 	c_flags = 0;
 	b_flags = 0;
 	visible = true;
+	parent = nullptr;
+	dirty = true;
+	relink = true;
 }
 
 LayoutItem::~LayoutItem()
 {
+	// Children may outlive us if they are referenced elsewhere.
+	for (auto it: items)
+		it->parent = nullptr;
 	setSize(0, 0);
 }
 
+void LayoutItem::setSize(lay_vec2 s)
+{
+	if (s[0] != size[0] || s[1] != size[1]) {
+		size = s;
+		markDirty();
+	}
+}
+
+void LayoutItem::setMargins(lay_vec4 m)
+{
+	if (m[0] != margins[0] || m[1] != margins[1]
+			|| m[2] != margins[2] || m[3] != margins[3]) {
+		margins = m;
+		markDirty();
+	}
+}
+
+void LayoutItem::setContainer(uint32_t flags)
+{
+	if (flags != c_flags) {
+		c_flags = flags;
+		markDirty();
+	}
+}
+
+void LayoutItem::setBehave(uint32_t flags)
+{
+	if (flags != b_flags) {
+		b_flags = flags;
+		markDirty();
+	}
+}
+
+void LayoutItem::markDirty(bool structure)
+{
+	// Ancestors of a dirty item are dirty already.
+	for (LayoutItem *item = this;
+			item && !(item->dirty && (item->relink || !structure));
+			item = item->parent) {
+		item->dirty = true;
+		item->relink |= structure;
+	}
+}
+
+void LayoutItem::attach(LayoutItem *child)
+{
+	child->parent = this;
+	markDirty(true);
+}
+
 void LayoutItem::populate(Layout *lay)
 {
 	lay_id previous = LAY_INVALID_ID;
@@ -76,6 +138,24 @@ void LayoutItem::populate(Layout *lay)
 		previous = it->id;
 	}
 
+	setNode(lay);
+}
+
+void LayoutItem::updateNodes(Layout *lay)
+{
+	if (dirty) {
+		setNode(lay);
+	} else if (!(b_flags & LAY_BREAK)) {
+		// Wrapping inserts breaks, which must not survive into this run;
+		// breaks set through setBehave() must.
+		lay_clear_item_break(&lay->ctx, id);
+	}
+	for (auto& it: items)
+		it->updateNodes(lay);
+}
+
+void LayoutItem::setNode(Layout *lay)
+{
 	lay_set_size(&lay->ctx, id, size);
 	lay_set_margins(&lay->ctx, id, margins);
 	lay_set_contain(&lay->ctx, id, c_flags);
@@ -84,6 +164,8 @@ void LayoutItem::populate(Layout *lay)
 
 void LayoutItem::readSettings(Layout *lay)
 {
+	dirty = relink = false;
+
 	if (1 || visible) {
 		rect = lay_get_rect(&lay->ctx, id);
 
@@ -113,6 +195,7 @@ void LayoutItem::renderAll(Surface& s) const
 void LayoutItem::addChild(std::shared_ptr<LayoutItem> child)
 {
 	items.push_back(child);
+	attach(child.get());
 }
 
 void LayoutItem::addSibling(std::shared_ptr<LayoutItem> item,
@@ -121,18 +204,24 @@ void LayoutItem::addSibling(std::shared_ptr<LayoutItem> item,
 	auto it = std::find(items.begin(), items.end(), item);
 
 	items.insert(++it, newSibling);
+	attach(newSibling.get());
 }
 
 void LayoutItem::removeChild(std::shared_ptr<LayoutItem> child)
 {
 	auto it = std::find(items.begin(), items.end(), child);
 
+	child->parent = nullptr;
 	items.erase(it);
+	markDirty(true);
 }
 
 void LayoutItem::removeChildren()
 {
+	for (auto it: items)
+		it->parent = nullptr;
 	items.clear();
+	markDirty(true);
 }
 
 LayoutSurface::LayoutSurface(std::shared_ptr<OffscreenSurface> s)
@@ -152,6 +241,15 @@ LayoutSurface::~LayoutSurface()
 {
 }
 
+void LayoutSurface::setSurface(std::shared_ptr<OffscreenSurface> s)
+{
+	surface = s;
+	if (s)
+		setSize(s->width(), s->height());
+	else
+		setSize(0, 0);
+}
+
 void LayoutSurface::render(Surface& s) const
 {
 	lay_vec4 r = getRect();
@@ -4,7 +4,7 @@
 #define LAYOUT_H
 
 #include <memory>
-#include <list>
+#include <vector>
 
 #include "layout/layout.h"
 
@@ -26,17 +26,21 @@ public:
 	void removeChild(std::shared_ptr<LayoutItem> child);
 	void removeChildren();
 
-	void setSize(lay_vec2 s) { size = s; }
+	void setSize(lay_vec2 s);
 	void setSize(short width, short height) {
-		size = (lay_vec2){width, height};
+		setSize((lay_vec2){width, height});
 	}
-	void setMargins(lay_vec4 m) { margins = m; }
+	void setMargins(lay_vec4 m);
 	void setMargins(short left, short top, short right, short bottom) {
-		margins = (lay_vec4){left, top, right, bottom};
+		setMargins((lay_vec4){left, top, right, bottom});
 	}
-	void setContainer(uint32_t flags) { c_flags = flags; }
-	void setBehave(uint32_t flags) { b_flags = flags; }
+	void setContainer(uint32_t flags);
+	void setBehave(uint32_t flags);
 
+	/*
+	 * Hidden items keep their space in the layout, so changing the
+	 * visibility does not require the layout to be solved again.
+	 */
 	void setVisible(bool v) { visible = v; }
 	void show() { visible = true; }
 	void hide() { visible = false; }
@@ -47,13 +51,28 @@ public:
 	lay_vec4 getRect() const { return rect; }
 
 protected:
+	/*
+	 * Marks this item, and thereby the whole layout, as changed. Structural
+	 * changes (adding or removing items) require the nodes of the layout to
+	 * be rebuilt; other changes are applied to the existing nodes.
+	 */
+	void markDirty(bool structure = false);
+
 	/* Ask this layout item to render itself to its coordinates */
 	virtual void render(Surface& s) const {}
 
-	std::list<std::shared_ptr<LayoutItem> > items;
+	std::vector<std::shared_ptr<LayoutItem> > items;
 
 private:
+	/* Handle of this item's node in the layout context; stays valid until
+	 * the structure of the layout changes. */
 	lay_id id;
+	LayoutItem *parent;
+	/* Set when this item or one of its descendants changed since the
+	 * layout was last solved. */
+	bool dirty;
+	/* Set when items were added or removed in this subtree since then. */
+	bool relink;
 
 	lay_vec2 size;
 	lay_vec4 rect;
@@ -63,7 +82,10 @@ private:
 	bool visible;
 
 	void populate(Layout *lay);
+	void updateNodes(Layout *lay);
+	void setNode(Layout *lay);
 	void readSettings(Layout *lay);
+	void attach(LayoutItem *child);
 
 	void updateAll();
 	void renderAll(Surface& s) const;
@@ -75,11 +97,13 @@ private:
 class LayoutSurface : public LayoutItem {
 public:
 
-	LayoutSurface(std::shared_ptr<OffscreenSurface> s);
+	LayoutSurface(std::shared_ptr<OffscreenSurface> s = nullptr);
 	LayoutSurface(OffscreenSurface *s);
 	~LayoutSurface();
 
 	std::shared_ptr<OffscreenSurface> getSurface() const { return surface; }
+	/* Replaces the surface in place, resizing the item to fit it. */
+	void setSurface(std::shared_ptr<OffscreenSurface> s);
 
 protected:
 	void render(Surface& s) const;
@@ -97,6 +121,12 @@ public:
 
 	std::shared_ptr<LayoutItem> topItem() const;
 
+	/*
+	 * Updates the items and, if any of them changed since the last call,
+	 * solves the layout again; otherwise the previous rects are kept.
+	 * The nodes of the layout context are only rebuilt when items were
+	 * added or removed.
+	 */
 	void run();
 	void render(Surface& s) const;
 
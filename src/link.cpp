@@ -21,11 +21,14 @@
 #include "link.h"
 
 #include "gmenu2x.h"
+#include "imageio.h"
 #include "menu.h"
 #include "selector.h"
 #include "surface.h"
+#include "textrenderer.h"
 #include "utilities.h"
 
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 
@@ -53,23 +56,47 @@ void Link::updateTextSurfaces() {
 
 void Link::updateTitleSurface() {
 	if (!title.empty()) {
-		titleSurface = gmenu2x.font->render(title);
+		titleText = gmenu2x.textRenderer->render(title);
 	} else {
+		titleText = nullptr;
 		titleSurface = nullptr;
 	}
 }
 
 void Link::updateDescriptionSurface() {
 	if (!description.empty()) {
-		descriptionSurface = gmenu2x.font->render(description);
+		descriptionText = gmenu2x.textRenderer->render(description);
 	} else {
+		descriptionText = nullptr;
 		descriptionSurface = nullptr;
 	}
 }
 
-void Link::paint() {
+void Link::paintText(Surface& s, shared_ptr<RenderedText> &text,
+		shared_ptr<OffscreenSurface> &surface,
+		const string &str, int center_x, int bottom_y) {
+	if (text && text->ready()) {
+		surface = text->surface();
+		text = nullptr;
+	}
+
+	if (surface) {
+		SDL_Rect coords = {
+			static_cast<Sint16>(center_x), static_cast<Sint16>(bottom_y), 0, 0
+		};
+		surface->blit(s, coords, Font::HAlignCenter, Font::VAlignBottom);
+	} else if (text) {
+		// Cheap stand-in until the text is rendered: a faint bar as wide
+		// as the text will be.
+		const int width = gmenu2x.font->getTextWidth(str);
+		const int height = gmenu2x.font->getLineSpacing();
+		s.box(center_x - width / 2, bottom_y - height * 2 / 3,
+				width, max(height / 4, 1), 255, 255, 255, 64);
+	}
+}
+
+void Link::paint(Surface& s) {
 	uint32_t iconX, padding;
-	Surface& s = *gmenu2x.s;
 
 	iconX = rect.x + (rect.w - iconSurface->width()) / 2;
 	padding = (gmenu2x.skinConfInt["linkHeight"] - iconSurface->height()
@@ -79,36 +106,21 @@ void Link::paint() {
 		iconSurface->blit(s, iconX, rect.y + padding);
 	}
 
-	SDL_Rect coords = {
-		static_cast<Sint16>(rect.x + rect.w / 2),
-		static_cast<Sint16>(rect.y + gmenu2x.skinConfInt["linkHeight"] - padding),
-		0, 0
-	};
-
-	titleSurface->blit(s, coords, Font::HAlignCenter, Font::VAlignBottom);
+	paintText(s, titleText, titleSurface, title, rect.x + rect.w / 2,
+			rect.y + gmenu2x.skinConfInt["linkHeight"] - padding);
 }
 
-void Link::paintHover() {
-	Surface& s = *gmenu2x.s;
-
+void Link::paintHover(Surface& s) {
 	if (gmenu2x.useSelectionPng)
 		gmenu2x.sc["imgs/selection.png"]->blit(s, rect, Font::HAlignCenter, Font::VAlignMiddle);
 	else
 		s.box(rect.x, rect.y, rect.w, rect.h, gmenu2x.skinConfColors[COLOR_SELECTION_BG]);
 }
 
-void Link::paintDescription(int center_x, int center_y)
+void Link::paintDescription(Surface& s, int center_x, int center_y)
 {
-	SDL_Rect coords = {
-		static_cast<Sint16>(center_x),
-		static_cast<Sint16>(center_y),
-		0, 0
-	};
-
-	if (descriptionSurface != nullptr) {
-		descriptionSurface->blit(*gmenu2x.s, coords,
-				  Font::HAlignCenter, Font::VAlignBottom);
-	}
+	paintText(s, descriptionText, descriptionSurface, description,
+			center_x, center_y);
 }
 
 void Link::updateSurfaces()
@@ -129,6 +141,7 @@ const string &Link::getTitle() const {
 
 void Link::setTitle(const string &title) {
 	this->title = title;
+	titleSurface = nullptr;
 	updateTitleSurface();
 	edited = true;
 }
@@ -139,6 +152,7 @@ const string &Link::getDescription() const {
 
 void Link::setDescription(const string &description) {
 	this->description = description;
+	descriptionSurface = nullptr;
 	updateDescriptionSurface();
 	edited = true;
 }
@@ -181,7 +195,7 @@ const string &Link::getIconPath() {
 }
 
 void Link::setIconPath(const string &icon) {
-	if (fileExists(icon))
+	if (imageFileExists(icon))
 		iconPath = icon;
 	else
 		iconPath = gmenu2x.sc.getSkinFilePath("icons/generic.png");
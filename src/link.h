@@ -29,6 +29,8 @@
 
 class GMenu2X;
 class OffscreenSurface;
+class RenderedText;
+class Surface;
 
 
 /**
@@ -43,9 +45,9 @@ public:
 	Link(GMenu2X& gmenu2x, Action action);
 	virtual ~Link() {};
 
-	virtual void paint();
-	void paintHover();
-	void paintDescription(int center_x, int center_y);
+	virtual void paint(Surface& s);
+	void paintHover(Surface& s);
+	void paintDescription(Surface& s, int center_x, int center_y);
 
 	virtual void loadIcon();
 
@@ -73,6 +75,9 @@ protected:
 	std::shared_ptr<OffscreenSurface> iconSurface;
 	std::shared_ptr<OffscreenSurface> titleSurface;
 	std::shared_ptr<OffscreenSurface> descriptionSurface;
+	/** Texts that are being rendered; the surfaces above keep showing
+	  * the previous rendering, if any, until these are ready. */
+	std::shared_ptr<RenderedText> titleText, descriptionText;
 
 	virtual const std::string &searchIcon();
 	void setIconPath(const std::string &icon);
@@ -81,6 +86,9 @@ protected:
 private:
 	void updateTitleSurface();
 	void updateDescriptionSurface();
+	void paintText(Surface& s, std::shared_ptr<RenderedText> &text,
+			std::shared_ptr<OffscreenSurface> &surface,
+			const std::string &str, int center_x, int bottom_y);
 
 	Action action;
 
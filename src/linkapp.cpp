@@ -22,7 +22,10 @@
 
 #include "debug.h"
 #include "buildopts.h"
+#include "document.h"
 #include "gmenu2x.h"
+#include "imageio.h"
+#include "imagemanualdialog.h"
 #include "launcher.h"
 #include "layer.h"
 #include "menu.h"
@@ -65,6 +68,10 @@ class LaunchLayer: public Layer {
 public:
 	LaunchLayer(LinkApp& app) : app(app) {}
 
+	bool isModal() const override {
+		return true;
+	}
+
 	void paint(Surface &s) override {
 		app.drawLaunch(s);
 	}
@@ -102,6 +109,8 @@ LinkApp::LinkApp(GMenu2X& gmenu2x, string const& linkfile, bool deletable)
 	edited = false;
 
 	bool appTakesFileArg = true;
+	// Keys of the localized fields, built once instead of for every field.
+	const string lng(gmenu2x.tr.get("Lng"));
 #ifdef HAVE_LIBOPK
 	isOPK = !!opk;
 
@@ -121,6 +130,8 @@ LinkApp::LinkApp(GMenu2X& gmenu2x, string const& linkfile, bool deletable)
 		appTakesFileArg = false;
 		category = "applications";
 
+		const string nameKey = "Name[" + lng + "]";
+		const string commentKey = "Comment[" + lng + "]";
 		while ((ret = opk_read_pair(opk, &key, &lkey, &val, &lval))) {
 			if (ret < 0) {
 				ERROR("Unable to read meta-data\n");
@@ -138,13 +149,11 @@ LinkApp::LinkApp(GMenu2X& gmenu2x, string const& linkfile, bool deletable)
 					category = category.substr(0, pos);
 
 			} else if ((!strncmp(key, "Name", lkey) && getTitle().empty())
-						|| !strncmp(key, ("Name[" + gmenu2x.tr["Lng"] +
-								"]").c_str(), lkey)) {
+						|| !strncmp(key, nameKey.c_str(), lkey)) {
 				setTitle(buf);
 
 			} else if ((!strncmp(key, "Comment", lkey) && getDescription().empty())
-						|| !strncmp(key, ("Comment[" +
-								gmenu2x.tr["Lng"] + "]").c_str(), lkey)) {
+						|| !strncmp(key, commentKey.c_str(), lkey)) {
 				setDescription(buf);
 
 			} else if (!strncmp(key, "Terminal", lkey)) {
@@ -220,6 +229,9 @@ LinkApp::LinkApp(GMenu2X& gmenu2x, string const& linkfile, bool deletable)
 		editable = deletable;
 	}
 
+	const string titleKey = "title[" + lng + "]";
+	const string descriptionKey = "description[" + lng + "]";
+	const string launchMsgKey = "launchmsg[" + lng + "]";
 	string line;
 	ifstream infile (file.c_str(), ios_base::in);
 	while (getline(infile, line, '\n')) {
@@ -240,15 +252,15 @@ LinkApp::LinkApp(GMenu2X& gmenu2x, string const& linkfile, bool deletable)
 		} else if (!isOpk()) {
 			if (name == "title" && getTitle().empty()) {
 				setTitle(value);
-			} else if (name == "title[" + gmenu2x.tr["Lng"] +"]") {
+			} else if (name == titleKey) {
 				setTitle(value);
 			} else if (name == "description" && getDescription().empty()) {
 				setDescription(value);
-			} else if (name == "description[" + gmenu2x.tr["Lng"] +"]") {
+			} else if (name == descriptionKey) {
 				setDescription(value);
 			} else if (name == "launchmsg" && launchMsg.empty()) {
 				launchMsg = value;
-			} else if (name == "launchmsg[" + gmenu2x.tr["Lng"] +"]") {
+			} else if (name == launchMsgKey) {
 				launchMsg = value;
 			} else if (name == "icon") {
 				setIcon(value);
@@ -279,12 +291,12 @@ void LinkApp::loadIcon() {
 	if (icon.compare(0, 5, "skin:") == 0) {
 		string linkIcon = gmenu2x.sc.getSkinFilePath(
 				icon.substr(5));
-		if (!fileExists(linkIcon))
+		if (!imageFileExists(linkIcon))
 			searchIcon();
 		else
 			setIconPath(linkIcon);
 
-	} else if (!fileExists(icon)) {
+	} else if (!imageFileExists(icon)) {
 		searchIcon();
 	}
 }
@@ -304,7 +316,7 @@ const string &LinkApp::searchIcon() {
 
 	if (!gmenu2x.sc.getSkinFilePath("icons/"+exectitle).empty())
 		iconPath = gmenu2x.sc.getSkinFilePath("icons/"+exectitle);
-	else if (fileExists(execicon))
+	else if (imageFileExists(execicon))
 		iconPath = execicon;
 	else
 		iconPath = gmenu2x.sc.getSkinFilePath("icons/generic.png");
@@ -413,29 +425,13 @@ void LinkApp::showManual() {
 
 #ifdef HAVE_LIBOPK
 	if (isOPK) {
-		struct OPK *opk = opk_open(opkFile.c_str());
-		if (!opk) {
-			WARNING("Unable to open OPK to read manual\n");
-			return;
-		}
-
-		void *buf;
-		size_t len;
-		int err = opk_extract_file(opk, manual.c_str(), &buf, &len);
-		opk_close(opk);
-		if (err < 0) {
-			WARNING("Unable to extract manual from OPK\n");
-			return;
-		}
-		string str((char *) buf, len);
-		free(buf);
-
+		auto document = Document::open(opkFile + "#" + manual);
 		if (manual.substr(manual.size()-8,8)==".man.txt") {
-			TextManualDialog tmd(gmenu2x, getTitle(), getIconPath(), str);
-			tmd.exec();
+			gmenu2x.pushLayer(make_shared<TextManualDialog>(
+					gmenu2x, getTitle(), getIconPath(), document));
 		} else {
-			TextDialog td(gmenu2x, getTitle(), "ReadMe", getIconPath(), str);
-			td.exec();
+			gmenu2x.pushLayer(make_shared<TextDialog>(
+					gmenu2x, getTitle(), "ReadMe", getIconPath(), document));
 		}
 		return;
 	}
@@ -445,115 +441,41 @@ void LinkApp::showManual() {
 
 	// Png manuals
 	if (manual.substr(manual.size()-8,8)==".man.png") {
-		auto pngman = OffscreenSurface::loadImage(gmenu2x, manual);
-		if (!pngman) {
-			return;
+		auto dialog = make_shared<ImageManualDialog>(gmenu2x, manual);
+		if (dialog->pageCount()) {
+			gmenu2x.pushLayer(dialog);
 		}
-		auto bg = OffscreenSurface::loadImage(gmenu2x, gmenu2x.confStr["wallpaper"]);
-		if (!bg) {
-			bg = OffscreenSurface::emptySurface(gmenu2x, gmenu2x.width(), gmenu2x.height());
-		}
-		bg->convertToDisplayFormat();
-
-		stringstream ss;
-		string pageStatus;
-
-		bool close = false, repaint = true;
-		int page = 0, pagecount = pngman->width() / gmenu2x.width();
-
-		ss << pagecount;
-		string spagecount;
-		ss >> spagecount;
-
-		while (!close) {
-			OutputSurface& s = *gmenu2x.s;
-
-			if (repaint) {
-				bg->blit(s, 0, 0);
-				pngman->blit(s, -page * gmenu2x.width(), 0);
-
-				gmenu2x.drawBottomBar(s);
-				int x = 5;
-				x = gmenu2x.drawButton(s, "left", "", x);
-				x = gmenu2x.drawButton(s, "right", gmenu2x.tr["Change page"], x);
-				x = gmenu2x.drawButton(s, "cancel", "", x);
-				x = gmenu2x.drawButton(s, "start", gmenu2x.tr["Exit"], x);
-				(void)x;
-
-				ss.clear();
-				ss << page+1;
-				ss >> pageStatus;
-				pageStatus = gmenu2x.tr["Page"]+": "+pageStatus+"/"+spagecount;
-				gmenu2x.font->write(s, pageStatus,
-						    gmenu2x.width() - 10,
-						    gmenu2x.height() - 10,
-						    Font::HAlignRight,
-						    Font::VAlignMiddle);
-
-				s.flip();
-				repaint = false;
-			}
-
-            switch(gmenu2x.input.waitForPressedButton()) {
-				case InputManager::SETTINGS:
-                case InputManager::CANCEL:
-                    close = true;
-                    break;
-                case InputManager::LEFT:
-                    if (page > 0) {
-                        page--;
-                        repaint = true;
-                    }
-                    break;
-                case InputManager::RIGHT:
-                    if (page < pagecount-1) {
-                        page++;
-                        repaint=true;
-                    }
-                    break;
-                default:
-                    break;
-            }
-        }
 		return;
 	}
 
 	// Txt manuals
 	if (manual.substr(manual.size()-8,8)==".man.txt") {
-		string text(readFileAsString(manual));
-		TextManualDialog tmd(gmenu2x, getTitle(), getIconPath(), text);
-		tmd.exec();
+		gmenu2x.pushLayer(make_shared<TextManualDialog>(
+				gmenu2x, getTitle(), getIconPath(), Document::open(manual)));
 		return;
 	}
 
 	//Readmes
-	string str, line;
-	ifstream infile(manual.c_str(), ios_base::in);
-	if (infile.is_open()) {
-		while (getline(infile, line, '\n')) {
-			str.append(line).append("\n");
-		}
-		infile.close();
-
-		TextDialog td(gmenu2x, getTitle(), "ReadMe", getIconPath(), str);
-		td.exec();
-	}
+	gmenu2x.pushLayer(make_shared<TextDialog>(
+			gmenu2x, getTitle(), "ReadMe", getIconPath(),
+			Document::open(manual)));
 }
 
 void LinkApp::selector(int startSelection, const string &selectorDir) {
 	//Run selector interface
-	Selector sel(gmenu2x, *this, selectorDir);
-	int selection = sel.exec(startSelection);
-	if (selection!=-1) {
-		const string &selectedDir = sel.getDir();
+	auto sel = make_shared<Selector>(
+			gmenu2x, *this, selectorDir, startSelection);
+	sel->setOnSelect([this](int selection, const string &selectedDir,
+				const string &file) {
 		if (!selectedDir.empty()) {
 			selectordir = selectedDir;
 		}
 		gmenu2x.writeTmp(selection, selectedDir);
 		gmenu2x.queueLaunch(
-				prepareLaunch(selectedDir + sel.getFile()),
+				prepareLaunch(selectedDir + file),
 				make_shared<LaunchLayer>(*this));
-	}
+	});
+	gmenu2x.pushLayer(sel);
 }
 
 unique_ptr<Launcher> LinkApp::prepareLaunch(const string &selectedFile) {
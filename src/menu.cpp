@@ -38,6 +38,7 @@
 
 #include "buildopts.h"
 #include "gmenu2x.h"
+#include "imageio.h"
 #include "linkapp.h"
 #include "menu.h"
 #include "monitor.h"
@@ -104,8 +105,6 @@ Menu::Menu(GMenu2X& gmenu2x)
 
 	btnContextMenu.setPosition(gmenu2x.width() - 38,
 				   gmenu2x.bottomBarIconY);
-
-	updateSectionTextSurfaces();
 }
 
 Menu::~Menu()
@@ -167,14 +166,16 @@ void Menu::fontChanged() {
 	for (auto &section_links : links)
 		for (auto& link : section_links)
 			link->updateTextSurfaces();
-	updateSectionTextSurfaces();
+	// Rendered again when next painted.
+	for (auto& surface : section_text_surfaces)
+		surface.reset();
 }
 
-void Menu::updateSectionTextSurfaces() {
-	const auto &font = *gmenu2x.font;
-	section_text_surfaces.resize(sections.size());
-	for (std::size_t i = 0; i < sections.size(); ++i)
-		section_text_surfaces[i] = font.render(gmenu2x.tr[sections[i]]);
+shared_ptr<OffscreenSurface> Menu::sectionTextSurface(std::size_t section) {
+	auto& surface = section_text_surfaces[section];
+	if (!surface)
+		surface = gmenu2x.font->render(gmenu2x.tr.get(sections[section]));
+	return surface;
 }
 
 void Menu::calcSectionRange(int &leftSection, int &rightSection) {
@@ -247,12 +248,14 @@ void Menu::paint(Surface &s) {
 		icon->blit(s, x - 16 * uiScale, sectionLinkPadding);
 
 		// Center text horizontally and align to bottom.
-		auto text_surface = section_text_surfaces[j];
-		text_surface->blit(
-			s,
-			x - text_surface->width() / 2,
-			topBarHeight - sectionLinkPadding - text_surface->height()
-		);
+		auto text_surface = sectionTextSurface(j);
+		if (text_surface) {
+			text_surface->blit(
+				s,
+				x - text_surface->width() / 2,
+				topBarHeight - sectionLinkPadding - text_surface->height()
+			);
+		}
 	}
 
 	if (!gmenu2x.skinConfInt["hideLR"]) {
@@ -266,7 +269,7 @@ void Menu::paint(Surface &s) {
 
 	auto& sectionLinks = links[iSection];
 	auto numLinks = sectionLinks.size();
-	gmenu2x.drawScrollBar(
+	gmenu2x.drawScrollBar(s,
 			linkRows, (numLinks + linkColumns - 1) / linkColumns, iFirstDispRow);
 
 	//Links
@@ -283,14 +286,14 @@ void Menu::paint(Surface &s) {
 		sectionLinks.at(i)->setPosition(x, y);
 
 		if (i == (uint32_t)iLink) {
-			sectionLinks.at(i)->paintHover();
+			sectionLinks.at(i)->paintHover(s);
 		}
 
-		sectionLinks.at(i)->paint();
+		sectionLinks.at(i)->paint(s);
 	}
 
 	if (selLink())
-		selLink()->paintDescription(width / 2, height - bottomBarHeight + 2);
+		selLink()->paintDescription(s, width / 2, height - bottomBarHeight + 2);
 
 	LinkApp *linkApp = selLinkApp();
 	if (linkApp && linkApp->isEditable()) {
@@ -394,7 +397,7 @@ void Menu::addActionLink(uint32_t section, string const& title, Action action,
 	if (gmenu2x.sc.exists(icon)
 			|| (icon.substr(0,5)=="skin:"
 				&& !gmenu2x.sc.getSkinFilePath(icon.substr(5)).empty())
-			|| fileExists(icon)) {
+			|| imageFileExists(icon)) {
 		link->setIcon(icon);
 	}
 
@@ -453,12 +456,14 @@ bool Menu::addLink(string const& path, string const& file)
 	INFO("Manual: '%s'\n", manual.c_str());
 
 	string shorttitle=title, description="", exec=dirPath+file, icon="";
-	if (fileExists(exename+".png")) icon = exename+".png";
+	if (imageFileExists(exename+".png")) icon = exename+".png";
 
 	//Reduce title lenght to fit the link width
-	if (gmenu2x.font->getTextWidth(shorttitle)>gmenu2x.skinConfInt["linkWidth"]) {
-		while (gmenu2x.font->getTextWidth(shorttitle+"..")>gmenu2x.skinConfInt["linkWidth"])
-			shorttitle = shorttitle.substr(0,shorttitle.length()-1);
+	const int linkWidth = gmenu2x.skinConfInt["linkWidth"];
+	if (gmenu2x.font->getTextWidth(shorttitle) > linkWidth) {
+		const int dotsWidth = gmenu2x.font->getTextWidth("..");
+		shorttitle.resize(gmenu2x.font->getFittingLength(
+				shorttitle, max(0, linkWidth - dotsWidth)));
 		shorttitle += "..";
 	}
 
@@ -492,13 +497,12 @@ int Menu::sectionNamed(const char *sectionName)
 	int idx = it - sections.begin();
 	if (it == sections.end() || *it != sectionName) {
 		sections.emplace(it, sectionName);
+		section_text_surfaces.emplace(section_text_surfaces.begin() + idx);
 		links.emplace(links.begin() + idx);
 		// Make sure the selected section doesn't change.
 		if (idx <= iSection) {
 			iSection++;
 		}
-
-		updateSectionTextSurfaces();
 	}
 	return idx;
 }
@@ -536,6 +540,7 @@ void Menu::deleteSelectedSection()
 	auto idx = selSectionIndex();
 	links.erase(links.begin() + idx);
 	sections.erase(sections.begin() + idx);
+	section_text_surfaces.erase(section_text_surfaces.begin() + idx);
 	setSectionIndex(0); //reload sections
 
 	string path = GMenu2X::getHome() + "/sections/" + sectionName;
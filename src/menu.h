@@ -59,6 +59,7 @@ private:
 	int iSection, iLink;
 	uint32_t iFirstDispRow;
 	std::vector<std::string> sections;
+	/** Rendered section names; null until first painted. */
 	std::vector<std::shared_ptr<OffscreenSurface>> section_text_surfaces;
 	std::vector<std::vector<std::unique_ptr<Link>>> links;
 
@@ -104,7 +105,7 @@ private:
 	void linkUp();
 	void linkDown();
 
-	void updateSectionTextSurfaces();
+	std::shared_ptr<OffscreenSurface> sectionTextSurface(std::size_t section);
 public:
 	typedef std::function<void(void)> Action;
 
@@ -26,8 +26,8 @@
 
 using std::string;
 
-MenuSetting::MenuSetting(GMenu2X& gmenu2x, const string &name,
-		const string &description)
+MenuSetting::MenuSetting(GMenu2X& gmenu2x, compat::string_view name,
+		compat::string_view description)
 	: gmenu2x(gmenu2x)
 	, name(name)
 	, description(description)
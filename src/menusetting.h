@@ -21,6 +21,7 @@
 #define MENUSETTING_H
 
 #include "buttonbox.h"
+#include "compat-string_view.h"
 #include "inputmanager.h"
 
 #include <string>
@@ -40,8 +41,8 @@ protected:
 
 public:
 	MenuSetting(
-			GMenu2X& gmenu2x, const std::string &name,
-			const std::string &description);
+			GMenu2X& gmenu2x, compat::string_view name,
+			compat::string_view description);
 	virtual ~MenuSetting();
 
 	virtual void draw(int valueX, int y, int h);
@@ -33,7 +33,7 @@ using std::unique_ptr;
 
 MenuSettingBool::MenuSettingBool(
 		GMenu2X& gmenu2x,
-		const string &name, const string &description, int *value)
+		compat::string_view name, compat::string_view description, int *value)
 	: MenuSetting(gmenu2x, name, description)
 {
 	_ivalue = value;
@@ -45,7 +45,7 @@ MenuSettingBool::MenuSettingBool(
 
 MenuSettingBool::MenuSettingBool(
 		GMenu2X& gmenu2x,
-		const string &name, const string &description, bool *value)
+		compat::string_view name, compat::string_view description, bool *value)
 	: MenuSetting(gmenu2x, name, description)
 {
 	_value = value;
@@ -38,11 +38,11 @@ private:
 public:
 	MenuSettingBool(
 			GMenu2X& gmenu2x,
-			const std::string &name, const std::string &description,
+			compat::string_view name, compat::string_view description,
 			bool *value);
 	MenuSettingBool(
 			GMenu2X& gmenu2x,
-			const std::string &name, const std::string &description,
+			compat::string_view name, compat::string_view description,
 			int *value);
 	virtual ~MenuSettingBool() {}
 
@@ -25,12 +25,13 @@
 #include "iconbutton.h"
 
 using std::bind;
+using std::make_shared;
 using std::string;
 using std::unique_ptr;
 
 MenuSettingDir::MenuSettingDir(
 		GMenu2X& gmenu2x,
-		const string &name, const string &description, string *value)
+		compat::string_view name, compat::string_view description, string *value)
 	: MenuSettingStringBase(gmenu2x, name, description, value)
 {
 	buttonBox.add(unique_ptr<IconButton>(new IconButton(
@@ -46,6 +47,9 @@ MenuSettingDir::MenuSettingDir(
 
 void MenuSettingDir::edit()
 {
-	DirDialog dd(gmenu2x, description, value());
-	if (dd.exec()) setValue(dd.getPath());
+	auto dd = make_shared<DirDialog>(gmenu2x, description, value());
+	dd->setOnConfirm([this](const string &path, const string &) {
+		setValue(path);
+	});
+	gmenu2x.runModal(dd);
 }
@@ -29,7 +29,7 @@ protected:
 public:
 	MenuSettingDir(
 			GMenu2X& gmenu2x,
-			const std::string &name, const std::string &description,
+			compat::string_view name, compat::string_view description,
 			std::string *value);
 	virtual ~MenuSettingDir() {}
 };
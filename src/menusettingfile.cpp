@@ -25,12 +25,13 @@
 #include "iconbutton.h"
 
 using std::bind;
+using std::make_shared;
 using std::string;
 using std::unique_ptr;
 
 MenuSettingFile::MenuSettingFile(
 		GMenu2X& gmenu2x,
-		const string &name, const string &description,
+		compat::string_view name, compat::string_view description,
 		string *value, const string &filter_)
 	: MenuSettingStringBase(gmenu2x, name, description, value)
 	, filter(filter_)
@@ -48,8 +49,9 @@ MenuSettingFile::MenuSettingFile(
 
 void MenuSettingFile::edit()
 {
-	FileDialog fd(gmenu2x, description, filter, value());
-	if (fd.exec()) {
-		setValue(fd.getPath() + "/" + fd.getFile());
-	}
+	auto fd = make_shared<FileDialog>(gmenu2x, description, filter, value());
+	fd->setOnConfirm([this](const string &path, const string &file) {
+		setValue(path + "/" + file);
+	});
+	gmenu2x.runModal(fd);
 }
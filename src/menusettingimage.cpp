@@ -24,19 +24,23 @@
 #include "imagedialog.h"
 #include "utilities.h"
 
+using std::make_shared;
 using std::string;
 
 MenuSettingImage::MenuSettingImage(
 		GMenu2X& gmenu2x,
-		const string &name, const string &description,
+		compat::string_view name, compat::string_view description,
 		string *value, const string &filter)
 	: MenuSettingFile(gmenu2x, name, description, value, filter)
 {
 }
 
 void MenuSettingImage::edit() {
-	ImageDialog id(gmenu2x, description, filter, value());
-	if (id.exec()) setValue(id.getPath() + "/" + id.getFile());
+	auto id = make_shared<ImageDialog>(gmenu2x, description, filter, value());
+	id->setOnConfirm([this](const string &path, const string &file) {
+		setValue(path + "/" + file);
+	});
+	gmenu2x.runModal(id);
 }
 
 void MenuSettingImage::setValue(const string &value) {
@@ -28,7 +28,7 @@ protected:
 
 public:
 	MenuSettingImage(GMenu2X& gmenu2x,
-			const std::string &name, const std::string &description,
+			compat::string_view name, compat::string_view description,
 			std::string *value, const std::string &filter = "");
 	virtual ~MenuSettingImage() {}
 
@@ -35,7 +35,7 @@ using std::unique_ptr;
 
 MenuSettingInt::MenuSettingInt(
 		GMenu2X& gmenu2x,
-		const string &name, const string &description,
+		compat::string_view name, compat::string_view description,
 		int *value, int min, int max, int increment)
 	: MenuSetting(gmenu2x, name, description)
 {
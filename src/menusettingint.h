@@ -37,7 +37,7 @@ private:
 public:
 	MenuSettingInt(
 			GMenu2X& gmenu2x,
-			const std::string &name, const std::string &description,
+			compat::string_view name, compat::string_view description,
 			int *value, int min, int max, int increment = 1);
 	virtual ~MenuSettingInt() {}
 
@@ -32,7 +32,7 @@ using std::unique_ptr;
 
 MenuSettingMultiString::MenuSettingMultiString(
 		GMenu2X& gmenu2x,
-		const string &name, const string &description,
+		compat::string_view name, compat::string_view description,
 		string *value, const vector<string> *choices_)
 	: MenuSettingStringBase(gmenu2x, name, description, value)
 	, choices(choices_)
@@ -41,7 +41,7 @@ private:
 public:
 	MenuSettingMultiString(
 			GMenu2X& gmenu2x,
-			const std::string &name, const std::string &description,
+			compat::string_view name, compat::string_view description,
 			std::string *value, const std::vector<std::string> *choices);
 	virtual ~MenuSettingMultiString() {};
 
@@ -36,7 +36,7 @@ constexpr unsigned int COMPONENT_WIDTH = 28;
 
 MenuSettingRGBA::MenuSettingRGBA(
 		GMenu2X& gmenu2x,
-		const string &name, const string &description, RGBAColor *value)
+		compat::string_view name, compat::string_view description, RGBAColor *value)
 	: MenuSetting(gmenu2x, name, description)
 {
 	edit = false;
@@ -46,7 +46,7 @@ private:
 public:
 	MenuSettingRGBA(
 			GMenu2X& gmenu2x,
-			const std::string &name, const std::string &description,
+			compat::string_view name, compat::string_view description,
 			RGBAColor *value);
 	virtual ~MenuSettingRGBA() {};
 
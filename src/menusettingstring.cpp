@@ -30,7 +30,7 @@ using std::unique_ptr;
 
 MenuSettingString::MenuSettingString(
 		GMenu2X& gmenu2x,
-		const string &name, const string &description, string *value,
+		compat::string_view name, compat::string_view description, string *value,
 		const string &diagTitle_, const string &diagIcon_)
 	: MenuSettingStringBase(gmenu2x, name, description, value)
 	, diagTitle(diagTitle_)
@@ -30,8 +30,8 @@ protected:
 
 public:
 	MenuSettingString(
-			GMenu2X& gmenu2x, const std::string &name,
-			const std::string &description, std::string *value,
+			GMenu2X& gmenu2x, compat::string_view name,
+			compat::string_view description, std::string *value,
 			const std::string &diagTitle = "",
 			const std::string &diagIcon = "");
 	virtual ~MenuSettingString() {}
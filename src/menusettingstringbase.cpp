@@ -25,8 +25,8 @@
 using std::string;
 
 MenuSettingStringBase::MenuSettingStringBase(
-		GMenu2X& gmenu2x, const string &name,
-		const string &description, string *value)
+		GMenu2X& gmenu2x, compat::string_view name,
+		compat::string_view description, string *value)
 	: MenuSetting(gmenu2x, name, description)
 	, originalValue(*value)
 	, _value(value)
@@ -33,8 +33,8 @@ protected:
 
 public:
 	MenuSettingStringBase(
-			GMenu2X& gmenu2x, const std::string &name,
-			const std::string &description, std::string *value);
+			GMenu2X& gmenu2x, compat::string_view name,
+			compat::string_view description, std::string *value);
 	virtual ~MenuSettingStringBase();
 
 	virtual void draw(int valueX, int y, int h);
@@ -22,10 +22,7 @@
 #include "gmenu2x.h"
 #include "surface.h"
 
-#include <chrono>
-#include <thread>
 #include <algorithm>
-#include <unistd.h>
 
 using namespace std;
 
@@ -33,17 +30,11 @@ constexpr unsigned int ICON_PADDING = 6;
 constexpr unsigned int TEXT_PADDING = 8;
 constexpr unsigned int ICON_DIMENSION = 32;
 
-MessageBox::MessageBox(GMenu2X& gmenu2x, const string &text, const string &icon)
+MessageBox::MessageBox(GMenu2X& gmenu2x, compat::string_view text, const string &icon)
 	: gmenu2x(gmenu2x)
 	, text(text)
 	, icon(icon)
 {
-	for (uint32_t i = 0; i < InputManager::BUTTON_TYPE_SIZE; i++) {
-		buttons[i] = "";
-		buttonLabels[i] = "";
-		buttonPositions[i].h = gmenu2x.font->getLineSpacing();
-	}
-
 	//Default enabled button
 	buttons[InputManager::ACCEPT] = "OK";
 
@@ -60,15 +51,15 @@ MessageBox::MessageBox(GMenu2X& gmenu2x, const string &text, const string &icon)
 	buttonLabels[InputManager::MENU] = "select";
 }
 
-void MessageBox::setButton(InputManager::Button button, const string &label) {
+void MessageBox::setButton(InputManager::Button button,
+		compat::string_view label, Action action) {
 	buttons[button] = label;
+	actions[button] = std::move(action);
 }
 
-int MessageBox::exec() {
-	OutputSurface& s = *gmenu2x.s;
-	OffscreenSurface bg(s);
+void MessageBox::paint(Surface& s) {
 	//Darken background
-	bg.box(0, 0, gmenu2x.width(), gmenu2x.height(), 0,0,0,200);
+	s.box(0, 0, gmenu2x.width(), gmenu2x.height(), 0,0,0,200);
 
 	SDL_Rect box;
 	int textHeight = gmenu2x.font->getTextHeight(text);
@@ -82,42 +73,28 @@ int MessageBox::exec() {
 	box.y = (gmenu2x.height() - box.h) / 2;
 
 	//outer box
-	bg.box(box.x - 2, box.y - 2, box.w + 4, box.h + 4, gmenu2x.skinConfColors[COLOR_MESSAGE_BOX_BG]);
+	s.box(box.x - 2, box.y - 2, box.w + 4, box.h + 4, gmenu2x.skinConfColors[COLOR_MESSAGE_BOX_BG]);
 	//draw inner rectangle
-	bg.rectangle(box, gmenu2x.skinConfColors[COLOR_MESSAGE_BOX_BORDER]);
+	s.rectangle(box, gmenu2x.skinConfColors[COLOR_MESSAGE_BOX_BORDER]);
 	//icon+text
 	if (gmenu2x.sc[icon]) {
-		gmenu2x.sc[icon]->blitCenter(bg, box.x + ICON_PADDING + ICON_DIMENSION / 2, box.y + ICON_PADDING + ICON_DIMENSION / 2);
+		gmenu2x.sc[icon]->blitCenter(s, box.x + ICON_PADDING + ICON_DIMENSION / 2, box.y + ICON_PADDING + ICON_DIMENSION / 2);
 	}
-	gmenu2x.font->write(bg, text, box.x + TEXT_PADDING + (gmenu2x.sc[icon] ? ICON_PADDING + ICON_DIMENSION : 0), box.y + (box.h - textHeight) / 2, Font::HAlignLeft, Font::VAlignTop);
+	gmenu2x.font->write(s, text, box.x + TEXT_PADDING + (gmenu2x.sc[icon] ? ICON_PADDING + ICON_DIMENSION : 0), box.y + (box.h - textHeight) / 2, Font::HAlignLeft, Font::VAlignTop);
 
 	int btnX = box.x + box.w - 6;
 	for (size_t i = 0; i < InputManager::BUTTON_TYPE_SIZE; i++) {
 		if (!buttons[i].empty()) {
-			buttonPositions[i].y = box.y+box.h+8;
-			buttonPositions[i].w = btnX;
-
-			btnX = gmenu2x.drawButtonRight(bg, buttonLabels[i], buttons[i], btnX, buttonPositions[i].y);
-
-			buttonPositions[i].x = btnX;
-			buttonPositions[i].w = buttonPositions[i].x-btnX-6;
+			btnX = gmenu2x.drawButtonRight(s, buttonLabels[i], buttons[i], btnX, box.y + box.h + 8);
 		}
 	}
+}
 
-	bg.convertToDisplayFormat();
-	bg.blit(s, 0, 0);
-	s.flip();
-
-	int result = -1;
-	while (result < 0) {
-		InputManager::Button button;
-		if (gmenu2x.input.pollButton(&button)
-				&& !buttons[button].empty()) {
-			result = button;
-		}
-
-		std::this_thread::sleep_for(std::chrono::microseconds(LOOP_DELAY));
+bool MessageBox::handleButtonPress(InputManager::Button button) {
+	if (button < InputManager::BUTTON_TYPE_SIZE && !buttons[button].empty()) {
+		dismiss();
+		if (actions[button])
+			actions[button]();
 	}
-
-	return result;
+	return true;
 }
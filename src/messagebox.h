@@ -21,26 +21,42 @@
 #ifndef MESSAGEBOX_H
 #define MESSAGEBOX_H
 
-#include "inputmanager.h"
+#include "compat-string_view.h"
+#include "layer.h"
 
-#include <SDL2/SDL.h>
+#include <functional>
 #include <string>
 
 class GMenu2X;
 
-class MessageBox {
+/**
+ * A modal box showing a message and the buttons that close it.
+ */
+class MessageBox : public Layer {
 public:
-	MessageBox(GMenu2X& gmenu2x, const std::string &text,
+	typedef std::function<void(void)> Action;
+
+	MessageBox(GMenu2X& gmenu2x, compat::string_view text,
 			const std::string &icon="");
-	void setButton(InputManager::Button button, const std::string &label);
-	int exec();
+
+	/**
+	 * Makes the given button close the box, running the given action if
+	 * there is one.
+	 */
+	void setButton(InputManager::Button button, compat::string_view label,
+			Action action = nullptr);
+
+	// Layer implementation:
+	virtual bool isModal() const { return true; }
+	virtual void paint(Surface& s);
+	virtual bool handleButtonPress(InputManager::Button button);
 
 private:
 	GMenu2X& gmenu2x;
 	std::string text, icon;
 	std::string buttons[InputManager::BUTTON_TYPE_SIZE];
 	std::string buttonLabels[InputManager::BUTTON_TYPE_SIZE];
-	SDL_Rect buttonPositions[InputManager::BUTTON_TYPE_SIZE];
+	Action actions[InputManager::BUTTON_TYPE_SIZE];
 };
 
 #endif // MESSAGEBOX_H
@@ -0,0 +1,149 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#include "perfhud.h"
+
+#include "gmenu2x.h"
+#include "layer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cxxabi.h>
+#include <typeinfo>
+
+using namespace std;
+using namespace std::chrono;
+
+/** Frame times at the top of the graph. */
+static constexpr PerfHud::Clock::duration GRAPH_MAX = milliseconds(33);
+/** Frame times below this make 60 frames per second. */
+static constexpr PerfHud::Clock::duration FRAME_BUDGET = microseconds(16667);
+
+static constexpr int GRAPH_HEIGHT = 32;
+static constexpr int BAR_WIDTH = 2;
+
+static double toMs(PerfHud::Clock::duration time)
+{
+	return duration<double, milli>(time).count();
+}
+
+PerfHud::PerfHud(GMenu2X& gmenu2x)
+	: gmenu2x(gmenu2x)
+	, current()
+	, last()
+	, frameCount(0)
+{
+	frameTimes.fill(Clock::duration::zero());
+}
+
+void PerfHud::beginFrame()
+{
+	current.layers.clear();
+}
+
+void PerfHud::layerPainted(const Layer *layer, Clock::duration time)
+{
+	current.layers.emplace_back(layerName(layer), time);
+}
+
+void PerfHud::endFrame(Clock::duration layoutRun, Clock::duration layoutRender,
+		Clock::duration flip, Clock::duration total,
+		Surface::RenderStats const& stats)
+{
+	current.layoutRun = layoutRun;
+	current.layoutRender = layoutRender;
+	current.flip = flip;
+	current.total = total;
+	current.stats = stats;
+	// Swapping keeps the capacity of both layer lists.
+	swap(current, last);
+
+	frameTimes[frameCount % HISTORY_SIZE] = total;
+	frameEnds[frameCount % HISTORY_SIZE] = Clock::now();
+	frameCount++;
+}
+
+const char *PerfHud::layerName(const Layer *layer)
+{
+	if (!layer)
+		return "(composite)";
+
+	const type_info& type = typeid(*layer);
+	auto it = names.find(type);
+	if (it == names.end()) {
+		int status;
+		char *demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+		it = names.emplace(type, status == 0 ? demangled : type.name()).first;
+		free(demangled);
+	}
+	return it->second.c_str();
+}
+
+void PerfHud::paint(Surface& s)
+{
+	auto& font = *gmenu2x.font;
+
+	// Frames are only painted when something changes, so this counts the
+	// frames of the last second rather than dividing by the last frame time.
+	const auto now = Clock::now();
+	unsigned int fps = 0;
+	for (size_t i = 0; i < min<unsigned long>(frameCount, HISTORY_SIZE); i++) {
+		if (now - frameEnds[i] < seconds(1))
+			fps++;
+	}
+
+	vector<string> lines;
+	char buf[128];
+	snprintf(buf, sizeof(buf), "%u fps, frame %.2f ms", fps, toMs(last.total));
+	lines.emplace_back(buf);
+	for (auto const& layer : last.layers) {
+		snprintf(buf, sizeof(buf), "%s %.2f ms", layer.first, toMs(layer.second));
+		lines.emplace_back(buf);
+	}
+	snprintf(buf, sizeof(buf), "layout %.2f ms, render %.2f ms",
+			toMs(last.layoutRun), toMs(last.layoutRender));
+	lines.emplace_back(buf);
+	snprintf(buf, sizeof(buf), "flip %.2f ms", toMs(last.flip));
+	lines.emplace_back(buf);
+	snprintf(buf, sizeof(buf), "%lu draws, %lu binds, %lu switches",
+			last.stats.drawCalls, last.stats.textureBinds,
+			last.stats.targetSwitches);
+	lines.emplace_back(buf);
+	snprintf(buf, sizeof(buf), "textures %zu KiB",
+			gmenu2x.sc.textureBytes() / 1024);
+	lines.emplace_back(buf);
+
+	const int graphWidth = int(HISTORY_SIZE) * BAR_WIDTH;
+	int width = graphWidth;
+	for (auto const& line : lines)
+		width = max(width, font.getTextWidth(line));
+	const int spacing = font.getLineSpacing();
+	const int x = 4, y = 4;
+	s.box(x, y, width + 8, lines.size() * spacing + GRAPH_HEIGHT + 12,
+			RGBAColor(0, 0, 0, 192));
+
+	int posY = y + 4;
+	for (auto const& line : lines) {
+		font.write(s, line, x + 4, posY);
+		posY += spacing;
+	}
+
+	// Oldest frame on the left, so the graph scrolls to the left.
+	posY += 4;
+	const int bottom = posY + GRAPH_HEIGHT;
+	for (size_t i = 0; i < HISTORY_SIZE; i++) {
+		const auto time = frameTimes[(frameCount + i) % HISTORY_SIZE];
+		const int h = int(min<Clock::rep>(GRAPH_HEIGHT,
+				time.count() * GRAPH_HEIGHT / GRAPH_MAX.count()));
+		if (h <= 0)
+			continue;
+		const RGBAColor color = time <= FRAME_BUDGET
+				? RGBAColor(64, 192, 64)
+				: time <= 2 * FRAME_BUDGET
+				? RGBAColor(224, 192, 32)
+				: RGBAColor(224, 48, 48);
+		s.box(x + 4 + i * BAR_WIDTH, bottom - h, BAR_WIDTH, h, color);
+	}
+	const int budget = int(FRAME_BUDGET.count() * GRAPH_HEIGHT / GRAPH_MAX.count());
+	s.box(x + 4, bottom - budget, graphWidth, 1, RGBAColor(255, 255, 255, 128));
+}
@@ -0,0 +1,80 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#ifndef PERFHUD_H
+#define PERFHUD_H
+
+#include "surface.h"
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class GMenu2X;
+class Layer;
+
+
+/**
+ * An overlay that shows where the time of a frame goes: painting each layer,
+ * solving and rendering the layout and flipping, as well as the draw calls,
+ * the render target switches and the texture memory of the loaded surfaces.
+ * A graph shows the times of the last frames.
+ *
+ * The times are measured on the CPU, so they include submitting the draws to
+ * the renderer, but the GPU only shows up where the renderer waits for it,
+ * which is usually in the flip. The overlay is painted on top of the frame
+ * it measures, so it shows the figures of the previous frame, and painting
+ * it is not included in them.
+ *
+ * This is not a layer: it takes no input and GMenu2X paints it after all
+ * layers, feeding it the measurements of each frame.
+ */
+class PerfHud {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	PerfHud(GMenu2X& gmenu2x);
+
+	/** Starts measuring a new frame. */
+	void beginFrame();
+	/**
+	 * Records the time it took to paint the given layer. Null stands for
+	 * the reused composite of the layers below a modal layer.
+	 */
+	void layerPainted(const Layer *layer, Clock::duration time);
+	/** Completes the frame that was begun last. */
+	void endFrame(Clock::duration layoutRun, Clock::duration layoutRender,
+			Clock::duration flip, Clock::duration total,
+			Surface::RenderStats const& stats);
+
+	/** Paints the figures of the last complete frame. */
+	void paint(Surface& s);
+
+private:
+	struct Frame {
+		std::vector<std::pair<const char *, Clock::duration>> layers;
+		Clock::duration layoutRun, layoutRender, flip, total;
+		Surface::RenderStats stats;
+	};
+
+	/** Returns the class name of the given layer, for as long as this lives. */
+	const char *layerName(const Layer *layer);
+
+	GMenu2X& gmenu2x;
+
+	/** The frame being measured and the last complete one. */
+	Frame current, last;
+
+	/** Ring buffers of the total times of the last frames and their ends. */
+	static constexpr size_t HISTORY_SIZE = 64;
+	std::array<Clock::duration, HISTORY_SIZE> frameTimes;
+	std::array<Clock::time_point, HISTORY_SIZE> frameEnds;
+	unsigned long frameCount;
+
+	std::unordered_map<std::type_index, std::string> names;
+};
+
+#endif // PERFHUD_H
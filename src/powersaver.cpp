@@ -10,21 +10,6 @@
 
 std::shared_ptr<PowerSaver> PowerSaver::instance;
 
-Uint32 screenTimerCallback(Uint32 timeout, void *d) {
-	unsigned int * old_ticks = (unsigned int *) d;
-	unsigned int new_ticks = SDL_GetTicks();
-
-	if (new_ticks > *old_ticks + timeout + 1000) {
-		DEBUG("Suspend occured, restarting timer\n");
-		*old_ticks = new_ticks;
-		return timeout;
-	}
-
-	DEBUG("Disable Backlight Event\n");
-	PowerSaver::instance->disableScreen();
-	return 0;
-}
-
 std::shared_ptr<PowerSaver> PowerSaver::getInstance()
 {
 	if (!instance)
@@ -36,44 +21,56 @@ std::shared_ptr<PowerSaver> PowerSaver::getInstance()
 PowerSaver::PowerSaver()
 	: screenState(false)
 	, screenTimeout(0)
+	, timers(nullptr)
 	, screenTimer(0)
 {
 	enableScreen();
 }
 
 PowerSaver::~PowerSaver() {
-	removeScreenTimer();
+	setTimerScheduler(nullptr);
 	enableScreen();
 }
 
+void PowerSaver::setTimerScheduler(TimerScheduler *timers) {
+	if (this->timers)
+		this->timers->remove(screenTimer);
+	this->timers = timers;
+	if (timers) {
+		screenTimer = timers->add([this] { return screenTimerExpired(); });
+		resetScreenTimer();
+	}
+}
+
 void PowerSaver::setScreenTimeout(unsigned int seconds) {
 	screenTimeout = seconds;
 	resetScreenTimer();
 }
 
 void PowerSaver::resetScreenTimer() {
-	removeScreenTimer();
 	enableScreen();
+	if (!timers)
+		return;
 	if (screenTimeout != 0) {
-		addScreenTimer();
+		timeout_startms = SDL_GetTicks();
+		timers->start(screenTimer, screenTimeout * 1000);
+	} else {
+		timers->stop(screenTimer);
 	}
 }
 
-void PowerSaver::addScreenTimer() {
-	assert(!screenTimer);
-	timeout_startms = SDL_GetTicks();
-	screenTimer = SDL_AddTimer(
-			screenTimeout * 1000, screenTimerCallback, &timeout_startms);
-	if (!screenTimer) {
-		ERROR("Could not initialize SDLTimer: %s\n", SDL_GetError());
-	}
-}
+unsigned int PowerSaver::screenTimerExpired() {
+	unsigned int new_ticks = SDL_GetTicks();
 
-void PowerSaver::removeScreenTimer() {
-	if (screenTimer) {
-		SDL_RemoveTimer(screenTimer);
-		screenTimer = 0;
+	if (new_ticks > timeout_startms + screenTimeout * 1000 + 1000) {
+		DEBUG("Suspend occured, restarting timer\n");
+		timeout_startms = new_ticks;
+		return screenTimeout * 1000;
 	}
+
+	DEBUG("Disable Backlight Event\n");
+	disableScreen();
+	return 0;
 }
 
 #define SCREEN_BLANK_PATH "/sys/class/graphics/fb0/blank"
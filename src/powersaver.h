@@ -1,6 +1,8 @@
 #ifndef POWERSAVER_H
 #define POWERSAVER_H
 
+#include "timerscheduler.h"
+
 #include <memory>
 #include <SDL2/SDL.h>
 
@@ -9,6 +11,8 @@ public:
 	static std::shared_ptr<PowerSaver> getInstance();
 
 	~PowerSaver();
+	/** Sets the scheduler of the screen timer; nullptr stops using it. */
+	void setTimerScheduler(TimerScheduler *timers);
 	void resetScreenTimer();
 	void setScreenTimeout(unsigned int seconds);
 
@@ -17,8 +21,7 @@ public:
 private:
 	PowerSaver();
 
-	void addScreenTimer();
-	void removeScreenTimer();
+	unsigned int screenTimerExpired();
 	void setScreenBlanking(bool state);
 	void enableScreen();
 	void disableScreen();
@@ -28,9 +31,8 @@ private:
 	bool screenState;
 	unsigned int screenTimeout;
 	unsigned int timeout_startms;
-	SDL_TimerID screenTimer;
-
-	friend Uint32 screenTimerCallback(Uint32 timeout, void *d);
+	TimerScheduler *timers;
+	TimerScheduler::TimerId screenTimer;
 };
 
 #endif
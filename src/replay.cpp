@@ -0,0 +1,192 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#include "replay.h"
+
+#include "debug.h"
+#include "surface.h"
+#include "utilities.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+using namespace std;
+using namespace std::chrono;
+
+/** Names of the buttons, in the order of InputManager::Button. */
+static const char *const buttonNames[] = {
+	"up", "down", "left", "right",
+	"accept", "cancel",
+	"altleft", "altright",
+	"menu", "settings",
+	"repaint", "quit",
+};
+
+static double toMs(Replay::Clock::duration time)
+{
+	return duration<double, milli>(time).count();
+}
+
+unique_ptr<Replay> Replay::load(const string &script, const string &output)
+{
+	ifstream in(script.c_str(), ios_base::in);
+	if (!in.is_open()) {
+		ERROR("Unable to open replay script '%s'\n", script.c_str());
+		return nullptr;
+	}
+
+	vector<Step> steps;
+	unsigned int width = 320, height = 240;
+	string line;
+	for (unsigned int lineNo = 1; getline(in, line, '\n'); lineNo++) {
+		line = trim(line);
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		const string::size_type space = line.find_first_of(" \t");
+		const string name = line.substr(0, space);
+		const string arg = space == string::npos
+				? string() : trim(line.substr(space + 1));
+		if (name == "screen") {
+			if (sscanf(arg.c_str(), "%ux%u", &width, &height) != 2
+					|| !width || !height || !steps.empty()) {
+				ERROR("%s:%u: invalid screen '%s'\n",
+						script.c_str(), lineNo, arg.c_str());
+				return nullptr;
+			}
+			continue;
+		}
+
+		char *end;
+		const unsigned long value = strtoul(arg.c_str(), &end, 10);
+		if (*end) {
+			ERROR("%s:%u: invalid number '%s'\n",
+					script.c_str(), lineNo, arg.c_str());
+			return nullptr;
+		}
+
+		if (name == "wait") {
+			if (!value) {
+				ERROR("%s:%u: wait needs a time\n", script.c_str(), lineNo);
+				return nullptr;
+			}
+			steps.push_back({ InputManager::REPAINT, (unsigned int) value });
+			continue;
+		}
+
+		size_t i;
+		for (i = 0; i < InputManager::BUTTON_TYPE_SIZE; i++) {
+			if (name == buttonNames[i])
+				break;
+		}
+		if (i == InputManager::BUTTON_TYPE_SIZE) {
+			ERROR("%s:%u: unknown button '%s'\n",
+					script.c_str(), lineNo, name.c_str());
+			return nullptr;
+		}
+		for (unsigned long n = arg.empty() ? 1 : value; n; n--)
+			steps.push_back({ static_cast<InputManager::Button>(i), 0 });
+	}
+
+	INFO("Replaying %zu steps from '%s'\n", steps.size(), script.c_str());
+	return unique_ptr<Replay>(new Replay(std::move(steps), width, height, output));
+}
+
+Replay::Replay(vector<Step> steps, int width, int height,
+		const string &output)
+	: output(output)
+	, width(width)
+	, height(height)
+	, steps(std::move(steps))
+	, nextStep(0)
+	, input(-1)
+{
+	start = waitUntil = inputTime = lastFrame = Clock::now();
+}
+
+bool Replay::nextButton(InputManager::Button *button, int *delay)
+{
+	const auto now = Clock::now();
+	if (now < waitUntil) {
+		*delay = int(duration_cast<milliseconds>(waitUntil - now).count()) + 1;
+		return false;
+	}
+
+	if (nextStep == steps.size()) {
+		*button = InputManager::QUIT;
+		return true;
+	}
+
+	const Step &step = steps[nextStep++];
+	if (step.waitMs) {
+		waitUntil = now + milliseconds(step.waitMs);
+		*delay = step.waitMs;
+		return false;
+	}
+
+	*button = step.button;
+	input = step.button;
+	inputTime = now;
+	return true;
+}
+
+void Replay::eventDelivered(InputManager::Button button)
+{
+	input = button;
+	inputTime = Clock::now();
+}
+
+void Replay::framePresenting(OutputSurface &s)
+{
+	const auto now = Clock::now();
+	const auto since = input >= 0 ? max(inputTime, lastFrame) : lastFrame;
+
+	// FNV-1a over the pixels.
+	uint32_t checksum = 2166136261u;
+	for (Uint32 pixel : s.readPixels()) {
+		for (int i = 0; i < 4; i++, pixel >>= 8) {
+			checksum ^= pixel & 0xff;
+			checksum *= 16777619u;
+		}
+	}
+
+	frames.push_back({ input, now - since, checksum });
+	input = -1;
+	// Start the next frame after the read-back, which stalls the renderer.
+	lastFrame = Clock::now();
+}
+
+bool Replay::write() const
+{
+	FILE *out = fopen(output.c_str(), "w");
+	if (!out) {
+		ERROR("Unable to write '%s': %s\n", output.c_str(), strerror(errno));
+		return false;
+	}
+
+	Clock::duration total(0);
+	for (auto const& frame : frames)
+		total += frame.time;
+
+	fprintf(out, "{\n  \"frames\": [\n");
+	for (size_t i = 0; i < frames.size(); i++) {
+		auto const& frame = frames[i];
+		fprintf(out, "    { \"input\": %s%s%s, \"ms\": %.3f, "
+				"\"checksum\": \"%08x\" }%s\n",
+				frame.input >= 0 ? "\"" : "",
+				frame.input >= 0 ? buttonNames[frame.input] : "null",
+				frame.input >= 0 ? "\"" : "",
+				toMs(frame.time), frame.checksum,
+				i + 1 < frames.size() ? "," : "");
+	}
+	fprintf(out, "  ],\n  \"frame_ms\": %.3f,\n  \"elapsed_ms\": %.3f\n}\n",
+			toMs(total), toMs(lastFrame - start));
+
+	if (fclose(out) != 0) {
+		ERROR("Unable to write '%s': %s\n", output.c_str(), strerror(errno));
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,102 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "inputmanager.h"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class OutputSurface;
+
+/**
+ * Feeds a scripted sequence of buttons to the program instead of the input
+ * devices, and records every frame that is presented meanwhile.
+ *
+ * A script has one step per line; empty lines and lines starting with '#'
+ * are ignored:
+ *   BUTTON [COUNT]  presses the button COUNT times (default: once); the
+ *                   names are those of input.conf, like "down" or "accept",
+ *   wait MS         lets MS milliseconds pass without input, so timers and
+ *                   background work can run,
+ *   screen WxH      sets the resolution of the screen (default: 320x240);
+ *                   this must come before the first button.
+ * Once the script is done, the program is told to quit.
+ *
+ * For each frame, the recording holds the input that led to it, the time
+ * from that input (or from the previous frame, for animations) until the
+ * frame was ready to present, and a checksum of its pixels. Reading back
+ * the pixels and presenting them are left out of the time. To keep the
+ * checksums comparable between runs, a replay does not show the clock nor
+ * the battery and disk status, waits for the texts it shows to be rendered
+ * and counts the rows of a text dialog before showing it.
+ */
+class Replay {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	/**
+	 * Loads the given script; the recording is to be written to the given
+	 * output file. Returns nullptr if the script cannot be read or has errors.
+	 */
+	static std::unique_ptr<Replay> load(const std::string &script,
+			const std::string &output);
+
+	int screenWidth() const { return width; }
+	int screenHeight() const { return height; }
+
+	/**
+	 * Returns true and the next scripted button, or false if the script is
+	 * waiting; *delay is then set to the milliseconds until the next step.
+	 */
+	bool nextButton(InputManager::Button *button, int *delay);
+
+	/**
+	 * Records that an event which is not a scripted button, like a repaint
+	 * request, was handed to the program.
+	 */
+	void eventDelivered(InputManager::Button button);
+
+	/** Records the frame that the given surface is about to present. */
+	void framePresenting(OutputSurface &s);
+
+	/** Writes the recorded frames as JSON; returns false on error. */
+	bool write() const;
+
+private:
+	struct Step {
+		InputManager::Button button;
+		/** If not zero, this step waits instead of pressing a button. */
+		unsigned int waitMs;
+	};
+
+	struct Frame {
+		/** Index into the button names, or -1 for animation frames. */
+		int input;
+		Clock::duration time;
+		uint32_t checksum;
+	};
+
+	Replay(std::vector<Step> steps, int width, int height,
+			const std::string &output);
+
+	const std::string output;
+	const int width, height;
+	std::vector<Step> steps;
+	size_t nextStep;
+	Clock::time_point waitUntil;
+
+	/** The input since the last frame, or -1, and when it was delivered. */
+	int input;
+	Clock::time_point inputTime;
+	Clock::time_point lastFrame;
+
+	std::vector<Frame> frames;
+	Clock::time_point start;
+};
+
+#endif // REPLAY_H
@@ -39,26 +39,24 @@
 
 using namespace std;
 
-Selector::Selector(GMenu2X& gmenu2x, LinkApp& link, const string &selectorDir)
+Selector::Selector(GMenu2X& gmenu2x, LinkApp& link, const string &selectorDir,
+		int startSelection)
 	: Dialog(gmenu2x)
 	, link(link)
+	, showDirectories(link.getSelectorBrowser())
+	, bg(*gmenu2x.bg)
+	, firstElement(0)
 {
 	dir = selectorDir.empty() ? link.getSelectorDir() : selectorDir;
 	if (dir[dir.length()-1]!='/') dir += "/";
-}
-
-int Selector::exec(int startSelection) {
-	const bool showDirectories = link.getSelectorBrowser();
 
-	FileLister fl;
 	fl.setShowDirectories(showDirectories);
 	fl.setFilter(link.getSelectorFilter());
-	while (!prepare(fl) && showDirectories && dir != "/") {
+	while (!prepare() && showDirectories && dir != "/") {
 		// The given directory could not be opened; try parent.
 		dir = parentDir(dir);
 	}
 
-	OffscreenSurface bg(*gmenu2x.bg);
 	drawTitleIcon(bg, link.getIconPath(), true);
 	writeTitle(bg, link.getTitle());
 	writeSubTitle(bg, link.getDescription());
@@ -66,9 +64,10 @@ int Selector::exec(int startSelection) {
 	int x = 5;
 	if (fl.size() != 0) {
 		x = gmenu2x.drawButton(bg, "accept", gmenu2x.tr["Select"], x);
+		x = gmenu2x.drawButton(bg, "left", "", x);
+		x = gmenu2x.drawButton(bg, "right", gmenu2x.tr["Jump"], x);
 	}
 	if (showDirectories) {
-		x = gmenu2x.drawButton(bg, "left", "", x);
 		x = gmenu2x.drawButton(bg, "cancel", gmenu2x.tr["Up one folder"], x);
 	} else {
 		x = gmenu2x.drawButton(bg, "cancel", "", x);
@@ -76,155 +75,171 @@ int Selector::exec(int startSelection) {
 	x = gmenu2x.drawButton(bg, "start", gmenu2x.tr["Exit"], x);
 	(void)x;
 
-	unsigned int top, height;
 	tie(top, height) = gmenu2x.getContentArea();
 
-	auto folderIcon = gmenu2x.sc.skinRes("imgs/folder.png");
+	folderIcon = gmenu2x.sc.skinRes("imgs/folder.png");
 
 	// Figure out how many items we can fit in the content area.
-	int lineHeight = gmenu2x.font->getLineSpacing();
+	lineHeight = gmenu2x.font->getLineSpacing();
 	if (showDirectories && folderIcon) {
-		lineHeight = max(lineHeight, folderIcon->height() + 2);
+		lineHeight = max(lineHeight, (unsigned int)folderIcon->height() + 2);
 	}
-	unsigned int nb_elements = max(height / lineHeight, 1u);
+	nb_elements = max(height / lineHeight, 1u);
 	// Redistribute any leftover space.
 	lineHeight = height / nb_elements;
 	top += (height - lineHeight * nb_elements) / 2;
 
 	bg.convertToDisplayFormat();
 
-	unsigned int firstElement = 0;
-	unsigned int selected = compat::clamp(startSelection, 0, (int)fl.size() - 1);
-
-	bool close = false, result = true;
-	while (!close) {
-		OutputSurface& s = *gmenu2x.s;
-
-		bg.blit(s, 0, 0);
-
-		if (fl.size() == 0) {
-			gmenu2x.font->write(s, "(" + gmenu2x.tr["no items"] + ")",
-					4, top + lineHeight / 2,
-					Font::HAlignLeft, Font::VAlignMiddle);
-		} else {
-			if (selected >= firstElement + nb_elements)
-				firstElement = selected - nb_elements + 1;
-			if (selected < firstElement)
-				firstElement = selected;
-
-			//Screenshot
-			if (fl.isFile(selected)) {
-				string path = screendir + trimExtension(fl[selected]) + ".png";
-				auto screenshot = OffscreenSurface::loadImage(gmenu2x, path, false);
-				if (screenshot) {
-					screenshot->blitRight(s, gmenu2x.width(), 0, gmenu2x.width(), gmenu2x.height(), 128u);
-				}
+	selected = compat::clamp(startSelection, 0, (int)fl.size() - 1);
+}
+
+void Selector::paint(Surface& s) {
+	bg.blit(s, 0, 0);
+
+	if (fl.size() == 0) {
+		gmenu2x.font->write(s, "(" + string(gmenu2x.tr["no items"]) + ")",
+				4, top + lineHeight / 2,
+				Font::HAlignLeft, Font::VAlignMiddle);
+	} else {
+		if (selected >= firstElement + nb_elements)
+			firstElement = selected - nb_elements + 1;
+		if (selected < firstElement)
+			firstElement = selected;
+
+		//Screenshot
+		if (fl.isFile(selected)) {
+			string path = screendir + trimExtension(fl[selected]) + ".png";
+			auto screenshot = OffscreenSurface::loadImage(gmenu2x, path, false);
+			if (screenshot) {
+				screenshot->blitRight(s, gmenu2x.width(), 0, gmenu2x.width(), gmenu2x.height(), 128u);
 			}
+		}
 
-			//Selection
-			int iY = top + (selected - firstElement) * lineHeight;
-			if (selected<fl.size())
-				s.box(1, iY, gmenu2x.width()-11, lineHeight, gmenu2x.skinConfColors[COLOR_SELECTION_BG]);
-
-			//Files & Dirs
-			s.setClipRect(0, top, gmenu2x.width()-9, height);
-			for (unsigned int i = firstElement;
-					i < fl.size() && i < firstElement + nb_elements; i++) {
-				iY = top + (i - firstElement) * lineHeight;
-				x = 4;
-				if (fl.isDirectory(i)) {
-					if (folderIcon) {
-						folderIcon->blit(s,
-								x, iY + (lineHeight - folderIcon->height()) / 2);
-						x += folderIcon->width() + 2;
-					}
-					gmenu2x.font->write(s, fl[i],
-							x, iY + lineHeight / 2,
-							Font::HAlignLeft, Font::VAlignMiddle);
-				} else {
-					gmenu2x.font->write(s, (gmenu2x.confInt["trimExt"] ? trimExtension(fl[i]) : fl[i]),
-							x, iY + lineHeight / 2,
-							Font::HAlignLeft, Font::VAlignMiddle);
+		//Selection
+		int iY = top + (selected - firstElement) * lineHeight;
+		if (selected<fl.size())
+			s.box(1, iY, gmenu2x.width()-11, lineHeight, gmenu2x.skinConfColors[COLOR_SELECTION_BG]);
+
+		//Files & Dirs
+		s.setClipRect(0, top, gmenu2x.width()-9, height);
+		for (unsigned int i = firstElement;
+				i < fl.size() && i < firstElement + nb_elements; i++) {
+			iY = top + (i - firstElement) * lineHeight;
+			int x = 4;
+			if (fl.isDirectory(i)) {
+				if (folderIcon) {
+					folderIcon->blit(s,
+							x, iY + (lineHeight - folderIcon->height()) / 2);
+					x += folderIcon->width() + 2;
 				}
+				gmenu2x.font->write(s, fl[i],
+						x, iY + lineHeight / 2,
+						Font::HAlignLeft, Font::VAlignMiddle);
+			} else {
+				gmenu2x.font->write(s, (gmenu2x.confInt["trimExt"] ? trimExtension(fl[i]) : fl[i]),
+						x, iY + lineHeight / 2,
+						Font::HAlignLeft, Font::VAlignMiddle);
 			}
-			s.clearClipRect();
 		}
+		s.clearClipRect();
+	}
 
-		gmenu2x.drawScrollBar(nb_elements, fl.size(), firstElement);
-		s.flip();
-
-		switch (gmenu2x.input.waitForPressedButton()) {
-			case InputManager::SETTINGS:
-				close = true;
-				result = false;
-				break;
-
-			case InputManager::UP:
-				if (selected == 0) selected = fl.size() -1;
-				else selected -= 1;
-				break;
-
-			case InputManager::ALTLEFT:
-				if ((int)(selected - nb_elements + 1) < 0)
-					selected = 0;
-				else
-					selected -= nb_elements - 1;
-				break;
-
-			case InputManager::DOWN:
-				if (selected+1>=fl.size()) selected = 0;
-				else selected += 1;
-				break;
-
-			case InputManager::ALTRIGHT:
-				if (selected + nb_elements - 1 >= fl.size())
-					selected = fl.size() - 1;
-				else
-					selected += nb_elements - 1;
-				break;
-
-			case InputManager::CANCEL:
-				if (!showDirectories) {
-					close = true;
-					result = false;
-					break;
-				}
-				// ...fall through...
-			case InputManager::LEFT:
-				if (showDirectories) {
-					selected = goToParentDir(fl);
-					firstElement = 0;
-				}
-				break;
+	gmenu2x.drawScrollBar(s, nb_elements, fl.size(), firstElement);
+}
 
-			case InputManager::ACCEPT:
-				if (fl.size() != 0) {
-					if (fl.isFile(selected)) {
-						file = fl[selected];
-						close = true;
+bool Selector::handleButtonPress(InputManager::Button button) {
+	switch (button) {
+		case InputManager::SETTINGS:
+			dismiss();
+			break;
+
+		case InputManager::UP:
+			if (selected == 0) selected = fl.size() -1;
+			else selected -= 1;
+			break;
+
+		case InputManager::ALTLEFT:
+			if ((int)(selected - nb_elements + 1) < 0)
+				selected = 0;
+			else
+				selected -= nb_elements - 1;
+			break;
+
+		case InputManager::DOWN:
+			if (selected+1>=fl.size()) selected = 0;
+			else selected += 1;
+			break;
+
+		case InputManager::LEFT:
+			selected = fl.prevGroup(selected);
+			break;
+
+		case InputManager::RIGHT:
+			selected = fl.nextGroup(selected);
+			break;
+
+		case InputManager::ALTRIGHT:
+			if (selected + nb_elements - 1 >= fl.size())
+				selected = fl.size() - 1;
+			else
+				selected += nb_elements - 1;
+			break;
+
+		case InputManager::CANCEL:
+			if (showDirectories) {
+				selected = goToParentDir();
+				firstElement = 0;
+			} else {
+				dismiss();
+			}
+			break;
+
+		case InputManager::ACCEPT:
+			if (fl.size() != 0) {
+				if (fl.isFile(selected)) {
+					dismiss();
+					if (onSelect)
+						onSelect(selected, dir, fl[selected]);
+				} else {
+					string subdir = fl[selected];
+					if (subdir == "..") {
+						selected = goToParentDir();
 					} else {
-						string subdir = fl[selected];
-						if (subdir == "..") {
-							selected = goToParentDir(fl);
-						} else {
-							dir += subdir + '/';
-							prepare(fl);
-							selected = 0;
-						}
-						firstElement = 0;
+						dir += subdir + '/';
+						prepare();
+						selected = 0;
 					}
+					firstElement = 0;
 				}
-				break;
+			}
+			break;
 
-			default:
-				break;
-		}
+		default:
+			break;
 	}
+	return true;
+}
 
-	return result ? (int)selected : -1;
+bool Selector::handleButtonPress(InputManager::Button button,
+		unsigned int count) {
+	const unsigned int size = fl.size();
+	if (size == 0)
+		return Layer::handleButtonPress(button, count);
+
+	switch (button) {
+		case InputManager::UP:
+			selected = (selected + size - count % size) % size;
+			return true;
+		case InputManager::DOWN:
+			selected = (selected + count) % size;
+			return true;
+		default:
+			return Layer::handleButtonPress(button, count);
+	}
 }
 
-bool Selector::prepare(FileLister& fl) {
+bool Selector::prepare() {
 	bool opened = fl.browse(dir);
 
 	screendir = dir;
@@ -236,10 +251,10 @@ bool Selector::prepare(FileLister& fl) {
 	return opened;
 }
 
-int Selector::goToParentDir(FileLister& fl) {
+int Selector::goToParentDir() {
 	string oldDir = dir;
 	dir = parentDir(dir);
-	prepare(fl);
+	prepare();
 	string oldName = oldDir.substr(dir.size(), oldDir.size() - dir.size() - 1);
 	auto& subdirs = fl.getDirectories();
 	auto it = find(subdirs.begin(), subdirs.end(), oldName);
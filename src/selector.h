@@ -22,35 +22,57 @@
 #define SELECTOR_H
 
 #include "dialog.h"
+#include "filelister.h"
+#include "layer.h"
+#include "surface.h"
 
+#include <functional>
+#include <memory>
 #include <string>
-#include <unordered_map>
-#include <vector>
 
 class LinkApp;
-class FileLister;
 
-class Selector : protected Dialog {
+/**
+ * Lets the user pick a file to launch a link with.
+ */
+class Selector : public Layer, protected Dialog {
+public:
+	/** Called with the index, the directory and the name of the file. */
+	typedef std::function<void(int, const std::string &, const std::string &)>
+			Action;
+
+	Selector(GMenu2X& gmenu2x, LinkApp& link,
+			const std::string &selectorDir = "", int startSelection = 0);
+
+	/** Sets what to do once a file has been selected. */
+	void setOnSelect(Action action) { onSelect = std::move(action); }
+
+	// Layer implementation:
+	virtual bool isModal() const { return true; }
+	virtual void paint(Surface& s);
+	virtual bool handleButtonPress(InputManager::Button button);
+	virtual bool handleButtonPress(InputManager::Button button,
+			unsigned int count);
+
 private:
 	LinkApp& link;
-	std::string file, dir, screendir;
+	std::string dir, screendir;
+	Action onSelect;
 
-	bool prepare(FileLister& fl);
+	FileLister fl;
+	bool showDirectories;
+	OffscreenSurface bg;
+	std::shared_ptr<OffscreenSurface> folderIcon;
+	unsigned int top, height, lineHeight, nb_elements;
+	unsigned int firstElement, selected;
+
+	bool prepare();
 
 	/**
 	 * Changes 'dir' to its parent directory.
 	 * Returns the index of the old dir in the parent, or 0 if unknown.
 	 */
-	int goToParentDir(FileLister& fl);
-
-public:
-	Selector(GMenu2X& gmenu2x, LinkApp& link,
-			const std::string &selectorDir = "");
-
-	int exec(int startSelection = 0);
-
-	const std::string &getFile() { return file; }
-	const std::string &getDir() { return dir; }
+	int goToParentDir();
 };
 
 #endif // SELECTOR_H
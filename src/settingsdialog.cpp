@@ -29,7 +29,7 @@ using namespace std;
 
 SettingsDialog::SettingsDialog(
 		GMenu2X& gmenu2x, InputManager &inputMgr_,
-		const string &text_, const string &icon)
+		compat::string_view text_, const string &icon)
 	: Dialog(gmenu2x)
 	, inputMgr(inputMgr_)
 	, text(text_)
@@ -83,7 +83,7 @@ bool SettingsDialog::exec() {
 			settings[i]->draw(maxNameWidth + 15, iY * rowHeight + topBarHeight + 2, rowHeight);
 		}
 
-		gmenu2x.drawScrollBar(numRows, settings.size(), firstElement);
+		gmenu2x.drawScrollBar(s, numRows, settings.size(), firstElement);
 
 		//description
 		writeSubTitle(s, settings[sel]->getDescription());
@@ -91,7 +91,9 @@ bool SettingsDialog::exec() {
 		s.flip();
 
 		InputManager::Button button = inputMgr.waitForPressedButton();
-		if (!settings[sel]->handleButtonPress(button)) {
+		if (button == InputManager::QUIT) {
+			close = true;
+		} else if (!settings[sel]->handleButtonPress(button)) {
 			switch (button) {
 				case InputManager::SETTINGS:
 					close = true;
@@ -39,7 +39,7 @@ private:
 
 public:
 	SettingsDialog(GMenu2X& gmenu2x, InputManager &inputMgr,
-			const std::string &text,
+			compat::string_view text,
 			const std::string &icon = "skin:sections/settings.png");
 
 	void addSetting(std::unique_ptr<MenuSetting> setting) {
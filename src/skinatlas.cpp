@@ -0,0 +1,199 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#include "skinatlas.h"
+
+#include "compat-filesystem.h"
+#include "debug.h"
+#include "imageio.h"
+#include "surface.h"
+#include "utilities.h"
+
+#include <algorithm>
+#include <cstring>
+#include <set>
+#include <system_error>
+
+using namespace std;
+
+/** Skin subdirectories whose images are packed. */
+static const char *const ATLAS_DIRS[] = {
+	"imgs", "imgs/buttons", "imgs/battery", "sections", "icons",
+};
+
+/** Images larger than this in either dimension are loaded separately. */
+static const int MAX_ENTRY_SIZE = 256;
+static const int MAX_PAGE_SIZE = 2048;
+
+/** Entries are surrounded by a copy of their edge pixels, so filtering
+  * during scaled blits does not pick up pixels of the neighbours. */
+static const int PADDING = 1;
+
+vector<string> SkinAtlas::listImages(const vector<string> &skinDirs)
+{
+	set<string, case_less> names;
+	for (auto &skinDir : skinDirs) {
+		for (auto dir : ATLAS_DIRS) {
+			error_code ec;
+			for (auto &entry : compat::filesystem::directory_iterator(
+						skinDir + "/" + dir, ec)) {
+				string name = entry.path().filename().string();
+				if (name[0] == '.' || name.size() < 4)
+					continue;
+
+				string ext = name.substr(name.size() - 4);
+				if (strcasecmp(ext.c_str(), ".qoi") == 0) {
+					// Converted skins are looked up by their PNG name.
+					name.replace(name.size() - 4, 4, ".png");
+				} else if (strcasecmp(ext.c_str(), ".png") != 0) {
+					continue;
+				}
+				names.insert(string(dir) + "/" + name);
+			}
+		}
+	}
+	return vector<string>(names.begin(), names.end());
+}
+
+void SkinAtlas::addCandidate(const string &path)
+{
+	for (auto &candidate : candidates) {
+		if (candidate.path == path)
+			return;
+	}
+
+	unsigned int width, height;
+	if (!getImageSize(path, &width, &height) || !width || !height
+			|| width > MAX_ENTRY_SIZE || height > MAX_ENTRY_SIZE)
+		return;
+
+	SDL_Surface *pixels = loadImageFile(path);
+	if (!pixels)
+		return;
+
+	candidates.push_back({ path, pixels, 0, { 0, 0, pixels->w, pixels->h } });
+}
+
+void SkinAtlas::pack()
+{
+	SDL_Renderer *renderer = Surface::getGlobalRenderer();
+	int pageSize = MAX_PAGE_SIZE;
+	SDL_RendererInfo info;
+	if (renderer && SDL_GetRendererInfo(renderer, &info) == 0
+			&& info.max_texture_width && info.max_texture_height) {
+		pageSize = min(pageSize, min(info.max_texture_width,
+		                             info.max_texture_height));
+	}
+
+	// Shelf packing: the tallest images go first, so each shelf wastes
+	// little space above its shorter entries.
+	sort(candidates.begin(), candidates.end(),
+		[](const Entry &a, const Entry &b) {
+			return a.rect.h != b.rect.h ? a.rect.h > b.rect.h
+			                            : a.rect.w > b.rect.w;
+		});
+
+	vector<int> pageHeights;
+	int x = 0, y = 0, shelfHeight = 0;
+	for (auto &entry : candidates) {
+		const int w = entry.rect.w + 2 * PADDING;
+		const int h = entry.rect.h + 2 * PADDING;
+		if (x + w > pageSize) {
+			x = 0;
+			y += shelfHeight;
+			shelfHeight = 0;
+		}
+		if (pageHeights.empty() || y + h > pageSize) {
+			pageHeights.push_back(0);
+			x = y = shelfHeight = 0;
+		}
+		entry.page = pageHeights.size() - 1;
+		entry.rect.x = x + PADDING;
+		entry.rect.y = y + PADDING;
+		x += w;
+		shelfHeight = max(shelfHeight, h);
+		pageHeights.back() = y + shelfHeight;
+	}
+
+	for (size_t page = 0; page < pageHeights.size(); page++) {
+		SDL_Surface *pixels = SDL_CreateRGBSurface(
+				0, pageSize, pageHeights[page], 32,
+				0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+		if (!pixels) {
+			ERROR("Unable to allocate skin atlas page: %s\n", SDL_GetError());
+			break;
+		}
+
+		for (auto &entry : candidates) {
+			if (entry.page != page)
+				continue;
+
+			const int w = entry.rect.w, h = entry.rect.h;
+			auto copy = [&](int sx, int sy, int sw, int sh, int dx, int dy) {
+				SDL_Rect src = { sx, sy, sw, sh };
+				SDL_Rect dst = { entry.rect.x + dx, entry.rect.y + dy, sw, sh };
+				SDL_BlitSurface(entry.pixels, &src, pixels, &dst);
+			};
+			SDL_SetSurfaceBlendMode(entry.pixels, SDL_BLENDMODE_NONE);
+			copy(0, 0, w, h, 0, 0);
+			copy(0, 0, w, 1, 0, -1);
+			copy(0, h - 1, w, 1, 0, h);
+			copy(0, 0, 1, h, -1, 0);
+			copy(w - 1, 0, 1, h, w, 0);
+			copy(0, 0, 1, 1, -1, -1);
+			copy(w - 1, 0, 1, 1, w, -1);
+			copy(0, h - 1, 1, 1, -1, h);
+			copy(w - 1, h - 1, 1, 1, w, h);
+		}
+
+		SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, pixels);
+		SDL_FreeSurface(pixels);
+		if (!texture) {
+			ERROR("Unable to create skin atlas page: %s\n", SDL_GetError());
+			break;
+		}
+		SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+		pages.emplace_back(texture, SDL_DestroyTexture);
+	}
+
+	for (auto &entry : candidates) {
+		SDL_FreeSurface(entry.pixels);
+		entry.pixels = nullptr;
+		if (entry.page < pages.size())
+			entries.emplace(entry.path, entry);
+	}
+
+	bytes = 0;
+	for (size_t i = 0; i < pages.size(); i++)
+		bytes += size_t(pageSize) * pageHeights[i] * 4;
+	INFO("Skin atlas: %zu images in %zu page(s) of %dx%d, %zu KiB\n",
+			entries.size(), pages.size(), pageSize,
+			pageHeights.empty() ? 0 : pageHeights[0], bytes / 1024);
+
+	candidates.clear();
+}
+
+void SkinAtlas::clear()
+{
+	for (auto &entry : candidates)
+		SDL_FreeSurface(entry.pixels);
+	candidates.clear();
+	entries.clear();
+	pages.clear();
+	bytes = 0;
+}
+
+shared_ptr<OffscreenSurface> SkinAtlas::find(const string &path,
+		unsigned int width, unsigned int height) const
+{
+	auto it = entries.find(path);
+	if (it == entries.end())
+		return nullptr;
+
+	const Entry &entry = it->second;
+	if ((width && int(width) != entry.rect.w)
+			|| (height && int(height) != entry.rect.h))
+		return nullptr;
+
+	return shared_ptr<OffscreenSurface>(
+			new OffscreenSurface(pages[entry.page], entry.rect));
+}
@@ -0,0 +1,78 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#ifndef SKINATLAS_H
+#define SKINATLAS_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+class OffscreenSurface;
+
+/**
+ * Packs the small images of a skin (icons, buttons, battery levels, bars)
+ * into a few large textures.
+ *
+ * Blitting many surfaces that share one texture lets the renderer batch
+ * the copies instead of binding a different texture for every icon, and
+ * loading the skin costs a handful of texture uploads instead of one per
+ * image.
+ */
+class SkinAtlas {
+public:
+	/**
+	 * Builds the atlas from the images found in the given skin
+	 * directories. Each relative image name is resolved through
+	 * the given function, which returns the file that should be used
+	 * for it or an empty string.
+	 */
+	template <typename Resolve>
+	void build(const std::vector<std::string> &skinDirs, Resolve resolve) {
+		clear();
+		for (auto &name : listImages(skinDirs)) {
+			std::string path = resolve(name);
+			if (!path.empty())
+				addCandidate(path);
+		}
+		pack();
+	}
+
+	/** Releases all pages. Surfaces handed out earlier remain valid. */
+	void clear();
+
+	/**
+	 * Returns a surface for the given image file if it is in the atlas,
+	 * or nullptr otherwise. A non-zero width or height only matches if the
+	 * image has that size, since atlas entries are never scaled.
+	 */
+	std::shared_ptr<OffscreenSurface> find(const std::string &path,
+			unsigned int width = 0, unsigned int height = 0) const;
+
+	size_t size() const { return entries.size(); }
+	size_t pageCount() const { return pages.size(); }
+	/** Size in bytes of all pages together. */
+	size_t textureBytes() const { return bytes; }
+
+private:
+	struct Entry {
+		std::string path;
+		SDL_Surface *pixels;
+		size_t page;
+		SDL_Rect rect;
+	};
+
+	static std::vector<std::string> listImages(
+			const std::vector<std::string> &skinDirs);
+	void addCandidate(const std::string &path);
+	void pack();
+
+	std::vector<Entry> candidates;
+	std::vector<std::shared_ptr<SDL_Texture>> pages;
+	std::unordered_map<std::string, Entry> entries;
+	size_t bytes = 0;
+};
+
+#endif
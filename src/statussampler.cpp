@@ -0,0 +1,179 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#include "statussampler.h"
+
+#include "compat-filesystem.h"
+#include "debug.h"
+#include "utilities.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <system_error>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace std::chrono;
+
+/** The battery level changes slowly; this is how often it was checked. */
+static constexpr seconds BATTERY_INTERVAL(60);
+/** Files are not written often while the menu is shown. */
+static constexpr seconds DISK_INTERVAL(10);
+
+StatusSampler::StatusSampler(Battery battery, string path)
+	: battery(std::move(battery))
+	, path(std::move(path))
+	, last{ (unsigned long) -1, (unsigned long) -1, 0 }
+	, published(0)
+	, stopping(false)
+{
+	sample(true, true);
+
+	if (pipe2(wakeFds, O_CLOEXEC | O_NONBLOCK) < 0) {
+		ERROR("Unable to create status sampler pipe: %s\n", strerror(errno));
+		wakeFds[0] = wakeFds[1] = -1;
+		mountsFd = -1;
+		return;
+	}
+	mountsFd = open("/proc/self/mounts", O_RDONLY | O_CLOEXEC);
+	if (mountsFd < 0)
+		WARNING("Unable to watch mounts: %s\n", strerror(errno));
+
+	thread = std::thread(&StatusSampler::run, this);
+}
+
+StatusSampler::~StatusSampler()
+{
+	if (thread.joinable()) {
+		stopping = true;
+		refresh();
+		thread.join();
+	}
+	if (mountsFd >= 0)
+		close(mountsFd);
+	if (wakeFds[0] >= 0) {
+		close(wakeFds[0]);
+		close(wakeFds[1]);
+	}
+}
+
+StatusSampler::Status StatusSampler::status() const
+{
+	Status status;
+	unsigned int generation;
+	do {
+		generation = published.load(memory_order_acquire);
+		const Slot &slot = slots[generation % 2];
+		status.freeMiB = slot.freeMiB.load(memory_order_relaxed);
+		status.totalMiB = slot.totalMiB.load(memory_order_relaxed);
+		status.batteryLevel = slot.batteryLevel.load(memory_order_relaxed);
+		// Pairs with the fence in publish(): if any of the loads saw the
+		// next snapshot being written to this slot, the generation changed.
+		atomic_thread_fence(memory_order_acquire);
+	} while (published.load(memory_order_relaxed) != generation);
+	return status;
+}
+
+void StatusSampler::refresh()
+{
+	if (wakeFds[1] >= 0) {
+		const char c = 0;
+		// If the pipe is full, the thread is going to wake up anyway.
+		if (write(wakeFds[1], &c, 1) < 0 && errno != EAGAIN) {
+			// Nothing sensible to do; this may run in a signal handler.
+		}
+	}
+}
+
+void StatusSampler::run()
+{
+	auto nextBattery = steady_clock::now() + BATTERY_INTERVAL;
+	auto nextDisk = steady_clock::now() + DISK_INTERVAL;
+
+	while (true) {
+		const auto timeout = duration_cast<milliseconds>(
+				min(nextBattery, nextDisk) - steady_clock::now()).count();
+		struct pollfd fds[2] = {
+			{ wakeFds[0], POLLIN, 0 },
+			{ mountsFd, POLLPRI, 0 },
+		};
+		const int ret = poll(fds, mountsFd >= 0 ? 2 : 1,
+				int(max<long long>(0, timeout + 1)));
+		if (ret < 0 && errno != EINTR) {
+			ERROR("Status sampler: poll failed: %s\n", strerror(errno));
+			return;
+		}
+
+		bool sampleBattery = false, sampleDisk = false;
+		if (ret > 0 && (fds[0].revents & POLLIN)) {
+			char buf[16];
+			while (read(wakeFds[0], buf, sizeof(buf)) > 0);
+			if (stopping)
+				return;
+			sampleBattery = sampleDisk = true;
+		}
+		if (ret > 0 && (fds[1].revents & (POLLPRI | POLLERR))) {
+			DEBUG("Mounts changed, sampling disk space\n");
+			sampleDisk = true;
+		}
+
+		const auto now = steady_clock::now();
+		if (now >= nextBattery)
+			sampleBattery = true;
+		if (now >= nextDisk)
+			sampleDisk = true;
+		if (sampleBattery)
+			nextBattery = now + BATTERY_INTERVAL;
+		if (sampleDisk)
+			nextDisk = now + DISK_INTERVAL;
+
+		if (sample(sampleBattery, sampleDisk))
+			request_repaint();
+	}
+}
+
+bool StatusSampler::sample(bool sampleBattery, bool sampleDisk)
+{
+	Status status = last;
+
+	if (sampleBattery)
+		status.batteryLevel = battery.getBatteryLevel();
+
+	if (sampleDisk) {
+		error_code ec;
+		auto space = compat::filesystem::space(path, ec);
+		if (!ec) {
+			status.freeMiB = space.free / (1024 * 1024);
+			status.totalMiB = space.capacity / (1024 * 1024);
+		} else {
+			status.freeMiB = status.totalMiB = 0;
+		}
+	}
+
+	if (published.load(memory_order_relaxed)
+			&& status.freeMiB == last.freeMiB
+			&& status.totalMiB == last.totalMiB
+			&& status.batteryLevel == last.batteryLevel)
+		return false;
+
+	last = status;
+	publish(status);
+	return true;
+}
+
+void StatusSampler::publish(const Status &status)
+{
+	const unsigned int generation = published.load(memory_order_relaxed) + 1;
+	Slot &slot = slots[generation % 2];
+	// Readers of the previous snapshot in this slot must see that the
+	// generation moved on before they can see any of the new values.
+	atomic_thread_fence(memory_order_release);
+	slot.freeMiB.store(status.freeMiB, memory_order_relaxed);
+	slot.totalMiB.store(status.totalMiB, memory_order_relaxed);
+	slot.batteryLevel.store(status.batteryLevel, memory_order_relaxed);
+	published.store(generation, memory_order_release);
+}
@@ -0,0 +1,88 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#ifndef STATUSSAMPLER_H
+#define STATUSSAMPLER_H
+
+#include "battery.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+/**
+ * Samples the system status that is shown in the bottom bar.
+ *
+ * Reading sysfs and calling statvfs() is not something a frame should wait
+ * for, so a background thread samples the battery and the free disk space
+ * on their own intervals, as well as when a file system is mounted or
+ * unmounted. Each time the status changes, it publishes a new snapshot and
+ * requests a repaint.
+ *
+ * Snapshots alternate between two slots: the generation counter tells
+ * which slot holds the latest one, and readers copy it without locking,
+ * retrying in the rare case that the thread refilled the slot meanwhile.
+ */
+class StatusSampler {
+public:
+	struct Status {
+		unsigned long freeMiB, totalMiB;
+		unsigned short batteryLevel;
+	};
+
+	/**
+	 * Takes the first sample right away, then starts the thread.
+	 * The free space is that of the file system containing the given path.
+	 */
+	StatusSampler(Battery battery, std::string path);
+	~StatusSampler();
+
+	StatusSampler(const StatusSampler&) = delete;
+	StatusSampler& operator=(const StatusSampler&) = delete;
+
+	/**
+	 * Returns a number that changes every time a new status is published.
+	 * This is a single atomic load, so it is cheap enough to check every
+	 * frame; only load the status when it changed.
+	 */
+	unsigned int generation() const {
+		return published.load(std::memory_order_acquire);
+	}
+
+	/** Returns the latest snapshot. Lock-free. */
+	Status status() const;
+
+	/**
+	 * Samples everything again, without waiting for the result.
+	 * Async-signal-safe.
+	 */
+	void refresh();
+
+private:
+	void run();
+	/** Returns true if a new status was published. */
+	bool sample(bool battery, bool disk);
+	void publish(const Status &status);
+
+	const Battery battery;
+	const std::string path;
+
+	/** Only used by the thread, after the first sample. */
+	Status last;
+
+	/** Written by the thread only; generation N is in slots[N % 2]. */
+	struct Slot {
+		std::atomic<unsigned long> freeMiB, totalMiB;
+		std::atomic<unsigned short> batteryLevel;
+	};
+	Slot slots[2];
+	std::atomic<unsigned int> published;
+
+	/** Writing to the pipe wakes up the thread. */
+	int wakeFds[2];
+	/** Polls with POLLPRI whenever the mount table changes; -1 if not. */
+	int mountsFd;
+	std::atomic<bool> stopping;
+	std::thread thread;
+};
+
+#endif // STATUSSAMPLER_H
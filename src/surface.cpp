@@ -37,6 +37,10 @@
 using namespace std;
 
 SDL_Renderer* Surface::globalRenderer = nullptr;
+Surface::RenderStats Surface::renderStats = {};
+
+/** Source texture of the most recent draw, for counting texture binds. */
+static SDL_Texture *lastSource = nullptr;
 
 // RGBAColor:
 
@@ -78,21 +82,34 @@ Surface::Surface(Surface const& other)
 	SDL_QueryTexture(other.texture, &format, nullptr, nullptr, nullptr);
 	texture = SDL_CreateTexture(renderer, format, SDL_TEXTUREACCESS_TARGET, w, h);
 	SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
-	SDL_Texture* currentTexture = SDL_GetRenderTarget(renderer);
-	SDL_SetRenderTarget(renderer, texture);
-	SDL_RenderCopy(renderer, other.texture, nullptr, nullptr);
-	SDL_SetRenderTarget(renderer, currentTexture);
+	srcX = srcY = 0;
+	other.copyTo(texture, SDL_Rect{ other.srcX, other.srcY, w, h }, nullptr);
+}
+
+void Surface::copyTo(SDL_Texture *destination, SDL_Rect const& src, SDL_Rect const *dest) const {
+	SDL_Texture *currentTexture = SDL_GetRenderTarget(renderer);
+	if (currentTexture != destination) {
+		SDL_SetRenderTarget(renderer, destination);
+		renderStats.targetSwitches++;
+	}
+	SDL_RenderCopy(renderer, texture, &src, dest);
+	renderStats.drawCalls++;
+	if (texture != lastSource) {
+		lastSource = texture;
+		renderStats.textureBinds++;
+	}
+	if (currentTexture != destination) {
+		SDL_SetRenderTarget(renderer, currentTexture);
+		renderStats.targetSwitches++;
+	}
 }
 
 void Surface::blit(SDL_Texture *destination, int x, int y, int w, int h, int a) const {
 	if (destination == NULL || a==0) return;
 
-	SDL_Rect src = { 0, 0, static_cast<Uint16>(w ? w : this->w), static_cast<Uint16>(h ? h : this->h) };
+	SDL_Rect src = { srcX, srcY, static_cast<Uint16>(w ? w : this->w), static_cast<Uint16>(h ? h : this->h) };
 	SDL_Rect dest = { x, y, src.w, src.h };
-	SDL_Texture *currentTexture = SDL_GetRenderTarget(renderer);
-	SDL_SetRenderTarget(renderer, destination);
-	SDL_RenderCopy(renderer, texture, &src, &dest);
-	SDL_SetRenderTarget(renderer, currentTexture);
+	copyTo(destination, src, &dest);
 }
 
 void Surface::blit(Surface& destination, int x, int y, int w, int h, int a) const {
@@ -114,6 +131,10 @@ void Surface::blitRight(SDL_Texture *destination, int x, int y, int w, int h, in
 	blit(destination, x - min(this->w, w), y, w, h, a);
 }
 
+void Surface::blitScaled(Surface& destination, SDL_Rect rect) const {
+	copyTo(destination.texture, SDL_Rect{ srcX, srcY, w, h }, &rect);
+}
+
 void Surface::blitRight(Surface& destination, int x, int y, int w, int h, int a) const {
 	if (!w) w = this->w;
 	blitRight(destination.texture, x, y, w, h, a);
@@ -126,6 +147,7 @@ void Surface::box(SDL_Rect re, RGBAColor c) {
 	SDL_SetRenderDrawColor(renderer, c.r, c.g, c.b, c.a);
 	SDL_RenderFillRect(renderer, &re);
 	SDL_SetRenderTarget(renderer, currentTexture);
+	renderStats.drawCalls++;
 }
 
 void Surface::rectangle(SDL_Rect re, RGBAColor c) {
@@ -244,11 +266,23 @@ shared_ptr<OffscreenSurface> OffscreenSurface::emptySurface(
 	return shared_ptr<OffscreenSurface>(new OffscreenSurface(texture));
 }
 
+shared_ptr<OffscreenSurface> OffscreenSurface::fromSurface(SDL_Surface *raw)
+{
+	SDL_Texture *texture = SDL_CreateTextureFromSurface(Surface::getGlobalRenderer(), raw);
+	if (!texture) {
+		DEBUG("Couldn't create texture from surface: %s\n", SDL_GetError());
+		return shared_ptr<OffscreenSurface>();
+	}
+
+	SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+	return shared_ptr<OffscreenSurface>(new OffscreenSurface(texture));
+}
+
 shared_ptr<OffscreenSurface> OffscreenSurface::loadImage(
 		const GMenu2X &gmenu2x, const string& img,
 		unsigned int width, unsigned int height, bool loadAlpha)
 {
-	SDL_Surface *raw = loadPNG(img, loadAlpha);
+	SDL_Surface *raw = loadImageFile(img, loadAlpha);
 	if (!raw) {
 		DEBUG("Couldn't load surface '%s'\n", img.c_str());
 		return shared_ptr<OffscreenSurface>();
@@ -289,15 +323,30 @@ shared_ptr<OffscreenSurface> OffscreenSurface::loadImage(
 	return shared_ptr<OffscreenSurface>(new OffscreenSurface(texture));
 }
 
+OffscreenSurface::OffscreenSurface(shared_ptr<SDL_Texture> atlas, SDL_Rect const& area)
+	: Surface(atlas.get())
+	, sharedTexture(std::move(atlas))
+{
+	srcX = area.x;
+	srcY = area.y;
+	w = area.w;
+	h = area.h;
+}
+
 OffscreenSurface::OffscreenSurface(OffscreenSurface&& other)
 	: Surface(other.texture, other.renderer)
+	, sharedTexture(std::move(other.sharedTexture))
 {
+	srcX = other.srcX;
+	srcY = other.srcY;
+	w = other.w;
+	h = other.h;
 	other.texture = nullptr;
 }
 
 OffscreenSurface::~OffscreenSurface()
 {
-	if (texture) SDL_DestroyTexture(texture);
+	if (texture && !sharedTexture) SDL_DestroyTexture(texture);
 }
 
 OffscreenSurface& OffscreenSurface::operator=(OffscreenSurface other)
@@ -312,6 +361,19 @@ void OffscreenSurface::swap(OffscreenSurface& other)
 	std::swap(renderer, other.renderer);
 	std::swap(w, other.w);
 	std::swap(h, other.h);
+	std::swap(srcX, other.srcX);
+	std::swap(srcY, other.srcY);
+	std::swap(sharedTexture, other.sharedTexture);
+}
+
+size_t OffscreenSurface::textureBytes() const
+{
+	Uint32 format;
+	int texW, texH;
+	if (!texture || sharedTexture
+			|| SDL_QueryTexture(texture, &format, nullptr, &texW, &texH) < 0)
+		return 0;
+	return size_t(texW) * texH * SDL_BYTESPERPIXEL(format);
 }
 
 void OffscreenSurface::convertToDisplayFormat() {
@@ -405,6 +467,9 @@ unique_ptr<OutputSurface> OutputSurface::open(
 }
 
 void OutputSurface::flip() {
+	if (presentHook)
+		presentHook(*this);
+
 	SDL_Texture *currentTexture = SDL_GetRenderTarget(renderer);
 	SDL_SetRenderTarget(renderer, nullptr);
 	SDL_RenderClear(renderer);
@@ -412,3 +477,17 @@ void OutputSurface::flip() {
 	SDL_RenderPresent(renderer);
 	SDL_SetRenderTarget(renderer, currentTexture);
 }
+
+vector<Uint32> OutputSurface::readPixels() const
+{
+	vector<Uint32> pixels(size_t(w) * h);
+	SDL_Texture *currentTexture = SDL_GetRenderTarget(renderer);
+	SDL_SetRenderTarget(renderer, texture);
+	if (SDL_RenderReadPixels(renderer, nullptr, SDL_PIXELFORMAT_ARGB8888,
+				pixels.data(), w * sizeof(Uint32)) < 0) {
+		ERROR("Unable to read back the screen: %s\n", SDL_GetError());
+		pixels.clear();
+	}
+	SDL_SetRenderTarget(renderer, currentTexture);
+	return pixels;
+}
@@ -27,9 +27,11 @@
 #include <SDL2/SDL.h>
 
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <ostream>
 #include <string>
+#include <vector>
 
 class GMenu2X;
 
@@ -50,8 +52,17 @@ std::ostream& operator<<(std::ostream& os, RGBAColor const& color);
  */
 class Surface {
 public:
+	/** Running totals of the render calls issued through surfaces. */
+	struct RenderStats {
+		unsigned long drawCalls;
+		/** Draws whose source texture differs from the previous draw's. */
+		unsigned long textureBinds;
+		unsigned long targetSwitches;
+	};
+
 	static void setGlobalRenderer(SDL_Renderer* renderer) { globalRenderer = renderer; }
 	static SDL_Renderer* getGlobalRenderer() { return globalRenderer; }
+	static RenderStats const& getRenderStats() { return renderStats; }
 
 	Surface& operator=(Surface const& other) = delete;
 
@@ -66,6 +77,8 @@ public:
 	void blit(Surface& destination, SDL_Rect container, Font::HAlign halign = Font::HAlignLeft, Font::VAlign valign = Font::VAlignTop) const;
 	void blitCenter(Surface& destination, int x, int y, int w=0, int h=0, int a=-1) const;
 	void blitRight(Surface& destination, int x, int y, int w=0, int h=0, int a=-1) const;
+	/** Blits the whole surface, stretched or shrunk to fill the given rect. */
+	void blitScaled(Surface& destination, SDL_Rect rect) const;
 
 	void box(SDL_Rect re, RGBAColor c);
 	void box(Sint16 x, Sint16 y, Uint16 w, Uint16 h, RGBAColor c) {
@@ -88,6 +101,8 @@ protected:
 		, renderer(renderer ? renderer : globalRenderer)
 		, w(0)
 		, h(0)
+		, srcX(0)
+		, srcY(0)
 	{
 		if (texture) {
 			SDL_QueryTexture(texture, nullptr, nullptr, &w, &h);
@@ -98,6 +113,11 @@ protected:
 	SDL_Texture *texture;
 	SDL_Renderer *renderer;
 	int w, h;
+	/** Origin of this surface inside its texture; non-zero for atlas entries. */
+	int srcX, srcY;
+
+	/** Copies the given area of this surface's texture onto the destination. */
+	void copyTo(SDL_Texture *destination, SDL_Rect const& src, SDL_Rect const *dest) const;
 
 	// For direct access to texture and renderer
 	friend class Font;
@@ -105,6 +125,7 @@ protected:
 private:
 	static SDL_Renderer* globalRenderer;
 	static SDL_Texture* globalTexture;
+	static RenderStats renderStats;
 
 	void blit(SDL_Texture *destination, int x, int y, int w=0, int h=0, int a=-1) const;
 	void blitCenter(SDL_Texture *destination, int x, int y, int w=0, int h=0, int a=-1) const;
@@ -127,6 +148,11 @@ public:
 			const GMenu2X &gmenu2x, const std::string& img,
 			unsigned int width = 0, unsigned int height = 0,
 			bool loadAlpha = true);
+	/**
+	 * Uploads the pixels of a software surface into a new texture.
+	 * The caller keeps ownership of the software surface.
+	 */
+	static std::shared_ptr<OffscreenSurface> fromSurface(SDL_Surface *raw);
 
 	OffscreenSurface(Surface const& other) : Surface(other) {}
 	OffscreenSurface(OffscreenSurface const& other) : Surface(other) {}
@@ -142,10 +168,22 @@ public:
 	 */
 	void convertToDisplayFormat();
 
+	/**
+	 * Returns the size in bytes of the texture owned by this surface, or 0
+	 * if the texture is shared with other surfaces, like an atlas page.
+	 */
+	size_t textureBytes() const;
+
 private:
 	friend class FontStack;
+	friend class SkinAtlas;
+	/** Refers to the given area of a texture shared with other surfaces. */
+	OffscreenSurface(std::shared_ptr<SDL_Texture> atlas, SDL_Rect const& area);
 	OffscreenSurface(SDL_Surface *raw) : Surface(SDL_CreateTextureFromSurface(Surface::getGlobalRenderer(), raw)) {}
 	OffscreenSurface(SDL_Texture *texture, SDL_Renderer *renderer = nullptr) : Surface(texture, renderer) {}
+
+	/** Owner of the texture if it is shared, for example an atlas page. */
+	std::shared_ptr<SDL_Texture> sharedTexture;
 };
 
 /**
@@ -165,9 +203,24 @@ public:
 	void flip();
 	~OutputSurface();
 
+	/**
+	 * Sets a function to call with this surface whenever a flip is about to
+	 * present the current buffer; used for recording replays.
+	 */
+	void setPresentHook(std::function<void(OutputSurface&)> hook) {
+		presentHook = std::move(hook);
+	}
+
+	/**
+	 * Returns the pixels of the current buffer in ARGB8888, row by row, or
+	 * an empty vector on failure. This waits for the renderer to finish.
+	 */
+	std::vector<Uint32> readPixels() const;
+
 private:
 	OutputSurface(SDL_Texture *texture, SDL_Renderer *renderer, SDL_Window *window);
 	SDL_Window *window;
+	std::function<void(OutputSurface&)> presentHook;
 };
 
 #endif
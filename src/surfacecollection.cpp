@@ -19,6 +19,7 @@
  ***************************************************************************/
 
 #include "surfacecollection.h"
+#include "imageio.h"
 #include "surface.h"
 #include "utilities.h"
 #include "debug.h"
@@ -30,7 +31,7 @@ using std::endl;
 using std::string;
 
 SurfaceCollection::SurfaceCollection(GMenu2X *gmenu2x)
-	: gmenu2x(gmenu2x), skin("Default")
+	: stats(), skin("Default"), gmenu2x(gmenu2x)
 {
 }
 
@@ -38,6 +39,16 @@ SurfaceCollection::~SurfaceCollection() {}
 
 void SurfaceCollection::setSkin(const string &skin) {
 	this->skin = skin;
+
+	atlas.clear();
+	if (Surface::getGlobalRenderer()) {
+		atlas.build({
+			gmenu2x->getLocalSkinPath(skin),
+			gmenu2x->getSystemSkinPath(skin),
+			gmenu2x->getLocalSkinPath("Default"),
+			gmenu2x->getSystemSkinPath("Default"),
+		}, [this](const string &name) { return getSkinFilePath(name); });
+	}
 }
 
 /* Returns the location of a skin directory,
@@ -59,23 +70,23 @@ string SurfaceCollection::getSkinFilePath(const string &file, bool useDefault)
 {
 	/* We first search the skin file on the user-specific directory. */
 	string path = gmenu2x->getLocalSkinPath(skin) + "/" + file;
-	if (fileExists(path))
+	if (imageFileExists(path))
 	  return path;
 
 	/* If not found, we search that skin file on the system directory. */
 	path = gmenu2x->getSystemSkinPath(skin) + "/" + file;
-	if (fileExists(path))
+	if (imageFileExists(path))
 	  return path;
 
 	/* If it is nowhere to be found, as a last resort we check the
 	 * "Default" skin for a corresponding (but probably not similar) file. */
 	if (useDefault) {
 		path = gmenu2x->getLocalSkinPath("Default") + "/" + file;
-		if (fileExists(path))
+		if (imageFileExists(path))
 		  return path;
 
 		path = gmenu2x->getSystemSkinPath("Default") + "/" + file;
-		if (fileExists(path))
+		if (imageFileExists(path))
 		  return path;
 	}
 
@@ -87,6 +98,18 @@ void SurfaceCollection::debug() {
 	for(SurfaceHash::iterator curr = surfaces.begin(); curr != end; curr++){
 		DEBUG("key: %s\n", curr->first.c_str());
 	}
+	DEBUG("%lu cache hits, %lu atlas hits, %lu loads; atlas holds %zu images in %zu page(s)\n",
+			stats.hits, stats.atlasHits, stats.loads,
+			atlas.size(), atlas.pageCount());
+}
+
+size_t SurfaceCollection::textureBytes() const {
+	size_t bytes = atlas.textureBytes();
+	for (auto const& it : surfaces) {
+		if (it.second)
+			bytes += it.second->textureBytes();
+	}
+	return bytes;
 }
 
 bool SurfaceCollection::exists(const string &path) {
@@ -107,13 +130,13 @@ std::shared_ptr<OffscreenSurface> SurfaceCollection::add(const string &path,
 		if (filePath.empty())
 			return nullptr;
 
-	} else if ((filePath.find('#') == filePath.npos) && (!fileExists(filePath))) {
+	} else if ((filePath.find('#') == filePath.npos) && (!imageFileExists(filePath))) {
 		WARNING("Unable to add image %s\n", path.c_str());
 		return nullptr;
 	}
 
 	DEBUG("Adding surface: '%s'\n", path.c_str());
-	auto surface = OffscreenSurface::loadImage(*gmenu2x, filePath, width, height);
+	auto surface = load(filePath, width, height);
 	if (surface)
 		surfaces[path] = surface;
 	return surface;
@@ -131,12 +154,25 @@ std::shared_ptr<OffscreenSurface> SurfaceCollection::addSkinRes(const string &pa
 		return nullptr;
 
 	DEBUG("Adding skin surface: '%s'\n", path.c_str());
-	auto surface = OffscreenSurface::loadImage(*gmenu2x, skinpath);
+	auto surface = load(skinpath, 0, 0);
 	if (surface)
 		surfaces[path] = surface;
 	return surface;
 }
 
+std::shared_ptr<OffscreenSurface> SurfaceCollection::load(const string &filePath,
+							  unsigned int width,
+							  unsigned int height) {
+	auto surface = atlas.find(filePath, width, height);
+	if (surface) {
+		stats.atlasHits++;
+		return surface;
+	}
+
+	stats.loads++;
+	return OffscreenSurface::loadImage(*gmenu2x, filePath, width, height);
+}
+
 void SurfaceCollection::del(const string &path) {
 	SurfaceHash::iterator i = surfaces.find(path);
 	if (i != surfaces.end()) {
@@ -148,6 +184,7 @@ void SurfaceCollection::del(const string &path) {
 
 void SurfaceCollection::clear() {
 	surfaces.clear();
+	atlas.clear();
 }
 
 void SurfaceCollection::move(const string &from, const string &to) {
@@ -160,8 +197,9 @@ std::shared_ptr<OffscreenSurface> SurfaceCollection::operator[](const string &ke
 	SurfaceHash::iterator i = surfaces.find(key);
 	if (i == surfaces.end())
 		return add(key);
-	else
-		return i->second;
+
+	stats.hits++;
+	return i->second;
 }
 
 std::shared_ptr<OffscreenSurface> SurfaceCollection::skinRes(const string &key, bool useDefault) {
@@ -170,6 +208,7 @@ std::shared_ptr<OffscreenSurface> SurfaceCollection::skinRes(const string &key,
 	SurfaceHash::iterator i = surfaces.find(key);
 	if (i == surfaces.end())
 		return addSkinRes(key, useDefault);
-	else
-		return i->second;
+
+	stats.hits++;
+	return i->second;
 }
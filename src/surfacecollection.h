@@ -20,6 +20,8 @@
 #ifndef SURFACECOLLECTION_H
 #define SURFACECOLLECTION_H
 
+#include "skinatlas.h"
+
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -44,6 +46,23 @@ public:
 
 	void debug();
 
+	/** Lookup counters, for judging how well the skin atlas covers a skin. */
+	struct Stats {
+		/** Lookups served from already loaded surfaces. */
+		unsigned long hits;
+		/** Surfaces created from the skin atlas. */
+		unsigned long atlasHits;
+		/** Surfaces decoded from their own image file. */
+		unsigned long loads;
+	};
+	Stats const& getStats() const { return stats; }
+
+	/**
+	 * Returns the texture memory used by the loaded surfaces, in bytes.
+	 * The skin atlas pages are counted once, however many surfaces use them.
+	 */
+	size_t textureBytes() const;
+
 	std::shared_ptr<OffscreenSurface> addSkinRes(const std::string &path, bool useDefault = true);
 	void     del(const std::string &path);
 	void     clear();
@@ -60,7 +79,13 @@ public:
 private:
 	using SurfaceHash = std::unordered_map<std::string, std::shared_ptr<OffscreenSurface>>;
 
+	std::shared_ptr<OffscreenSurface> load(const std::string &filePath,
+					       unsigned int width,
+					       unsigned int height);
+
 	SurfaceHash surfaces;
+	SkinAtlas atlas;
+	Stats stats;
 	std::string skin;
 
 	GMenu2X *gmenu2x;
@@ -20,102 +20,166 @@
 
 #include "textdialog.h"
 
+#include "document.h"
 #include "gmenu2x.h"
 #include "utilities.h"
-#include "word_wrap.h"
+#include "wrappedtext.h"
 
 #include <algorithm>
 
 using namespace std;
 
-TextDialog::TextDialog(GMenu2X& gmenu2x, const string &title, const string &description, const string &icon, const string &text)
+TextDialog::TextDialog(GMenu2X& gmenu2x, const string &title, const string &description, const string &icon, shared_ptr<Document> document)
 	: Dialog(gmenu2x)
+	, document(std::move(document))
+	, firstRow(0)
 {
-	split(this->text, wordWrap(*gmenu2x.font, text, gmenu2x.width() - 15), "\n");
 	this->title = title;
 	this->description = description;
 	this->icon = icon;
+
+	const int fontHeight = gmenu2x.font->getLineSpacing();
+	unsigned int contentHeight;
+	tie(contentY, contentHeight) = gmenu2x.getContentArea();
+	rowsPerPage = max(contentHeight / fontHeight, 1u);
+	contentY += (contentHeight % fontHeight) / 2;
 }
 
-void TextDialog::drawText(const vector<string> &text, unsigned int y,
-		unsigned int firstRow, unsigned int rowsPerPage)
+TextDialog::~TextDialog()
 {
-	Surface& s = *gmenu2x.s;
-	const int fontHeight = gmenu2x.font->getLineSpacing();
+}
 
-	for (unsigned i = firstRow; i < firstRow + rowsPerPage && i < text.size(); i++) {
-		const string &line = text.at(i);
-		int rowY = y + (i - firstRow) * fontHeight;
-		if (line == "----") { // horizontal ruler
-			rowY += fontHeight / 2;
-			s.box(5, rowY, gmenu2x.width() - 16, 1, 255, 255, 255, 130);
-			s.box(5, rowY+1, gmenu2x.width() - 16, 1, 0, 0, 0, 130);
-		} else {
-			gmenu2x.font->write(s, line, 5, rowY);
-		}
+void TextDialog::paintBackground(Surface& s)
+{
+	if (!bg) {
+		bg.reset(new OffscreenSurface(*gmenu2x.bg));
+		//link icon
+		if (!fileExists(icon))
+			drawTitleIcon(*bg, "icons/ebook.png", true);
+		else
+			drawTitleIcon(*bg, icon, false);
+		drawBackground(*bg);
+		bg->convertToDisplayFormat();
 	}
-
-	gmenu2x.drawScrollBar(rowsPerPage, text.size(), firstRow);
+	bg->blit(s, 0, 0);
 }
 
-void TextDialog::exec() {
-	bool close = false;
-
-	OffscreenSurface bg(*gmenu2x.bg);
-
-	//link icon
-	if (!fileExists(icon))
-		drawTitleIcon(bg, "icons/ebook.png", true);
-	else
-		drawTitleIcon(bg, icon, false);
-	writeTitle(bg, title);
-	writeSubTitle(bg, description);
+void TextDialog::drawBackground(Surface& s)
+{
+	writeTitle(s, title);
+	writeSubTitle(s, description);
 
 	int x = 5;
-	x = gmenu2x.drawButton(bg, "up", "", x);
-	x = gmenu2x.drawButton(bg, "down", gmenu2x.tr["Scroll"], x);
-	x = gmenu2x.drawButton(bg, "cancel", "", x);
-	x = gmenu2x.drawButton(bg, "start", gmenu2x.tr["Exit"], x);
+	x = gmenu2x.drawButton(s, "up", "", x);
+	x = gmenu2x.drawButton(s, "down", gmenu2x.tr["Scroll"], x);
+	x = gmenu2x.drawButton(s, "left", "", x);
+	x = gmenu2x.drawButton(s, "right", gmenu2x.tr["Jump"], x);
+	x = gmenu2x.drawButton(s, "cancel", "", x);
+	x = gmenu2x.drawButton(s, "start", gmenu2x.tr["Exit"], x);
 	(void)x;
+}
+
+compat::string_view TextDialog::shownText()
+{
+	return document->text();
+}
+
+WrappedText &TextDialog::text()
+{
+	// Only the rows around the shown position get wrapped, so that even
+	// huge logs open right away. A replay counts the rows up front, since
+	// the scroll bar would otherwise depend on how far the count got.
+	if (!wrapped) {
+		wrapped.reset(new WrappedText(*gmenu2x.font, shownText(),
+				gmenu2x.width() - 15, !gmenu2x.isReplaying()));
+	}
+	return *wrapped;
+}
 
-	bg.convertToDisplayFormat();
+void TextDialog::resetText()
+{
+	wrapped.reset();
+}
 
+void TextDialog::drawText(Surface& s, WrappedText &text, unsigned int y,
+		size_t firstRow, unsigned int rowsPerPage)
+{
 	const int fontHeight = gmenu2x.font->getLineSpacing();
-	unsigned int contentY, contentHeight;
-	tie(contentY, contentHeight) = gmenu2x.getContentArea();
-	const unsigned rowsPerPage = max(contentHeight / fontHeight, 1u);
-	const unsigned maxFirstRow =
-			text.size() < rowsPerPage ? 0 : text.size() - rowsPerPage;
-	contentY += (contentHeight % fontHeight) / 2;
 
-	unsigned firstRow = 0;
-	while (!close) {
-		OutputSurface& s = *gmenu2x.s;
-
-		bg.blit(s, 0, 0);
-		drawText(text, contentY, firstRow, rowsPerPage);
-		s.flip();
-
-		switch(gmenu2x.input.waitForPressedButton()) {
-			case InputManager::UP:
-				if (firstRow > 0) firstRow--;
-				break;
-			case InputManager::DOWN:
-				if (firstRow < maxFirstRow) firstRow++;
-				break;
-			case InputManager::ALTLEFT:
-				if (firstRow >= rowsPerPage - 1) firstRow -= rowsPerPage - 1;
-				else firstRow = 0;
-				break;
-			case InputManager::ALTRIGHT:
-				firstRow = min(firstRow + rowsPerPage - 1, maxFirstRow);
-				break;
-			case InputManager::SETTINGS:
-			case InputManager::CANCEL:
-				close = true;
-				break;
-			default:
-				break;
+	for (auto const& row : text.rows(firstRow, rowsPerPage)) {
+		if (row == "----") { // horizontal ruler
+			const int rulerY = y + fontHeight / 2;
+			s.box(5, rulerY, gmenu2x.width() - 16, 1, 255, 255, 255, 130);
+			s.box(5, rulerY+1, gmenu2x.width() - 16, 1, 0, 0, 0, 130);
+		} else {
+			gmenu2x.font->write(s, row, 5, y);
 		}
+		y += fontHeight;
+	}
+
+	// Estimated until the rows have been counted in the background.
+	gmenu2x.drawScrollBar(s, rowsPerPage, text.totalRows(),
+			text.rowIndex(firstRow));
+}
+
+bool TextDialog::scroll(WrappedText &text, InputManager::Button button,
+		size_t &firstRow, unsigned int rowsPerPage)
+{
+	switch (button) {
+		case InputManager::UP:
+			firstRow = text.previousRow(firstRow);
+			return true;
+		case InputManager::DOWN:
+			firstRow = min(text.nextRow(firstRow),
+					text.lastPage(rowsPerPage));
+			return true;
+		case InputManager::ALTLEFT:
+			firstRow = text.previousRow(firstRow, rowsPerPage - 1);
+			return true;
+		case InputManager::ALTRIGHT:
+			firstRow = min(text.nextRow(firstRow, rowsPerPage - 1),
+					text.lastPage(rowsPerPage));
+			return true;
+		default:
+			return false;
+	}
+}
+
+void TextDialog::close()
+{
+	dismiss();
+	if (onClose)
+		onClose();
+}
+
+void TextDialog::paint(Surface& s)
+{
+	paintBackground(s);
+	drawText(s, text(), contentY, firstRow, rowsPerPage);
+}
+
+bool TextDialog::handleButtonPress(InputManager::Button button)
+{
+	WrappedText &wrapped = text();
+	if (scroll(wrapped, button, firstRow, rowsPerPage))
+		return true;
+
+	const size_t jumpSize = max<size_t>(wrapped.size() / 10, 1);
+	switch (button) {
+		case InputManager::LEFT:
+			firstRow = wrapped.rowAt(
+					firstRow > jumpSize ? firstRow - jumpSize : 0);
+			break;
+		case InputManager::RIGHT:
+			firstRow = min(wrapped.rowAt(firstRow + jumpSize),
+					wrapped.lastPage(rowsPerPage));
+			break;
+		case InputManager::SETTINGS:
+		case InputManager::CANCEL:
+			close();
+			break;
+		default:
+			break;
 	}
+	return true;
 }
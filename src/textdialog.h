@@ -21,24 +21,66 @@
 #ifndef TEXTDIALOG_H
 #define TEXTDIALOG_H
 
+#include "compat-string_view.h"
 #include "dialog.h"
+#include "inputmanager.h"
+#include "layer.h"
 
+#include <functional>
+#include <memory>
 #include <string>
-#include <vector>
 
-class TextDialog : protected Dialog {
+class Document;
+class OffscreenSurface;
+class WrappedText;
+
+class TextDialog : public Layer, protected Dialog {
 protected:
-	std::vector<std::string> text;
+	std::shared_ptr<Document> document;
 	std::string title, description, icon;
 
-	void drawText(const std::vector<std::string> &text, unsigned int y,
-			unsigned int firstRow, unsigned int rowsPerPage);
+	unsigned int contentY, rowsPerPage;
+	size_t firstRow;
+
+	/** Blits the background, drawing it with drawBackground() first. */
+	void paintBackground(Surface& s);
+	/** Draws the title and the buttons on the background. */
+	virtual void drawBackground(Surface& s);
+
+	/** Returns the text that is shown, see text(). */
+	virtual compat::string_view shownText();
+	/** Returns the shown text, wrapped; resetText() wraps it anew. */
+	WrappedText &text();
+	void resetText();
+
+	void drawText(Surface& s, WrappedText &text, unsigned int y,
+			size_t firstRow, unsigned int rowsPerPage);
+	/** Moves firstRow for the scrolling buttons; returns false for other
+	  * buttons. */
+	bool scroll(WrappedText &text, InputManager::Button button,
+			size_t &firstRow, unsigned int rowsPerPage);
+	void close();
 
 public:
 	TextDialog(GMenu2X& gmenu2x, const std::string &title,
 			const std::string &description, const std::string &icon,
-			const std::string &text);
-	void exec();
+			std::shared_ptr<Document> document);
+	virtual ~TextDialog();
+
+	/** Sets what to do once the dialog has been closed. */
+	void setOnClose(std::function<void(void)> action) {
+		onClose = std::move(action);
+	}
+
+	// Layer implementation:
+	virtual bool isModal() const { return true; }
+	virtual void paint(Surface& s);
+	virtual bool handleButtonPress(InputManager::Button button);
+
+private:
+	std::function<void(void)> onClose;
+	std::unique_ptr<OffscreenSurface> bg;
+	std::unique_ptr<WrappedText> wrapped;
 };
 
 #endif // TEXTDIALOG_H
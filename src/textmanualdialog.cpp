@@ -20,141 +20,121 @@
 
 #include "textmanualdialog.h"
 
+#include "document.h"
 #include "gmenu2x.h"
 #include "surface.h"
 #include "utilities.h"
+#include "wrappedtext.h"
 
 #include <algorithm>
 #include <sstream>
 
 using namespace std;
 
-TextManualDialog::TextManualDialog(GMenu2X& gmenu2x, const string &title, const string &icon, const string &text)
-	: TextDialog(gmenu2x, title, "", icon, text)
+TextManualDialog::TextManualDialog(GMenu2X& gmenu2x, const string &title, const string &icon, shared_ptr<Document> document)
+	: TextDialog(gmenu2x, title, "", icon, std::move(document))
+	, page(0)
+	, nextTitle(gmenu2x.tr["Untitled"])
+	, nextStart(0)
+	, nextLine(0)
+	, allSplit(false)
 {
-	//split the text in multiple pages
-	for (size_t i=0; i<this->text.size(); i++) {
-		string line = trim(this->text.at(i));
-		if (line[0]=='[' && line[line.length()-1]==']') {
-			ManualPage mp;
-			mp.title = line.substr(1,line.length()-2);
-			pages.push_back(mp);
-		} else {
-			if (pages.size()==0) {
-				ManualPage mp;
-				mp.title = gmenu2x.tr["Untitled"];
-				pages.push_back(mp);
-			}
-			pages[pages.size()-1].text.push_back(this->text.at(i));
-		}
-	}
-	if (pages.size()==0) {
-		ManualPage mp;
-		mp.title = gmenu2x.tr["Untitled"];
-		pages.push_back(mp);
-	}
+	splitPages(0);
+}
 
-	//delete blank lines at the start and end of each page
-	for (auto& page : pages) {
-		//start lines
-		auto it = page.text.begin();
-		while (it != page.text.end() &&
-				it->find_first_not_of(" \t\r") == string::npos) ++it;
-		page.text.erase(page.text.begin(), it);
-		//end lines
-		it = page.text.end();
-		while (it != page.text.begin() &&
-				(it - 1)->find_first_not_of(" \t\r") == string::npos) --it;
-		page.text.erase(it, page.text.end());
-	}
+bool TextManualDialog::isBlank(size_t line) {
+	return document->line(line).find_first_not_of(" \t\r")
+			== compat::string_view::npos;
+}
+
+void TextManualDialog::addPage(string title, size_t first, size_t last) {
+	//delete blank lines at the start and end of the page
+	while (first < last && isBlank(first)) ++first;
+	while (last > first && isBlank(last - 1)) --last;
+	pages.push_back({ std::move(title), first < last
+			? document->lines(first, last - 1)
+			: compat::string_view() });
 }
 
-void TextManualDialog::exec() {
-	OffscreenSurface bg(*gmenu2x.bg);
+void TextManualDialog::splitPages(size_t n) {
+	//split the text in multiple pages, each starting at a [title] line
+	while (!allSplit && pages.size() <= n) {
+		if (!document->hasLine(nextLine)) {
+			addPage(nextTitle, nextStart, nextLine);
+			allSplit = true;
+			break;
+		}
+		auto line = document->line(nextLine);
+		auto b = line.find_first_not_of(" \t\r");
+		auto e = line.find_last_not_of(" \t\r");
+		if (b != compat::string_view::npos
+				&& line[b] == '[' && line[e] == ']' && e > b) {
+			if (nextLine > 0)
+				addPage(nextTitle, nextStart, nextLine);
+			nextTitle = string(line.substr(b + 1, e - b - 1));
+			nextStart = nextLine + 1;
+		}
+		nextLine++;
+	}
+}
 
-	//link icon
-	if (!fileExists(icon))
-		drawTitleIcon(bg, "icons/ebook.png", true);
-	else
-		drawTitleIcon(bg, icon, false);
-	writeTitle(bg, title+(description.empty() ? "" : ": "+description));
+void TextManualDialog::drawBackground(Surface& s) {
+	writeTitle(s, title+(description.empty() ? "" : ": "+description));
 
 	int x = 5;
-	x = gmenu2x.drawButton(bg, "up", "", x);
-	x = gmenu2x.drawButton(bg, "down", gmenu2x.tr["Scroll"], x);
-	x = gmenu2x.drawButton(bg, "left", "", x);
-	x = gmenu2x.drawButton(bg, "right", gmenu2x.tr["Change page"], x);
-	x = gmenu2x.drawButton(bg, "cancel", "", x);
-	x = gmenu2x.drawButton(bg, "start", gmenu2x.tr["Exit"], x);
+	x = gmenu2x.drawButton(s, "up", "", x);
+	x = gmenu2x.drawButton(s, "down", gmenu2x.tr["Scroll"], x);
+	x = gmenu2x.drawButton(s, "left", "", x);
+	x = gmenu2x.drawButton(s, "right", gmenu2x.tr["Change page"], x);
+	x = gmenu2x.drawButton(s, "cancel", "", x);
+	x = gmenu2x.drawButton(s, "start", gmenu2x.tr["Exit"], x);
 	(void)x;
+}
 
-	bg.convertToDisplayFormat();
-
-	stringstream ss;
-	ss << pages.size();
-	string spagecount;
-	ss >> spagecount;
-	string pageStatus;
-
-	const int fontHeight = gmenu2x.font->getLineSpacing();
-	unsigned int contentY, contentHeight;
-	tie(contentY, contentHeight) = gmenu2x.getContentArea();
-	const unsigned rowsPerPage = max(contentHeight / fontHeight, 1u);
-	contentY += (contentHeight % fontHeight) / 2;
-
-	unsigned page = 0, firstRow = 0;
-	bool close = false;
-
-	while (!close) {
-		OutputSurface& s = *gmenu2x.s;
-
-		bg.blit(s,0,0);
-		writeSubTitle(s, pages[page].title);
-		drawText(pages[page].text, contentY, firstRow, rowsPerPage);
-
-		ss.clear();
-		ss << page+1;
-		ss >> pageStatus;
-		pageStatus = gmenu2x.tr["Page"]+": "+pageStatus+"/"+spagecount;
-		gmenu2x.font->write(s, pageStatus, 310, 230, Font::HAlignRight, Font::VAlignMiddle);
+compat::string_view TextManualDialog::shownText() {
+	return pages[page].text;
+}
 
-		s.flip();
+void TextManualDialog::paint(Surface& s) {
+	paintBackground(s);
+	writeSubTitle(s, pages[page].title);
+	drawText(s, text(), contentY, firstRow, rowsPerPage);
 
-		const unsigned maxFirstRow = pages[page].text.size() < rowsPerPage
-				? 0 : pages[page].text.size() - rowsPerPage;
+	stringstream ss;
+	ss << page+1 << "/";
+	if (allSplit)
+		ss << pages.size();
+	else
+		ss << "?";
+	string pageStatus = string(gmenu2x.tr["Page"])+": "+ss.str();
+	gmenu2x.font->write(s, pageStatus, 310, 230, Font::HAlignRight, Font::VAlignMiddle);
+}
 
-		switch(gmenu2x.input.waitForPressedButton()) {
-			case InputManager::UP:
-				if (firstRow > 0) firstRow--;
-				break;
-			case InputManager::DOWN:
-				if (firstRow < maxFirstRow) firstRow++;
-				break;
-			case InputManager::LEFT:
-				if (page > 0) {
-					page--;
-					firstRow = 0;
-				}
-				break;
-			case InputManager::RIGHT:
-				if (page < pages.size() -1) {
-					page++;
-					firstRow = 0;
-				}
-				break;
-			case InputManager::ALTLEFT:
-				if (firstRow >= rowsPerPage - 1) firstRow -= rowsPerPage - 1;
-				else firstRow = 0;
-				break;
-			case InputManager::ALTRIGHT:
-				firstRow = min(firstRow + rowsPerPage - 1, maxFirstRow);
-				break;
-			case InputManager::CANCEL:
-			case InputManager::SETTINGS:
-				close = true;
-				break;
-			default:
-				break;
-		}
+bool TextManualDialog::handleButtonPress(InputManager::Button button) {
+	if (scroll(text(), button, firstRow, rowsPerPage))
+		return true;
+	switch (button) {
+		case InputManager::LEFT:
+			if (page > 0) {
+				page--;
+				firstRow = 0;
+				resetText();
+			}
+			break;
+		case InputManager::RIGHT:
+			splitPages(page + 1);
+			if (page < pages.size() -1) {
+				page++;
+				firstRow = 0;
+				resetText();
+			}
+			break;
+		case InputManager::CANCEL:
+		case InputManager::SETTINGS:
+			close();
+			break;
+		default:
+			break;
 	}
+	return true;
 }
@@ -21,6 +21,7 @@
 #ifndef TEXTMANUALDIALOG_H
 #define TEXTMANUALDIALOG_H
 
+#include "compat-string_view.h"
 #include "textdialog.h"
 
 #include <string>
@@ -28,17 +29,37 @@
 
 struct ManualPage {
 	std::string title;
-	std::vector<std::string> text;
+	compat::string_view text;
 };
 
 class TextManualDialog : public TextDialog {
 private:
 	std::vector<ManualPage> pages;
+	unsigned int page;
+
+	// Pages are split off as they are paged to: the title and first line of
+	// the page being scanned, the next line to scan and whether the whole
+	// document has been split.
+	std::string nextTitle;
+	size_t nextStart, nextLine;
+	bool allSplit;
+
+	/** Splits off pages until there is a page n or the document ends. */
+	void splitPages(size_t n);
+	void addPage(std::string title, size_t first, size_t last);
+	bool isBlank(size_t line);
+
+protected:
+	virtual void drawBackground(Surface& s);
+	virtual compat::string_view shownText();
 
 public:
 	TextManualDialog(GMenu2X& gmenu2x, const std::string &title,
-			const std::string &icon, const std::string &text);
-	void exec();
+			const std::string &icon, std::shared_ptr<Document> document);
+
+	// Layer implementation:
+	virtual void paint(Surface& s);
+	virtual bool handleButtonPress(InputManager::Button button);
 };
 
 #endif // TEXTMANUALDIALOG_H
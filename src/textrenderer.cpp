@@ -0,0 +1,168 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#include "textrenderer.h"
+
+#include "font_stack.h"
+#include "surface.h"
+#include "utilities.h"
+
+#include <algorithm>
+#include <utility>
+
+#include <SDL2/SDL.h>
+
+using namespace std;
+
+/** Upper bound on the number of worker threads; the main thread must keep
+  * up with uploading, and most devices have one or two cores anyway. */
+static const unsigned int MAX_WORKERS = 2;
+
+RenderedText::RenderedText(TextRenderer &renderer, string text)
+	: renderer(renderer)
+	, text(std::move(text))
+	, state(QUEUED)
+	, urgent(false)
+	, rendered(nullptr)
+	, isReady(false)
+{
+}
+
+RenderedText::~RenderedText()
+{
+	// The last reference can be dropped by a worker thread, but only before
+	// the text is ready, so there is no texture to destroy here yet.
+	SDL_FreeSurface(rendered);
+}
+
+bool RenderedText::ready()
+{
+	if (isReady)
+		return true;
+
+	SDL_Surface *raw;
+	{
+		unique_lock<mutex> lock(renderer.queueMutex);
+		if (state != RENDERED && renderer.synchronous) {
+			// Not marked urgent: nothing has to be repainted afterwards.
+			if (state == QUEUED)
+				renderer.prioritize(this);
+			renderer.renderedCond.wait(lock,
+					[this] { return state == RENDERED; });
+		}
+		if (state != RENDERED) {
+			if (!urgent) {
+				urgent = true;
+				if (state == QUEUED)
+					renderer.prioritize(this);
+			}
+			return false;
+		}
+		raw = rendered;
+		rendered = nullptr;
+	}
+
+	isReady = true;
+
+	if (raw) {
+		uploaded = OffscreenSurface::fromSurface(raw);
+		SDL_FreeSurface(raw);
+	}
+	return true;
+}
+
+TextRenderer::TextRenderer(const FontStack &font, bool synchronous)
+	: font(font)
+	, synchronous(synchronous)
+	, busy(0)
+	, stopping(false)
+{
+	const unsigned int cores = thread::hardware_concurrency();
+	const unsigned int count = max(1u, min(MAX_WORKERS, cores ? cores - 1 : 1));
+	for (unsigned int i = 0; i < count; i++)
+		workerFonts.push_back(font.duplicate());
+	for (unsigned int i = 0; i < count; i++)
+		workers.emplace_back([this, i] { run(i); });
+}
+
+TextRenderer::~TextRenderer()
+{
+	{
+		lock_guard<mutex> lock(queueMutex);
+		stopping = true;
+	}
+	queueCond.notify_all();
+	for (auto &worker : workers)
+		worker.join();
+}
+
+shared_ptr<RenderedText> TextRenderer::render(string text)
+{
+	auto rendered = make_shared<RenderedText>(*this, std::move(text));
+	{
+		lock_guard<mutex> lock(queueMutex);
+		queue.push_back(rendered);
+	}
+	queueCond.notify_one();
+	return rendered;
+}
+
+void TextRenderer::prioritize(RenderedText *text)
+{
+	// Called with the queue mutex held. Each text is in one of the queues
+	// until a worker takes it, so workers never hold on to a text that is
+	// ready and owns a texture.
+	auto it = find_if(queue.begin(), queue.end(),
+			[text](const weak_ptr<RenderedText> &queued) {
+				return queued.lock().get() == text;
+			});
+	if (it != queue.end()) {
+		urgentQueue.push_back(std::move(*it));
+		queue.erase(it);
+		queueCond.notify_one();
+	}
+}
+
+void TextRenderer::fontChanged()
+{
+	unique_lock<mutex> lock(queueMutex);
+	idleCond.wait(lock, [this] { return busy == 0; });
+
+	// Font handles must be opened and closed on the main thread.
+	for (auto &workerFont : workerFonts)
+		workerFont = font.duplicate();
+}
+
+void TextRenderer::run(size_t index)
+{
+	unique_lock<mutex> lock(queueMutex);
+	while (true) {
+		queueCond.wait(lock, [this] {
+			return stopping || !queue.empty() || !urgentQueue.empty();
+		});
+		if (stopping)
+			return;
+
+		auto &source = urgentQueue.empty() ? queue : urgentQueue;
+		auto text = source.front().lock();
+		source.pop_front();
+		if (!text)
+			continue;
+
+		text->state = RenderedText::RENDERING;
+		busy++;
+		const FontStack &workerFont = *workerFonts[index];
+		lock.unlock();
+
+		SDL_Surface *raw = workerFont.rasterize(text->getText());
+
+		lock.lock();
+		text->rendered = raw;
+		text->state = RenderedText::RENDERED;
+		if (--busy == 0)
+			idleCond.notify_all();
+		if (synchronous)
+			renderedCond.notify_all();
+		if (text->urgent)
+			request_repaint();
+	}
+}
@@ -0,0 +1,113 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#ifndef TEXTRENDERER_H
+#define TEXTRENDERER_H
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct SDL_Surface;
+class FontStack;
+class OffscreenSurface;
+class TextRenderer;
+
+/**
+ * A text that is being rendered by a TextRenderer.
+ *
+ * All public methods must be called from the main thread.
+ */
+class RenderedText {
+public:
+	RenderedText(TextRenderer &renderer, std::string text);
+	~RenderedText();
+
+	RenderedText(const RenderedText&) = delete;
+	RenderedText& operator=(const RenderedText&) = delete;
+
+	const std::string &getText() const { return text; }
+
+	/**
+	 * Returns true once the text has been rendered and uploaded. Until then,
+	 * asking moves the text to the front of the queue, so texts that are
+	 * shown are rendered before the others. With a synchronous renderer,
+	 * this waits for the text instead and always returns true.
+	 */
+	bool ready();
+
+	/** The rendered text; nullptr until ready() or if rendering failed. */
+	std::shared_ptr<OffscreenSurface> surface() const { return uploaded; }
+
+private:
+	friend class TextRenderer;
+
+	enum State { QUEUED, RENDERING, RENDERED };
+
+	TextRenderer &renderer;
+	const std::string text;
+
+	/** Guarded by the queue mutex of the renderer. */
+	State state;
+	bool urgent;
+	SDL_Surface *rendered;
+
+	/** Only used by the main thread. */
+	bool isReady;
+	std::shared_ptr<OffscreenSurface> uploaded;
+};
+
+/**
+ * Renders texts on background threads.
+ *
+ * Rendering a text with the outline takes long enough that doing it for
+ * every link of the menu noticeably delays starting up and switching skins.
+ * The worker threads rasterize texts into software surfaces with their own
+ * font handles; the textures are created on the main thread, when a text is
+ * first shown.
+ */
+class TextRenderer {
+public:
+	/**
+	 * The font must outlive the renderer. If synchronous, texts are still
+	 * rendered by the workers, but asking whether one is ready waits for
+	 * it, so that what is painted does not depend on their timing.
+	 */
+	explicit TextRenderer(const FontStack &font, bool synchronous = false);
+	~TextRenderer();
+
+	TextRenderer(const TextRenderer&) = delete;
+	TextRenderer& operator=(const TextRenderer&) = delete;
+
+	/** Queues the given text for rendering. */
+	std::shared_ptr<RenderedText> render(std::string text);
+
+	/**
+	 * Must be called after the fonts have been reloaded; texts that are
+	 * still queued will be rendered with the new fonts.
+	 */
+	void fontChanged();
+
+private:
+	friend class RenderedText;
+
+	void prioritize(RenderedText *text);
+	void run(size_t index);
+
+	const FontStack &font;
+	const bool synchronous;
+	/** Font handles of each worker thread. */
+	std::vector<std::unique_ptr<FontStack>> workerFonts;
+	std::vector<std::thread> workers;
+
+	std::mutex queueMutex;
+	std::condition_variable queueCond, idleCond, renderedCond;
+	std::deque<std::weak_ptr<RenderedText>> queue, urgentQueue;
+	unsigned int busy;
+	bool stopping;
+};
+
+#endif
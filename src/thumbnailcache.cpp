@@ -0,0 +1,279 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#include "thumbnailcache.h"
+
+#include "compat-filesystem.h"
+#include "debug.h"
+#include "imageio.h"
+#include "surface.h"
+#include "utilities.h"
+
+#include <SDL2/SDL.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <system_error>
+
+#include <sys/stat.h>
+
+using namespace std;
+
+// Requests beyond this are dropped, oldest first: when scrolling fast, the
+// images that were scrolled past are no longer interesting.
+static constexpr size_t MAX_QUEUED = 32;
+
+/**
+ * Shrinks a 32bpp ARGB surface to fit in the given box, averaging all
+ * source pixels that cover each destination pixel. Colors are weighted by
+ * alpha, to avoid dark fringes around transparent areas.
+ * Returns nullptr if the surface already fits.
+ */
+static SDL_Surface *scaleDown(SDL_Surface *src,
+		unsigned int maxWidth, unsigned int maxHeight)
+{
+	const unsigned int sw = src->w, sh = src->h;
+	if (sw <= maxWidth && sh <= maxHeight)
+		return nullptr;
+
+	const double scale = min(double(maxWidth) / sw, double(maxHeight) / sh);
+	const unsigned int dw = max(1u, static_cast<unsigned int>(sw * scale));
+	const unsigned int dh = max(1u, static_cast<unsigned int>(sh * scale));
+
+	SDL_Surface *dst = SDL_CreateRGBSurface(0, dw, dh, 32,
+			0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+	if (!dst)
+		return nullptr;
+
+	for (unsigned int dy = 0; dy < dh; dy++) {
+		const unsigned int sy0 = dy * sh / dh;
+		const unsigned int sy1 = max(sy0 + 1, (dy + 1) * sh / dh);
+		auto out = reinterpret_cast<uint32_t *>(
+				static_cast<uint8_t *>(dst->pixels) + dy * dst->pitch);
+
+		for (unsigned int dx = 0; dx < dw; dx++) {
+			const unsigned int sx0 = dx * sw / dw;
+			const unsigned int sx1 = max(sx0 + 1, (dx + 1) * sw / dw);
+			uint64_t sa = 0, sr = 0, sg = 0, sb = 0;
+
+			for (unsigned int sy = sy0; sy < sy1; sy++) {
+				auto in = reinterpret_cast<const uint32_t *>(
+						static_cast<const uint8_t *>(src->pixels)
+						+ sy * src->pitch);
+				for (unsigned int sx = sx0; sx < sx1; sx++) {
+					const uint32_t px = in[sx];
+					const uint32_t a = src->format->Amask ? px >> 24 : 0xFF;
+					sa += a;
+					sr += a * ((px >> 16) & 0xFF);
+					sg += a * ((px >> 8) & 0xFF);
+					sb += a * (px & 0xFF);
+				}
+			}
+
+			const uint64_t n = uint64_t(sy1 - sy0) * (sx1 - sx0);
+			uint32_t px = 0;
+			if (sa) {
+				px = uint32_t(sa / n) << 24
+					| uint32_t(sr / sa) << 16
+					| uint32_t(sg / sa) << 8
+					| uint32_t(sb / sa);
+			}
+			out[dx] = px;
+		}
+	}
+
+	return dst;
+}
+
+ThumbnailCache::ThumbnailCache(const string &cacheDir,
+		unsigned int maxWidth, unsigned int maxHeight, size_t maxCount)
+	: cacheDir(cacheDir)
+	, maxWidth(maxWidth)
+	, maxHeight(maxHeight)
+	, maxCount(maxCount)
+	, useCounter(0)
+	, quit(false)
+{
+	error_code ec;
+	compat::filesystem::create_directories(cacheDir, ec);
+	if (ec) {
+		WARNING("Unable to create thumbnail cache directory %s: %s\n",
+				cacheDir.c_str(), ec.message().c_str());
+	}
+
+	worker = thread(&ThumbnailCache::run, this);
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+	{
+		lock_guard<std::mutex> lock(queueMutex);
+		quit = true;
+		queue.clear();
+	}
+	cond.notify_one();
+	worker.join();
+
+	for (auto &result : results)
+		SDL_FreeSurface(result.second);
+}
+
+shared_ptr<OffscreenSurface> ThumbnailCache::get(const string &path)
+{
+	collectResults();
+
+	auto it = thumbnails.find(path);
+	if (it != thumbnails.end()) {
+		it->second.lastUse = ++useCounter;
+		return it->second.surface;
+	}
+
+	prefetch(path);
+	return nullptr;
+}
+
+void ThumbnailCache::prefetch(const string &path)
+{
+	if (thumbnails.count(path) || failed.count(path)
+			|| !requested.insert(path).second)
+		return;
+
+	{
+		lock_guard<std::mutex> lock(queueMutex);
+		queue.push_back(path);
+		if (queue.size() > MAX_QUEUED) {
+			requested.erase(queue.front());
+			queue.pop_front();
+		}
+	}
+	cond.notify_one();
+}
+
+void ThumbnailCache::cancelPending()
+{
+	lock_guard<std::mutex> lock(queueMutex);
+	for (auto const& path : queue)
+		requested.erase(path);
+	queue.clear();
+}
+
+void ThumbnailCache::clear()
+{
+	cancelPending();
+	thumbnails.clear();
+	failed.clear();
+}
+
+void ThumbnailCache::collectResults()
+{
+	decltype(results) done;
+	{
+		lock_guard<std::mutex> lock(queueMutex);
+		done.swap(results);
+	}
+
+	for (auto &result : done) {
+		requested.erase(result.first);
+		shared_ptr<OffscreenSurface> surface;
+		if (result.second) {
+			surface = OffscreenSurface::fromSurface(result.second);
+			SDL_FreeSurface(result.second);
+		}
+		if (surface) {
+			thumbnails[result.first] = Entry { surface, ++useCounter };
+			evict();
+		} else {
+			// Otherwise every repaint would queue it again.
+			failed.insert(move(result.first));
+		}
+	}
+}
+
+void ThumbnailCache::evict()
+{
+	// The least recently used thumbnails are dropped first.
+	while (thumbnails.size() > maxCount) {
+		auto oldest = min_element(thumbnails.begin(), thumbnails.end(),
+				[](decltype(thumbnails)::value_type const& a,
+				   decltype(thumbnails)::value_type const& b) {
+					return a.second.lastUse < b.second.lastUse;
+				});
+		thumbnails.erase(oldest);
+	}
+}
+
+void ThumbnailCache::run()
+{
+	unique_lock<std::mutex> lock(queueMutex);
+	for (;;) {
+		cond.wait(lock, [this] { return quit || !queue.empty(); });
+		if (quit)
+			break;
+
+		// Newest request first: that is the one the user is looking at.
+		string path = move(queue.back());
+		queue.pop_back();
+
+		lock.unlock();
+		SDL_Surface *thumbnail = createThumbnail(path);
+		lock.lock();
+
+		results.emplace_back(move(path), thumbnail);
+		request_repaint();
+	}
+}
+
+string ThumbnailCache::cachePath(const string &path) const
+{
+	// 64-bit FNV-1a of the path and the thumbnail size.
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	auto mix = [&hash](const string &str) {
+		for (unsigned char c : str) {
+			hash ^= c;
+			hash *= 0x100000001B3ULL;
+		}
+	};
+	mix(path);
+	mix("@" + to_string(maxWidth) + "x" + to_string(maxHeight));
+
+	char name[32];
+	snprintf(name, sizeof(name), "%016" PRIx64 ".qoi", hash);
+	return cacheDir + "/" + name;
+}
+
+SDL_Surface *ThumbnailCache::createThumbnail(const string &path)
+{
+	// Images inside OPK packages change when the package does.
+	string sourceFile = path.substr(0, path.find('#'));
+	struct stat source;
+	if (stat(sourceFile.c_str(), &source) != 0) {
+		sourceFile = qoiSiblingPath(sourceFile);
+		if (sourceFile.empty() || stat(sourceFile.c_str(), &source) != 0)
+			return nullptr;
+	}
+
+	const string cached = cachePath(path);
+	struct stat thumb;
+	if (stat(cached.c_str(), &thumb) == 0 && thumb.st_mtime >= source.st_mtime) {
+		SDL_Surface *surface = loadQOI(cached);
+		if (surface)
+			return surface;
+	}
+
+	SDL_Surface *image = loadImageFile(path);
+	if (!image) {
+		DEBUG("Unable to create thumbnail of '%s'\n", path.c_str());
+		return nullptr;
+	}
+
+	SDL_Surface *scaled = scaleDown(image, maxWidth, maxHeight);
+	if (scaled) {
+		SDL_FreeSurface(image);
+		image = scaled;
+	}
+
+	if (!saveQOI(image, cached))
+		WARNING("Unable to store thumbnail of '%s'\n", path.c_str());
+
+	return image;
+}
@@ -0,0 +1,93 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#ifndef THUMBNAILCACHE_H
+#define THUMBNAILCACHE_H
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+class OffscreenSurface;
+struct SDL_Surface;
+
+/**
+ * Provides downscaled versions of image files.
+ *
+ * Thumbnails are decoded and scaled by a background thread, so browsing
+ * through a directory full of large images never blocks the UI. Scaled
+ * thumbnails are stored on disk as QOI files, which makes them cheap to
+ * load the next time the same image is browsed.
+ *
+ * All public methods must be called from the main thread.
+ */
+class ThumbnailCache {
+public:
+	/**
+	 * Creates a cache for thumbnails that fit in a box of the given size.
+	 * Images that are already smaller than that are not enlarged.
+	 * At most maxCount thumbnails are kept in memory.
+	 */
+	ThumbnailCache(const std::string &cacheDir,
+			unsigned int maxWidth, unsigned int maxHeight,
+			size_t maxCount = 128);
+	~ThumbnailCache();
+
+	/**
+	 * Returns the thumbnail of the given image file, or nullptr if it is
+	 * not available yet. In that case decoding is queued, and a repaint is
+	 * requested once the thumbnail is ready. Files that could not be
+	 * decoded are not tried again until clear() is called.
+	 */
+	std::shared_ptr<OffscreenSurface> get(const std::string &path);
+
+	/**
+	 * Queues decoding of the thumbnail of the given image file, without
+	 * waiting for the result.
+	 */
+	void prefetch(const std::string &path);
+
+	/** Forgets about all thumbnails that have not been decoded yet. */
+	void cancelPending();
+
+	/** Drops all thumbnails that are held in memory. */
+	void clear();
+
+private:
+	void collectResults();
+	void evict();
+	void run();
+	SDL_Surface *createThumbnail(const std::string &path);
+	std::string cachePath(const std::string &path) const;
+
+	const std::string cacheDir;
+	const unsigned int maxWidth, maxHeight;
+	const size_t maxCount;
+
+	struct Entry {
+		std::shared_ptr<OffscreenSurface> surface;
+		unsigned int lastUse;
+	};
+	// Main thread only.
+	std::unordered_map<std::string, Entry> thumbnails;
+	std::unordered_set<std::string> requested;
+	std::unordered_set<std::string> failed;
+	unsigned int useCounter;
+
+	// Shared with the worker; protected by the mutex.
+	std::mutex queueMutex;
+	std::condition_variable cond;
+	std::deque<std::string> queue;
+	std::vector<std::pair<std::string, SDL_Surface *>> results;
+	bool quit;
+
+	std::thread worker;
+};
+
+#endif /* THUMBNAILCACHE_H */
@@ -0,0 +1,161 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#include "tiledimage.h"
+
+#include "debug.h"
+#include "imageio.h"
+#include "surface.h"
+
+#include <SDL2/SDL.h>
+
+using namespace std;
+
+TiledImage::TiledImage(const string &path, unsigned int tileWidth)
+	: path(path)
+	, tileWidth(tileWidth)
+	, count(0)
+	, current(0)
+	, busy(-1)
+	, quit(false)
+{
+	unsigned int width, height;
+	if (!getImageSize(path, &width, &height)) {
+		WARNING("Unable to read size of image %s\n", path.c_str());
+		return;
+	}
+
+	count = (width + tileWidth - 1) / tileWidth;
+	worker = thread(&TiledImage::run, this);
+}
+
+TiledImage::~TiledImage()
+{
+	if (!worker.joinable())
+		return;
+
+	{
+		lock_guard<std::mutex> lock(queueMutex);
+		quit = true;
+		queue.clear();
+	}
+	cond.notify_all();
+	worker.join();
+
+	for (auto &result : results)
+		SDL_FreeSurface(result.second);
+}
+
+bool TiledImage::inWindow(unsigned int index) const
+{
+	return index + 1 >= current && index <= current + 1;
+}
+
+shared_ptr<OffscreenSurface> TiledImage::getTile(unsigned int index)
+{
+	if (index >= count)
+		return nullptr;
+
+	current = index;
+	collectResults();
+
+	auto it = tiles.find(index);
+	if (it == tiles.end()) {
+		SDL_Surface *raw = nullptr;
+		{
+			// If the worker is already busy with this tile, wait for it
+			// rather than decoding it twice.
+			unique_lock<std::mutex> lock(queueMutex);
+			for (auto q = queue.begin(); q != queue.end(); ++q) {
+				if (*q == index) {
+					queue.erase(q);
+					break;
+				}
+			}
+			cond.wait(lock, [this, index] { return busy != (int)index; });
+			auto result = results.find(index);
+			if (result != results.end()) {
+				raw = result->second;
+				results.erase(result);
+			}
+		}
+		if (!raw)
+			raw = decode(index);
+		if (!raw)
+			return nullptr;
+
+		auto tile = OffscreenSurface::fromSurface(raw);
+		SDL_FreeSurface(raw);
+		it = tiles.emplace(index, tile).first;
+	}
+	auto tile = it->second;
+
+	// Keep only the window around the current tile.
+	for (auto t = tiles.begin(); t != tiles.end(); ) {
+		if (inWindow(t->first))
+			++t;
+		else
+			t = tiles.erase(t);
+	}
+
+	{
+		lock_guard<std::mutex> lock(queueMutex);
+		queue.clear();
+		for (unsigned int n : { index + 1, index - 1 }) {
+			if (n < count && !tiles.count(n) && !results.count(n)
+					&& busy != (int)n)
+				queue.push_back(n);
+		}
+	}
+	cond.notify_all();
+
+	return tile;
+}
+
+void TiledImage::collectResults()
+{
+	map<unsigned int, SDL_Surface *> done;
+	{
+		lock_guard<std::mutex> lock(queueMutex);
+		done.swap(results);
+	}
+
+	for (auto &result : done) {
+		if (result.second && inWindow(result.first) && !tiles.count(result.first)) {
+			auto tile = OffscreenSurface::fromSurface(result.second);
+			if (tile)
+				tiles[result.first] = tile;
+		}
+		SDL_FreeSurface(result.second);
+	}
+}
+
+void TiledImage::run()
+{
+	unique_lock<std::mutex> lock(queueMutex);
+	for (;;) {
+		cond.wait(lock, [this] { return quit || !queue.empty(); });
+		if (quit)
+			break;
+
+		unsigned int index = queue.front();
+		queue.pop_front();
+		busy = index;
+
+		lock.unlock();
+		SDL_Surface *raw = decode(index);
+		lock.lock();
+
+		if (raw)
+			results[index] = raw;
+		busy = -1;
+		cond.notify_all();
+	}
+}
+
+SDL_Surface *TiledImage::decode(unsigned int index)
+{
+	SDL_Surface *raw = loadImageColumns(path, index * tileWidth, tileWidth);
+	if (!raw)
+		WARNING("Unable to decode tile %u of %s\n", index, path.c_str());
+	return raw;
+}
@@ -0,0 +1,66 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#ifndef TILEDIMAGE_H
+#define TILEDIMAGE_H
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class OffscreenSurface;
+struct SDL_Surface;
+
+/**
+ * An image that is too wide to be held as a whole, split into tiles of a
+ * fixed width that are decoded on demand.
+ *
+ * Only the tile that was requested last and its two neighbours are kept;
+ * the neighbours are decoded by a background thread, so paging through the
+ * image in either direction does not wait for the decoder.
+ *
+ * All public methods must be called from the main thread.
+ */
+class TiledImage {
+public:
+	TiledImage(const std::string &path, unsigned int tileWidth);
+	~TiledImage();
+
+	/** Returns the number of tiles, or 0 if the image cannot be read. */
+	unsigned int tileCount() const { return count; }
+
+	/**
+	 * Returns the tile with the given index, decoding it if it has not been
+	 * prefetched, and starts prefetching its neighbours.
+	 */
+	std::shared_ptr<OffscreenSurface> getTile(unsigned int index);
+
+private:
+	bool inWindow(unsigned int index) const;
+	void collectResults();
+	void run();
+	SDL_Surface *decode(unsigned int index);
+
+	const std::string path;
+	const unsigned int tileWidth;
+	unsigned int count;
+	unsigned int current;
+
+	// Main thread only.
+	std::map<unsigned int, std::shared_ptr<OffscreenSurface>> tiles;
+
+	// Shared with the worker; protected by the mutex.
+	std::mutex queueMutex;
+	std::condition_variable cond;
+	std::deque<unsigned int> queue;
+	std::map<unsigned int, SDL_Surface *> results;
+	int busy;
+	bool quit;
+
+	std::thread worker;
+};
+
+#endif /* TILEDIMAGE_H */
@@ -0,0 +1,135 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#include "timerscheduler.h"
+
+#include <algorithm>
+
+using namespace std;
+using namespace std::chrono;
+
+static bool before(bool armed1, steady_clock::time_point deadline1,
+		bool armed2, steady_clock::time_point deadline2)
+{
+	return armed1 && (!armed2 || deadline1 < deadline2);
+}
+
+TimerScheduler::TimerScheduler()
+	: nextId(1)
+	, generation(0)
+{
+}
+
+TimerScheduler::TimerId TimerScheduler::add(Callback callback)
+{
+	const TimerId id = nextId++;
+	timers.push_back({ id, false, TimePoint(), 0, std::move(callback) });
+	return id;
+}
+
+void TimerScheduler::remove(TimerId id)
+{
+	auto it = find(id);
+	if (it != timers.end())
+		timers.erase(it);
+}
+
+void TimerScheduler::start(TimerId id, unsigned int delay)
+{
+	auto it = find(id);
+	if (it == timers.end())
+		return;
+	it->armed = true;
+	it->deadline = steady_clock::now() + milliseconds(delay);
+	reorder(it);
+}
+
+void TimerScheduler::stop(TimerId id)
+{
+	auto it = find(id);
+	if (it != timers.end() && it->armed) {
+		it->armed = false;
+		reorder(it);
+	}
+}
+
+bool TimerScheduler::isArmed(TimerId id) const
+{
+	auto it = find(id);
+	return it != timers.end() && it->armed;
+}
+
+int TimerScheduler::run()
+{
+	const auto now = steady_clock::now();
+	// Each timer runs at most once per call, even if its callback asks for
+	// a delay shorter than the time the callbacks take.
+	generation++;
+	while (true) {
+		auto it = find_if(timers.begin(), timers.end(),
+				[now, this](const Timer &timer) {
+					return timer.armed && timer.deadline <= now
+							&& timer.generation != generation;
+				});
+		if (it == timers.end())
+			break;
+		it->generation = generation;
+
+		// The callback may add, remove or rearm timers, so call a copy and
+		// look the timer up again afterwards.
+		const TimerId id = it->id;
+		const Callback callback = it->callback;
+		const unsigned int delay = callback();
+
+		it = find(id);
+		if (it == timers.end() || !it->armed || it->deadline > now)
+			continue;
+		it->armed = delay != 0;
+		// Schedule from the deadline rather than from now, so repeating
+		// timers do not drift.
+		it->deadline += milliseconds(delay);
+		if (it->deadline < now)
+			it->deadline = now + milliseconds(delay);
+		reorder(it);
+	}
+
+	return timeout();
+}
+
+int TimerScheduler::timeout() const
+{
+	if (timers.empty() || !timers.front().armed)
+		return -1;
+	const auto left = duration_cast<milliseconds>(
+			timers.front().deadline - steady_clock::now()).count();
+	// Round up, so that the timer is due once the wait is over.
+	return max<long long>(0, left + 1);
+}
+
+vector<TimerScheduler::Timer>::iterator TimerScheduler::find(TimerId id)
+{
+	return find_if(timers.begin(), timers.end(),
+			[id](const Timer &timer) { return timer.id == id; });
+}
+
+vector<TimerScheduler::Timer>::const_iterator TimerScheduler::find(
+		TimerId id) const
+{
+	return find_if(timers.begin(), timers.end(),
+			[id](const Timer &timer) { return timer.id == id; });
+}
+
+void TimerScheduler::reorder(vector<Timer>::iterator it)
+{
+	// Only this timer can be out of place; move it until it is not.
+	auto first = timers.begin();
+	while (it != first && before(it->armed, it->deadline,
+			(it - 1)->armed, (it - 1)->deadline)) {
+		iter_swap(it, it - 1);
+		--it;
+	}
+	while (it + 1 != timers.end() && before((it + 1)->armed,
+			(it + 1)->deadline, it->armed, it->deadline)) {
+		iter_swap(it, it + 1);
+		++it;
+	}
+}
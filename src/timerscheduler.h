@@ -0,0 +1,73 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#ifndef TIMERSCHEDULER_H
+#define TIMERSCHEDULER_H
+
+#include <chrono>
+#include <functional>
+#include <vector>
+
+/**
+ * Timers of the main thread, serviced by the input loop.
+ *
+ * Instead of running callbacks on SDL timer threads that then push events
+ * to the main thread, the input loop waits for events only until the
+ * earliest deadline and runs the callbacks of the timers that are due
+ * itself. An idle menu therefore only wakes up when a timer is due.
+ *
+ * Timers are registered once and then armed and disarmed as needed, which
+ * costs no allocations. All methods must be called from the main thread.
+ */
+class TimerScheduler {
+public:
+	typedef unsigned int TimerId;
+	/**
+	 * Called when the timer is due. Returns the delay in milliseconds until
+	 * it is due again, or 0 to disarm it.
+	 */
+	typedef std::function<unsigned int(void)> Callback;
+
+	TimerScheduler();
+
+	/** Registers a timer, which is disarmed until start() is called. */
+	TimerId add(Callback callback);
+	void remove(TimerId id);
+
+	/** (Re)arms the timer to be due after the given number of ms. */
+	void start(TimerId id, unsigned int delay);
+	void stop(TimerId id);
+	bool isArmed(TimerId id) const;
+
+	/**
+	 * Runs the callbacks of the timers that are due. Returns the number of
+	 * milliseconds until the next deadline, or -1 if no timer is armed.
+	 */
+	int run();
+
+	/** Returns the number of milliseconds until the next deadline, or -1. */
+	int timeout() const;
+
+private:
+	typedef std::chrono::steady_clock::time_point TimePoint;
+
+	struct Timer {
+		TimerId id;
+		bool armed;
+		TimePoint deadline;
+		/** Value of `generation` during the last run() that called this. */
+		unsigned long generation;
+		Callback callback;
+	};
+
+	std::vector<Timer>::iterator find(TimerId id);
+	std::vector<Timer>::const_iterator find(TimerId id) const;
+	/** Moves a timer to its place in deadline order. */
+	void reorder(std::vector<Timer>::iterator it);
+
+	/** Armed timers by deadline, followed by the disarmed ones. */
+	std::vector<Timer> timers;
+	TimerId nextId;
+	unsigned long generation;
+};
+
+#endif
@@ -0,0 +1,318 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#include "translationcatalog.h"
+
+#include "debug.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+/*
+ * Layout, in native-endian 32-bit words:
+ *   [0] magic, [1] version, [2] number of terms, [3] number of buckets,
+ *   [4..5] size and [6..7] FNV-1a hash of the contents of the translation
+ *   file, low word first,
+ *   one displacement per bucket,
+ *   one entry per term: term offset, term length, translation offset,
+ *   translation length, with offsets from the start of the catalog,
+ * followed by the strings.
+ */
+static const uint32_t CATALOG_MAGIC = 0x43543247; // "G2TC"
+static const uint32_t CATALOG_VERSION = 3;
+static const size_t HEADER_WORDS = 8;
+static const size_t ENTRY_WORDS = 4;
+
+/** Terms per bucket; more makes the catalog smaller and slower to build. */
+static const uint32_t TERMS_PER_BUCKET = 2;
+
+static uint32_t hashTerm(compat::string_view term, uint32_t seed)
+{
+	// FNV-1a, seeded, with a final mix so that the low bits are usable.
+	uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u);
+	for (unsigned char c : term) {
+		h ^= c;
+		h *= 16777619u;
+	}
+	h ^= h >> 15;
+	h *= 0x2c1b3c6du;
+	h ^= h >> 12;
+	return h;
+}
+
+static compat::string_view trimmed(compat::string_view s)
+{
+	auto b = s.find_first_not_of(" \t\r");
+	if (b == compat::string_view::npos)
+		return {};
+	auto e = s.find_last_not_of(" \t\r");
+	return s.substr(b, e - b + 1);
+}
+
+TranslationCatalog::Source TranslationCatalog::sourceOf(compat::string_view text)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (unsigned char c : text) {
+		hash ^= c;
+		hash *= 0x100000001b3ull;
+	}
+	return { text.size(), hash };
+}
+
+static bool readFile(const string &path, string &text)
+{
+	ifstream in(path, ios::in | ios::binary);
+	if (!in)
+		return false;
+	text.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+	return true;
+}
+
+string TranslationCatalog::compile(compat::string_view text, Source source)
+{
+	vector<pair<compat::string_view, compat::string_view>> terms;
+	unordered_map<compat::string_view, size_t> indices;
+	while (!text.empty()) {
+		auto end = min(text.find('\n'), text.size());
+		auto line = trimmed(text.substr(0, end));
+		text.remove_prefix(min(end + 1, text.size()));
+
+		if (line.empty() || line[0] == '#')
+			continue;
+		auto position = line.find('=');
+		if (position == compat::string_view::npos)
+			continue;
+
+		auto term = trimmed(line.substr(0, position));
+		auto translation = trimmed(line.substr(position + 1));
+		auto it = indices.emplace(term, terms.size());
+		if (it.second)
+			terms.emplace_back(term, translation);
+		else // later lines override earlier ones
+			terms[it.first->second].second = translation;
+	}
+
+	const uint32_t count = terms.size();
+	const uint32_t bucketCount = count ? count / TERMS_PER_BUCKET + 1 : 0;
+
+	vector<vector<uint32_t>> buckets(bucketCount);
+	for (uint32_t i = 0; i < count; i++)
+		buckets[hashTerm(terms[i].first, 0) % bucketCount].push_back(i);
+
+	// Place the largest buckets first, while most slots are still free.
+	vector<uint32_t> order(bucketCount);
+	for (uint32_t i = 0; i < bucketCount; i++)
+		order[i] = i;
+	stable_sort(order.begin(), order.end(), [&buckets](uint32_t a, uint32_t b) {
+		return buckets[a].size() > buckets[b].size();
+	});
+
+	vector<uint32_t> displacements(bucketCount, 0), slotTerms(count);
+	vector<bool> taken(count, false);
+	vector<uint32_t> slots;
+	for (uint32_t b : order) {
+		const auto &bucket = buckets[b];
+		if (bucket.empty())
+			break;
+		for (uint32_t d = 1; ; d++) {
+			if (d == 0x1000000) {
+				ERROR("Unable to build perfect hash for translations\n");
+				return compile("", source);
+			}
+			slots.clear();
+			for (uint32_t i : bucket) {
+				uint32_t slot = hashTerm(terms[i].first, d) % count;
+				if (taken[slot]
+						|| std::find(slots.begin(), slots.end(), slot) != slots.end())
+					break;
+				slots.push_back(slot);
+			}
+			if (slots.size() == bucket.size()) {
+				displacements[b] = d;
+				for (size_t k = 0; k < slots.size(); k++) {
+					taken[slots[k]] = true;
+					slotTerms[slots[k]] = bucket[k];
+				}
+				break;
+			}
+		}
+	}
+
+	vector<uint32_t> words;
+	words.reserve(HEADER_WORDS + bucketCount + count * ENTRY_WORDS);
+	words.insert(words.end(), {
+		CATALOG_MAGIC, CATALOG_VERSION, count, bucketCount,
+		uint32_t(source.size), uint32_t(source.size >> 32),
+		uint32_t(source.hash), uint32_t(source.hash >> 32),
+	});
+	words.insert(words.end(), displacements.begin(), displacements.end());
+
+	string strings;
+	uint32_t offset = (HEADER_WORDS + bucketCount + count * ENTRY_WORDS) * 4;
+	for (uint32_t slot = 0; slot < count; slot++) {
+		const auto &term = terms[slotTerms[slot]];
+		words.insert(words.end(), {
+			uint32_t(offset + strings.size()), uint32_t(term.first.size()),
+			uint32_t(offset + strings.size() + term.first.size()),
+			uint32_t(term.second.size()),
+		});
+		strings.append(term.first.data(), term.first.size());
+		strings.append(term.second.data(), term.second.size());
+	}
+
+	string catalog(reinterpret_cast<const char *>(words.data()),
+			words.size() * 4);
+	catalog += strings;
+	return catalog;
+}
+
+TranslationCatalog::TranslationCatalog()
+	: mapping(MAP_FAILED)
+	, mappingSize(0)
+	, data(nullptr)
+	, size(0)
+	, count(0)
+	, bucketCount(0)
+{
+}
+
+TranslationCatalog::~TranslationCatalog()
+{
+	clear();
+}
+
+void TranslationCatalog::clear()
+{
+	if (mapping != MAP_FAILED) {
+		munmap(mapping, mappingSize);
+		mapping = MAP_FAILED;
+	}
+	storage.clear();
+	data = nullptr;
+	size = 0;
+	count = bucketCount = 0;
+}
+
+bool TranslationCatalog::open(const std::string &path,
+		const std::string &sourcePath)
+{
+	clear();
+
+	int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) == 0 && st.st_size > 0) {
+		mapping = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapping != MAP_FAILED)
+			mappingSize = st.st_size;
+	}
+	close(fd);
+
+	if (mapping == MAP_FAILED
+			|| !use(static_cast<const char *>(mapping), mappingSize)) {
+		WARNING("Invalid translation catalog '%s'\n", path.c_str());
+		clear();
+		return false;
+	}
+
+	// The size is checked first, so that most edits are found without
+	// reading the file.
+	const uint64_t size = uint64_t(word(5)) << 32 | word(4);
+	struct stat source;
+	if (stat(sourcePath.c_str(), &source) < 0)
+		return true;
+	string text;
+	if (uint64_t(source.st_size) == size && readFile(sourcePath, text)
+			&& sourceOf(text).hash == (uint64_t(word(7)) << 32 | word(6)))
+		return true;
+
+	WARNING("Translation catalog '%s' does not match '%s', ignoring it\n",
+			path.c_str(), sourcePath.c_str());
+	clear();
+	return false;
+}
+
+bool TranslationCatalog::load(const std::string &path)
+{
+	clear();
+
+	string text;
+	if (!readFile(path, text))
+		return false;
+
+	storage = compile(text);
+	if (!use(storage.data(), storage.size())) {
+		clear();
+		return false;
+	}
+	return true;
+}
+
+bool TranslationCatalog::use(const char *data, size_t size)
+{
+	this->data = data;
+	this->size = size;
+	count = bucketCount = 0;
+
+	if (size < HEADER_WORDS * 4 || word(0) != CATALOG_MAGIC
+			|| word(1) != CATALOG_VERSION)
+		return false;
+
+	const size_t words = HEADER_WORDS + size_t(word(3)) + size_t(word(2)) * ENTRY_WORDS;
+	if ((word(2) && !word(3)) || words * 4 > size)
+		return false;
+
+	count = word(2);
+	bucketCount = word(3);
+	for (uint32_t slot = 0; slot < count; slot++) {
+		const size_t entry = HEADER_WORDS + bucketCount + slot * ENTRY_WORDS;
+		for (size_t k = 0; k < ENTRY_WORDS; k += 2) {
+			if (word(entry + k) > size || word(entry + k + 1) > size - word(entry + k)) {
+				count = bucketCount = 0;
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+uint32_t TranslationCatalog::word(size_t index) const
+{
+	uint32_t value;
+	memcpy(&value, data + index * 4, sizeof(value));
+	return value;
+}
+
+compat::string_view TranslationCatalog::stringAt(size_t index) const
+{
+	return { data + word(index), word(index + 1) };
+}
+
+int TranslationCatalog::find(compat::string_view term) const
+{
+	if (!count)
+		return -1;
+	const uint32_t displacement = word(HEADER_WORDS + hashTerm(term, 0) % bucketCount);
+	const uint32_t slot = hashTerm(term, displacement) % count;
+	if (stringAt(HEADER_WORDS + bucketCount + slot * ENTRY_WORDS) != term)
+		return -1;
+	return slot;
+}
+
+compat::string_view TranslationCatalog::translation(int id) const
+{
+	return stringAt(HEADER_WORDS + bucketCount + id * ENTRY_WORDS + 2);
+}
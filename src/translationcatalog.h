@@ -0,0 +1,82 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#ifndef TRANSLATIONCATALOG_H
+#define TRANSLATIONCATALOG_H
+
+#include "compat-string_view.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Compiled translation catalog.
+ *
+ * A catalog is a single binary blob that is looked up in place: a header, a
+ * minimal perfect hash over the terms ("hash and displace": a displacement
+ * per bucket of terms, chosen so that every term gets its own slot), one
+ * entry per slot and the strings of all terms and translations. The slot of
+ * a term is its ID.
+ *
+ * Catalogs of the system translations are compiled at build time and
+ * memory mapped; other translation files are compiled when they are loaded.
+ * Either way, lookups neither parse nor allocate.
+ *
+ * The header records the size and a hash of the contents of the translation
+ * file a catalog was compiled from, so that a catalog is not used once its
+ * file was edited, whatever happened to its modification time.
+ */
+class TranslationCatalog {
+public:
+	TranslationCatalog();
+	~TranslationCatalog();
+
+	TranslationCatalog(const TranslationCatalog&) = delete;
+	TranslationCatalog& operator=(const TranslationCatalog&) = delete;
+
+	/** Identifies the version of a translation file. */
+	struct Source {
+		uint64_t size;
+		uint64_t hash;
+	};
+
+	/** Identifies the given contents of a translation file. */
+	static Source sourceOf(compat::string_view text);
+
+	/**
+	 * Compiles a translation file ("term=translation" lines, '#' comments)
+	 * into catalog form.
+	 */
+	static std::string compile(compat::string_view text, Source source = Source());
+
+	/**
+	 * Maps a compiled catalog; returns false if it is missing or invalid, or
+	 * if it was compiled from another version of the given translation file.
+	 * A missing translation file does not make the catalog stale.
+	 */
+	bool open(const std::string &path, const std::string &sourcePath);
+	/** Compiles and loads the given translation file. */
+	bool load(const std::string &path);
+	void clear();
+
+	bool empty() const { return count == 0; }
+
+	/** Returns the ID of the given term, or -1 if it is not translated. */
+	int find(compat::string_view term) const;
+	compat::string_view translation(int id) const;
+
+private:
+	bool use(const char *data, size_t size);
+	uint32_t word(size_t index) const;
+	compat::string_view stringAt(size_t index) const;
+
+	std::string storage;
+	void *mapping;
+	size_t mappingSize;
+
+	const char *data;
+	size_t size;
+	uint32_t count, bucketCount;
+};
+
+#endif // TRANSLATIONCATALOG_H
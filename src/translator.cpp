@@ -24,8 +24,7 @@
 #include "gmenu2x.h"
 #include "utilities.h"
 
-#include <fstream>
-#include <iostream>
+#include <functional>
 #include <sstream>
 #include <stdarg.h>
 
@@ -39,43 +38,39 @@ Translator::Translator(const string &lang) {
 
 Translator::~Translator() {}
 
-bool Translator::exists(const string &term) {
-	return translations.find(term) != translations.end();
+bool Translator::exists(compat::string_view term) {
+	return catalog.find(term) >= 0;
 }
 
 void Translator::setLang(const string &lang) {
-	translations.clear();
-
-	string line;
-	ifstream infile ((GMenu2X::getHome() + "/translations/" + lang).c_str(), ios_base::in);
-	if (!infile.is_open())
-	  infile.open((string(GMENU2X_SYSTEM_DIR "/translations/") + lang).c_str(), ios_base::in);
-
-	if (infile.is_open()) {
-		while (getline(infile, line, '\n')) {
-			line = trim(line);
-			if (line.empty()) continue;
-			if (line[0]=='#') continue;
-
-			string::size_type position = line.find("=");
-			translations[ trim(line.substr(0,position)) ] = trim(line.substr(position+1));
-		}
-		infile.close();
+	untranslated.clear();
+
+	// Translations in the home directory are plain text, while the system
+	// ones are compiled at build time; the plain text of those is used if
+	// gmenu2x was cross-compiled.
+	if (catalog.load(GMenu2X::getHome() + "/translations/" + lang)
+			|| catalog.open(GMENU2X_SYSTEM_DIR "/translations/compiled/" + lang,
+					GMENU2X_SYSTEM_DIR "/translations/" + lang)) {
+		_lang = lang;
+	} else if (catalog.load(GMENU2X_SYSTEM_DIR "/translations/" + lang)) {
+		INFO("No usable compiled catalog for '%s', compiled it at startup\n",
+				lang.c_str());
 		_lang = lang;
 	}
 }
 
-string Translator::translate(const string &term,const char *replacestr,...) {
-	string result = term;
+compat::string_view Translator::get(compat::string_view term) {
+	int id = catalog.find(term);
+	if (id >= 0)
+		return catalog.translation(id);
 
-	if (!_lang.empty()) {
-		unordered_map<string, string>::iterator i = translations.find(term);
-		if (i != translations.end()) {
-			result = i->second;
-		}
+	if (!_lang.empty() && untranslated.insert(hash<compat::string_view>()(term)).second)
+		WARNING("Untranslated string: '%.*s'\n", int(term.size()), term.data());
+	return term;
+}
 
-		else WARNING("Untranslated string: '%s'\n", term.c_str());
-	}
+string Translator::translate(const string &term,const char *replacestr,...) {
+	string result(get(term));
 
 	va_list arglist;
 	va_start(arglist, replacestr);
@@ -94,8 +89,8 @@ string Translator::translate(const string &term,const char *replacestr,...) {
 	return result;
 }
 
-string Translator::operator[](const string &term) {
-	return translate(term);
+compat::string_view Translator::operator[](compat::string_view term) {
+	return get(term);
 }
 
 string Translator::lang() {
@@ -21,18 +21,24 @@
 #ifndef TRANSLATOR_H
 #define TRANSLATOR_H
 
+#include "compat-string_view.h"
+#include "translationcatalog.h"
+
+#include <cstddef>
 #include <string>
-#include <unordered_map>
+#include <unordered_set>
 
 /**
-Hash Map of translation strings.
+Compiled catalog of translation strings.
 
 	@author Massimiliano Torromeo <massimiliano.torromeo@gmail.com>
 */
 class Translator {
 private:
 	std::string _lang;
-	std::unordered_map<std::string, std::string> translations;
+	TranslationCatalog catalog;
+	/** Hashes of the untranslated terms that were reported already. */
+	std::unordered_set<size_t> untranslated;
 
 public:
 	Translator(const std::string &lang="");
@@ -40,10 +46,16 @@ public:
 
 	std::string lang();
 	void setLang(const std::string &lang);
-	bool exists(const std::string &term);
+	bool exists(compat::string_view term);
+	/**
+	 * Returns the translation of the given term, or the term itself if it
+	 * has none. Does not allocate, so it can be used while painting.
+	 */
+	compat::string_view get(compat::string_view term);
 	std::string translate(const std::string &term,
 			const char *replacestr = NULL, ...);
-	std::string operator[](const std::string &term);
+	/** Same as get(); the view is valid until the language changes. */
+	compat::string_view operator[](compat::string_view term);
 };
 
 #endif // TRANSLATOR_H
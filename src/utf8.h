@@ -0,0 +1,76 @@
+#ifndef _UTF8_H_
+#define _UTF8_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "compat-string_view.h"
+
+// Code point that malformed UTF-8 decodes to.
+constexpr char32_t kReplacementCharacter = 0xFFFD;
+
+// Decodes the UTF-8 sequence at `text[*pos]` and advances `*pos` past it.
+// Truncated, overlong and otherwise malformed sequences decode to
+// `kReplacementCharacter` and consume a single byte.
+inline char32_t DecodeUtf8(compat::string_view text, std::size_t *pos) {
+	const auto byte = [&text](std::size_t i) {
+		return static_cast<unsigned char>(text[i]);
+	};
+	const std::size_t i = *pos;
+	const unsigned char lead = byte(i);
+	if (lead < 0x80) {
+		*pos = i + 1;
+		return lead;
+	}
+
+	std::size_t len;
+	char32_t cp, min;
+	if (lead >= 0xC2 && lead <= 0xDF) {
+		len = 2, cp = lead & 0x1F, min = 0x80;
+	} else if (lead >= 0xE0 && lead <= 0xEF) {
+		len = 3, cp = lead & 0x0F, min = 0x800;
+	} else if (lead >= 0xF0 && lead <= 0xF4) {
+		len = 4, cp = lead & 0x07, min = 0x10000;
+	} else {
+		*pos = i + 1;
+		return kReplacementCharacter;
+	}
+	if (text.size() - i < len) {
+		*pos = i + 1;
+		return kReplacementCharacter;
+	}
+	for (std::size_t k = 1; k < len; ++k) {
+		const unsigned char cont = byte(i + k);
+		if ((cont & 0xC0) != 0x80) {
+			*pos = i + 1;
+			return kReplacementCharacter;
+		}
+		cp = (cp << 6) | (cont & 0x3F);
+	}
+	if (cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+		*pos = i + 1;
+		return kReplacementCharacter;
+	}
+	*pos = i + len;
+	return cp;
+}
+
+// Returns the number of ASCII bytes at the start of `text`.
+// Checks a machine word at a time: one AND tells whether any byte of the
+// word has its high bit set.
+inline std::size_t AsciiPrefixLength(compat::string_view text) {
+	constexpr std::uintptr_t kHighBits = ~std::uintptr_t{0} / 0xFF * 0x80;
+	const char *data = text.data();
+	const std::size_t size = text.size();
+	std::size_t i = 0;
+	for (; i + sizeof(std::uintptr_t) <= size; i += sizeof(std::uintptr_t)) {
+		std::uintptr_t word;
+		std::memcpy(&word, data + i, sizeof(word));
+		if (word & kHighBits) break;
+	}
+	while (i < size && static_cast<unsigned char>(data[i]) < 0x80) ++i;
+	return i;
+}
+
+#endif  // _UTF8_H_
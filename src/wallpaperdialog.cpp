@@ -26,24 +26,38 @@
 #include "gmenu2x.h"
 #include "iconbutton.h"
 #include "surface.h"
+#include "thumbnailcache.h"
 #include "utilities.h"
 
+#include <algorithm>
 #include <iostream>
 
 using namespace std;
 
+/**
+ * Time in milliseconds that the selection must stay on a wallpaper before
+ * the full resolution image is decoded; until then, the thumbnail is shown.
+ */
+static constexpr Uint32 DWELL_DELAY = 400;
+
+/** Spacing between the thumbnails in the strip, in pixels. */
+static constexpr unsigned int THUMB_SPACING = 4;
+
 WallpaperDialog::WallpaperDialog(GMenu2X& gmenu2x)
 	: Dialog(gmenu2x)
+	, selected(0)
+	, firstElement(0)
+	// Thumbnail strip along the bottom of the content area.
+	, thumbWidth(gmenu2x.width() / 6)
+	, thumbHeight(gmenu2x.height() / 6)
+	, thumbnails(GMenu2X::getHome() + "/thumbnails", thumbWidth, thumbHeight)
+	// The selected wallpaper and the one before, for going back and forth.
+	, previews(GMenu2X::getHome() + "/thumbnails",
+			gmenu2x.width(), gmenu2x.height(), 2)
 {
-}
-
-bool WallpaperDialog::exec()
-{
-	bool close = false, result = true;
-
 	FileLister fl;
 	fl.setShowDirectories(false);
-	fl.setFilter("png");
+	fl.setFilter("png,qoi");
 
 	fl.browse(gmenu2x.getLocalSkinPath(gmenu2x.confStr["skin"])
 		  + "/wallpapers", true);
@@ -57,108 +71,174 @@ bool WallpaperDialog::exec()
 			  + "/wallpapers", false);
 	}
 
-	vector<string> wallpapers = fl.getFiles();
+	for (auto const& file : fl.getFiles()) {
+		// A converted wallpaper is loaded in place of its PNG original,
+		// so only list it when there is no such original.
+		auto pos = file.rfind('.');
+		if (pos != string::npos
+				&& case_less::to_lower(file.substr(pos)) == ".qoi"
+				&& binary_search(fl.getFiles().begin(), fl.getFiles().end(),
+					file.substr(0, pos) + ".png", case_less()))
+			continue;
+		wallpapers.push_back(file);
+		paths.push_back(gmenu2x.sc.getSkinFilePath("wallpapers/" + file));
+	}
 
 	DEBUG("Wallpapers: %zd\n", wallpapers.size());
 
-	uint32_t i, selected = 0, firstElement = 0, iY;
-
-	ButtonBox buttonbox;
 	buttonbox.add(unique_ptr<IconButton>(new IconButton(gmenu2x, "skin:imgs/buttons/accept.png", gmenu2x.tr["Select"])));
 	buttonbox.add(unique_ptr<IconButton>(new IconButton(gmenu2x, "skin:imgs/buttons/cancel.png", gmenu2x.tr["Exit"])));
 
-	unsigned int top, height;
 	tie(top, height) = gmenu2x.getContentArea();
 
-	int fontheight = gmenu2x.font->getLineSpacing();
-	unsigned int nb_elements = height / fontheight;
-
-	while (!close) {
-		OutputSurface& s = *gmenu2x.s;
-
-		if (selected > firstElement + nb_elements - 1)
-			firstElement = selected - nb_elements + 1;
-		if (selected < firstElement)
-			firstElement = selected;
-
-		//Wallpaper
-		auto imgpath = gmenu2x.sc.getSkinFilePath((string)"wallpapers/" + wallpapers[selected]);
-		std::shared_ptr<OffscreenSurface> img;
+	stripHeight = thumbHeight + 2 * THUMB_SPACING;
+	stripTop = top + height - stripHeight;
+	// Leave room for the scroll bar.
+	stripWidth = gmenu2x.width() - 9;
+	numThumbs = max(1u,
+			(stripWidth - THUMB_SPACING) / (thumbWidth + THUMB_SPACING));
+
+	fontheight = gmenu2x.font->getLineSpacing();
+	nb_elements = max(1u, (height - stripHeight) / fontheight);
+
+	selectTime = SDL_GetTicks();
+	dwellTimer = gmenu2x.timers.add([] {
+		request_repaint();
+		return 0u;
+	});
+	gmenu2x.timers.start(dwellTimer, DWELL_DELAY);
+}
 
-		if (gmenu2x.sc.exists(imgpath))
-			img = gmenu2x.sc[imgpath];
-		else
-			img = gmenu2x.sc.add(imgpath, gmenu2x.width(), gmenu2x.height());
+WallpaperDialog::~WallpaperDialog()
+{
+	gmenu2x.timers.remove(dwellTimer);
+}
 
-		if (img)
-			img->blit(s, 0, 0);
+void WallpaperDialog::paint(Surface& s)
+{
+	uint32_t i, iY;
+
+	if (selected > firstElement + nb_elements - 1)
+		firstElement = selected - nb_elements + 1;
+	if (selected < firstElement)
+		firstElement = selected;
+
+	//Wallpaper
+	if (!wallpapers.empty()) {
+		// The full image is decoded in the background; the thumbnail is
+		// shown until it is ready.
+		shared_ptr<OffscreenSurface> image;
+		if (SDL_GetTicks() - selectTime >= DWELL_DELAY)
+			image = previews.get(paths[selected]);
+		if (!image)
+			image = thumbnails.get(paths[selected]);
+
+		if (image) {
+			image->blitScaled(s, SDL_Rect { 0, 0,
+					static_cast<int>(gmenu2x.width()),
+					static_cast<int>(gmenu2x.height()) });
+		} else {
+			s.box(0, 0, gmenu2x.width(), gmenu2x.height(), 0, 0, 0, 255);
+		}
+	}
 
-		gmenu2x.drawTopBar(s);
-		gmenu2x.drawBottomBar(s);
+	gmenu2x.drawTopBar(s);
+	gmenu2x.drawBottomBar(s);
 
-		drawTitleIcon(s, "icons/wallpaper.png", true);
-		writeTitle(s, gmenu2x.tr["Wallpaper selection"]);
-		writeSubTitle(s, gmenu2x.tr["Select a wallpaper from the list"]);
+	drawTitleIcon(s, "icons/wallpaper.png", true);
+	writeTitle(s, gmenu2x.tr["Wallpaper selection"]);
+	writeSubTitle(s, gmenu2x.tr["Select a wallpaper from the list"]);
 
-		buttonbox.paint(s, 5, gmenu2x.height() - 1);
+	buttonbox.paint(s, 5, gmenu2x.height() - 1);
 
-		//Selection
-		iY = selected - firstElement;
-		iY = top + (iY * fontheight);
-		s.box(2, iY, 308, fontheight, gmenu2x.skinConfColors[COLOR_SELECTION_BG]);
+	//Selection
+	iY = selected - firstElement;
+	iY = top + (iY * fontheight);
+	s.box(2, iY, 308, fontheight, gmenu2x.skinConfColors[COLOR_SELECTION_BG]);
 
-		//Files & Directories
-		s.setClipRect(0, top, 311, height);
-		for (i = firstElement; i < wallpapers.size()
-					&& i < firstElement + nb_elements; i++) {
-			iY = i-firstElement;
-			gmenu2x.font->write(s, wallpapers[i], 5,
-						top + (iY * fontheight),
-						Font::HAlignLeft, Font::VAlignTop);
+	//Files & Directories
+	s.setClipRect(0, top, 311, height - stripHeight);
+	for (i = firstElement; i < wallpapers.size()
+				&& i < firstElement + nb_elements; i++) {
+		iY = i-firstElement;
+		gmenu2x.font->write(s, wallpapers[i], 5,
+					top + (iY * fontheight),
+					Font::HAlignLeft, Font::VAlignTop);
+	}
+	s.clearClipRect();
+
+	//Thumbnails, centered on the selection
+	s.box(0, stripTop, stripWidth, stripHeight,
+			gmenu2x.skinConfColors[COLOR_MESSAGE_BOX_BG]);
+	uint32_t firstThumb = selected > numThumbs / 2
+			? selected - numThumbs / 2 : 0;
+	if (firstThumb + numThumbs > wallpapers.size())
+		firstThumb = wallpapers.size() > numThumbs
+				? wallpapers.size() - numThumbs : 0;
+	for (i = firstThumb; i < wallpapers.size()
+				&& i < firstThumb + numThumbs; i++) {
+		int x = THUMB_SPACING + (i - firstThumb) * (thumbWidth + THUMB_SPACING);
+		int y = stripTop + THUMB_SPACING;
+		if (auto thumb = thumbnails.get(paths[i])) {
+			thumb->blitCenter(s, x + thumbWidth / 2, y + thumbHeight / 2);
 		}
-		s.clearClipRect();
-
-		gmenu2x.drawScrollBar(nb_elements, wallpapers.size(), firstElement);
-		s.flip();
-
-        switch(gmenu2x.input.waitForPressedButton()) {
-            case InputManager::CANCEL:
-                close = true;
-                result = false;
-                break;
-            case InputManager::UP:
-                if (selected == 0) selected = wallpapers.size()-1;
-                else selected -= 1;
-                break;
-            case InputManager::ALTLEFT:
-                if ((int)(selected - nb_elements + 1) < 0)
-					selected = 0;
-                else
-					selected -= nb_elements - 1;
-                break;
-            case InputManager::DOWN:
-                if (selected+1 >= wallpapers.size()) selected = 0;
-                else selected += 1;
-                break;
-            case InputManager::ALTRIGHT:
-                if (selected + nb_elements - 1 >= wallpapers.size())
-					selected = wallpapers.size() - 1;
-                else
-					selected += nb_elements - 1;
-                break;
-            case InputManager::ACCEPT:
-                close = true;
-                if (wallpapers.size() > 0)
-					wallpaper = gmenu2x.sc.getSkinFilePath("wallpapers/" + wallpapers[selected]);
-                else result = false;
-            default:
-                break;
-        }
+		if (i == selected) {
+			s.rectangle(x - 2, y - 2, thumbWidth + 4, thumbHeight + 4,
+					gmenu2x.skinConfColors[COLOR_MESSAGE_BOX_SELECTION]);
+		}
+	}
+	// Look ahead in both directions, so the strip is filled by the time
+	// the selection gets there.
+	for (i = 1; i <= numThumbs / 2; i++) {
+		if (firstThumb + numThumbs + i - 1 < wallpapers.size())
+			thumbnails.prefetch(paths[firstThumb + numThumbs + i - 1]);
+		if (firstThumb >= i)
+			thumbnails.prefetch(paths[firstThumb - i]);
 	}
 
-	for (size_t i=0; i<wallpapers.size(); i++) {
-	  gmenu2x.sc.del("skin:wallpapers/" + wallpapers[i]);
+	gmenu2x.drawScrollBar(s, nb_elements, wallpapers.size(), firstElement);
+}
+
+bool WallpaperDialog::handleButtonPress(InputManager::Button button)
+{
+	uint32_t previous = selected;
+	switch (button) {
+		case InputManager::CANCEL:
+			dismiss();
+			break;
+		case InputManager::UP:
+			if (selected == 0) selected = wallpapers.size()-1;
+			else selected -= 1;
+			break;
+		case InputManager::ALTLEFT:
+			if ((int)(selected - nb_elements + 1) < 0)
+				selected = 0;
+			else
+				selected -= nb_elements - 1;
+			break;
+		case InputManager::DOWN:
+			if (selected+1 >= wallpapers.size()) selected = 0;
+			else selected += 1;
+			break;
+		case InputManager::ALTRIGHT:
+			if (selected + nb_elements - 1 >= wallpapers.size())
+				selected = wallpapers.size() - 1;
+			else
+				selected += nb_elements - 1;
+			break;
+		case InputManager::ACCEPT:
+			dismiss();
+			if (wallpapers.size() > 0 && onSelect)
+				onSelect(paths[selected]);
+			break;
+		default:
+			break;
 	}
 
-	return result;
+	if (selected != previous) {
+		previews.cancelPending();
+		selectTime = SDL_GetTicks();
+		gmenu2x.timers.start(dwellTimer, DWELL_DELAY);
+	}
+	return true;
 }
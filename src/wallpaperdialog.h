@@ -21,16 +21,59 @@
 #ifndef WALLPAPERDIALOG_H
 #define WALLPAPERDIALOG_H
 
+#include "buttonbox.h"
 #include "dialog.h"
+#include "layer.h"
+#include "thumbnailcache.h"
+#include "timerscheduler.h"
 
+#include <SDL2/SDL.h>
+#include <functional>
+#include <memory>
 #include <string>
+#include <vector>
 
-class WallpaperDialog : protected Dialog {
+class OffscreenSurface;
+
+class WallpaperDialog : public Layer, protected Dialog {
 public:
+	/** Called with the path of the selected wallpaper. */
+	typedef std::function<void(const std::string &)> Action;
+
 	WallpaperDialog(GMenu2X& gmenu2x);
-	std::string wallpaper;
+	virtual ~WallpaperDialog();
+
+	/** Sets what to do once a wallpaper has been selected. */
+	void setOnSelect(Action action) { onSelect = std::move(action); }
+
+	// Layer implementation:
+	virtual bool isModal() const { return true; }
+	virtual void paint(Surface& s);
+	virtual bool handleButtonPress(InputManager::Button button);
+
+private:
+	Action onSelect;
+
+	std::vector<std::string> wallpapers, paths;
+	uint32_t selected, firstElement;
+
+	ButtonBox buttonbox;
+
+	unsigned int top, height;
+	unsigned int thumbWidth, thumbHeight, stripHeight, stripTop, stripWidth;
+	unsigned int numThumbs;
+	ThumbnailCache thumbnails;
+	/**
+	 * Screen sized versions of the wallpapers, which are only requested
+	 * once the selection stayed on one for longer than the dwell delay.
+	 */
+	ThumbnailCache previews;
+
+	int fontheight;
+	unsigned int nb_elements;
 
-	bool exec();
+	Uint32 selectTime;
+	TimerScheduler::TimerId dwellTimer;
 };
 
 #endif // WALLPAPERDIALOG_H
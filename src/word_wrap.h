@@ -1,10 +1,83 @@
 #ifndef _WORD_WRAP_H_
 #define _WORD_WRAP_H_
 
+#include <cstddef>
 #include <string>
 
-class FontStack;
+#include "compat-string_view.h"
+#include "font_stack.h"
 
 std::string wordWrap(const FontStack &font, const std::string &text, int width);
 
+namespace word_wrap_internal {
+
+inline bool IsBlank(char32_t c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+// Returns the length of `text` without trailing blanks.
+inline std::size_t TrimmedLength(compat::string_view text) {
+	std::size_t length = text.size();
+	while (length != 0 && IsBlank(text[length - 1])) --length;
+	return length;
+}
+
+}  // namespace word_wrap_internal
+
+// Calls `fn(start, length)` for each row that `line`, which must not contain
+// newlines, wraps into at the given width. Rows are byte ranges of `line`
+// without trailing blanks; only the first row keeps its indentation. A blank
+// line produces no rows.
+//
+// The line is scanned once: prefix widths come from the font's cached glyph
+// advances, and after a break only the carried-over word is scanned again.
+template <typename Fn>
+void forEachWrappedRow(const FontStack &font, compat::string_view line,
+                       int width, Fn &&fn) {
+	using word_wrap_internal::IsBlank;
+	using word_wrap_internal::TrimmedLength;
+
+	std::size_t row_start = 0;
+	while (row_start != line.size()) {
+		const compat::string_view run = line.substr(row_start);
+
+		// Find the first character that doesn't fit, and the last blank that
+		// follows some text, which is where we prefer to break.
+		std::size_t overflow = compat::string_view::npos;
+		std::size_t last_blank = compat::string_view::npos;
+		std::size_t pos = 0;
+		bool seen_text = false;
+		font.forEachPrefixWidth(run, [&](char32_t c, std::size_t next, int w) {
+			if (IsBlank(c)) {
+				// Blanks never overflow: trailing ones are trimmed.
+				if (seen_text) last_blank = pos;
+			} else {
+				// If not even 1 character fits, make it fit anyway, otherwise
+				// we're in for an infinite loop. This can happen if the font
+				// size is large.
+				if (w > width && pos != 0) {
+					overflow = pos;
+					return false;
+				}
+				seen_text = true;
+			}
+			pos = next;
+			return true;
+		});
+
+		if (overflow == compat::string_view::npos) {
+			const std::size_t length = TrimmedLength(run);
+			if (length != 0) fn(row_start, length);
+			return;
+		}
+
+		// The run shall be split at the last space-separated word that fully
+		// fits, or otherwise at the last character that fits.
+		const std::size_t fits =
+		    last_blank != compat::string_view::npos ? last_blank : overflow;
+		fn(row_start, TrimmedLength(run.substr(0, fits)));
+
+		row_start += fits;
+		while (row_start < line.size() && IsBlank(line[row_start])) ++row_start;
+	}
+}
+
 #endif  // _WORD_WRAP_H_
@@ -0,0 +1,259 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#include "wrappedtext.h"
+
+#include "font_stack.h"
+#include "utilities.h"
+#include "word_wrap.h"
+
+#include <algorithm>
+
+using namespace std;
+
+/** Texts up to this size are counted right away instead of in the
+  * background, which is cheaper than loading fonts for another thread. */
+static const size_t SYNC_COUNT_LIMIT = 16 * 1024;
+
+/** Paragraphs between row index checkpoints. */
+static const unsigned int CHECKPOINT_INTERVAL = 64;
+
+/** Wrapped paragraphs kept around for scrolling back and forth. */
+static const size_t MAX_PARAGRAPHS = 256;
+
+WrappedText::WrappedText(const FontStack &font, compat::string_view text,
+		int width, bool countInBackground)
+	: font(font)
+	, text(text)
+	, width(width)
+	, stopping(false)
+	, counted(false)
+	, bytesCounted(0)
+	, rowsCounted(0)
+{
+	if (!countInBackground || this->text.size() <= SYNC_COUNT_LIMIT) {
+		countRows(font, false);
+	} else {
+		workerFont = font.duplicate();
+		worker = thread([this] { countRows(*workerFont, true); });
+	}
+}
+
+WrappedText::~WrappedText()
+{
+	stopping = true;
+	if (worker.joinable())
+		worker.join();
+}
+
+size_t WrappedText::textEnd() const
+{
+	// A final newline ends the last line instead of starting an empty one.
+	if (!text.empty() && text.back() == '\n')
+		return text.size() - 1;
+	return text.size();
+}
+
+size_t WrappedText::paragraphStart(size_t offset) const
+{
+	if (offset == 0)
+		return 0;
+	size_t newline = text.rfind('\n', offset - 1);
+	return newline == compat::string_view::npos ? 0 : newline + 1;
+}
+
+size_t WrappedText::paragraphEnd(size_t start) const
+{
+	return min(text.find('\n', start), textEnd());
+}
+
+void WrappedText::wrap(const FontStack &font, compat::string_view paragraph,
+		int width, vector<Row> &rows)
+{
+	rows.clear();
+	forEachWrappedRow(font, paragraph, width, [&rows](size_t start, size_t length) {
+		rows.emplace_back(start, length);
+	});
+	if (rows.empty())
+		rows.emplace_back(0, 0);
+}
+
+const vector<WrappedText::Row> &WrappedText::wrapParagraph(size_t start)
+{
+	auto it = paragraphs.find(start);
+	if (it != paragraphs.end())
+		return it->second;
+
+	if (paragraphs.size() >= MAX_PARAGRAPHS)
+		paragraphs.clear();
+	auto &rows = paragraphs[start];
+	const size_t end = paragraphEnd(start);
+	wrap(font, text.substr(start, end - start), width, rows);
+	return rows;
+}
+
+size_t WrappedText::rowAt(size_t offset)
+{
+	offset = min(offset, textEnd());
+	const size_t start = paragraphStart(offset);
+	const auto &rows = wrapParagraph(start);
+	size_t row = start + rows[0].first;
+	for (auto const& r : rows) {
+		if (start + r.first > offset)
+			break;
+		row = start + r.first;
+	}
+	return row;
+}
+
+vector<compat::string_view> WrappedText::rows(size_t pos, unsigned int count)
+{
+	vector<compat::string_view> result;
+	result.reserve(count);
+	size_t start = paragraphStart(pos);
+	while (result.size() < count) {
+		const auto &rows = wrapParagraph(start);
+		for (auto const& r : rows) {
+			if (start + r.first < pos)
+				continue;
+			result.emplace_back(text.data() + start + r.first, r.second);
+			if (result.size() == count)
+				break;
+		}
+		const size_t end = paragraphEnd(start);
+		if (end >= textEnd())
+			break;
+		start = end + 1;
+	}
+	return result;
+}
+
+size_t WrappedText::nextRow(size_t pos, unsigned int count)
+{
+	size_t start = paragraphStart(pos);
+	while (true) {
+		const auto &rows = wrapParagraph(start);
+		for (auto const& r : rows) {
+			if (start + r.first <= pos)
+				continue;
+			pos = start + r.first;
+			if (--count == 0)
+				return pos;
+		}
+		const size_t end = paragraphEnd(start);
+		if (end >= textEnd())
+			return pos;
+		start = end + 1;
+	}
+}
+
+size_t WrappedText::previousRow(size_t pos, unsigned int count)
+{
+	size_t start = paragraphStart(pos);
+	const vector<Row> *rows = &wrapParagraph(start);
+	size_t index = 0;
+	while (index + 1 < rows->size() && start + (*rows)[index + 1].first <= pos)
+		index++;
+
+	while (count) {
+		if (index > 0) {
+			const size_t step = min<size_t>(index, count);
+			index -= step;
+			count -= step;
+		} else if (start == 0) {
+			break;
+		} else {
+			start = paragraphStart(start - 1);
+			rows = &wrapParagraph(start);
+			index = rows->size();
+		}
+	}
+	return start + (*rows)[index].first;
+}
+
+size_t WrappedText::lastPage(unsigned int rowsPerPage)
+{
+	return previousRow(rowAt(textEnd()), max(rowsPerPage, 1u) - 1);
+}
+
+void WrappedText::countRows(const FontStack &font, bool background)
+{
+	vector<Row> rows;
+	size_t start = 0;
+	unsigned int total = 0, paragraphCount = 0;
+	while (!stopping) {
+		if (paragraphCount % CHECKPOINT_INTERVAL == 0) {
+			lock_guard<mutex> lock(progressMutex);
+			checkpoints.emplace_back(start, total);
+			bytesCounted = start;
+			rowsCounted = total;
+		}
+
+		const size_t end = paragraphEnd(start);
+		wrap(font, text.substr(start, end - start), width, rows);
+		total += rows.size();
+		paragraphCount++;
+		if (end >= textEnd())
+			break;
+		start = end + 1;
+	}
+	if (stopping)
+		return;
+
+	{
+		lock_guard<mutex> lock(progressMutex);
+		bytesCounted = text.size();
+		rowsCounted = total;
+	}
+	counted = true;
+	if (background)
+		request_repaint();
+}
+
+unsigned int WrappedText::totalRows()
+{
+	lock_guard<mutex> lock(progressMutex);
+	if (counted)
+		return rowsCounted;
+	if (bytesCounted == 0)
+		return text.size() / 32 + 1;
+	return max<unsigned int>(rowsCounted,
+			double(rowsCounted) * text.size() / bytesCounted);
+}
+
+unsigned int WrappedText::rowIndex(size_t pos)
+{
+	const size_t start = paragraphStart(pos);
+
+	size_t checkpoint;
+	unsigned int index;
+	{
+		lock_guard<mutex> lock(progressMutex);
+		if (!counted && start >= bytesCounted) {
+			// Not counted yet; extrapolate from the progress so far.
+			if (bytesCounted == 0)
+				return pos / 32;
+			return rowsCounted + double(rowsCounted) * (pos - bytesCounted)
+					/ bytesCounted;
+		}
+		auto it = upper_bound(checkpoints.begin(), checkpoints.end(),
+				make_pair(start, ~0u));
+		checkpoint = prev(it)->first;
+		index = prev(it)->second;
+	}
+
+	// Less than CHECKPOINT_INTERVAL paragraphs to wrap from the checkpoint.
+	vector<Row> rows;
+	while (checkpoint < start) {
+		const size_t end = paragraphEnd(checkpoint);
+		wrap(font, text.substr(checkpoint, end - checkpoint),
+				width, rows);
+		index += rows.size();
+		checkpoint = end + 1;
+	}
+	for (auto const& r : wrapParagraph(start)) {
+		if (start + r.first >= pos)
+			break;
+		index++;
+	}
+	return index;
+}
@@ -0,0 +1,101 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#ifndef WRAPPEDTEXT_H
+#define WRAPPEDTEXT_H
+
+#include "compat-string_view.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class FontStack;
+
+/**
+ * Word-wrapped view of a text that only wraps what is shown.
+ *
+ * Positions in the text are the byte offsets at which rows start. Rows are
+ * produced by wrapping the paragraphs around a position on demand, so
+ * showing any part of a huge text, including jumping into its middle, costs
+ * about as much as wrapping a screenful. Row totals for the scroll bar are
+ * counted by a background thread; until it is done, they are estimated from
+ * its progress.
+ *
+ * All public methods must be called from the main thread.
+ */
+class WrappedText {
+public:
+	/**
+	 * The text must outlive the WrappedText. Without countInBackground,
+	 * the rows are counted right away, however large the text is.
+	 */
+	WrappedText(const FontStack &font, compat::string_view text, int width,
+			bool countInBackground = true);
+	~WrappedText();
+
+	/** Returns up to the given number of rows, starting at a row start. */
+	std::vector<compat::string_view> rows(size_t pos, unsigned int count);
+
+	/** Returns the start of the row containing the given byte offset. */
+	size_t rowAt(size_t offset);
+
+	/** Moves the given number of rows forward, stopping at the last row. */
+	size_t nextRow(size_t pos, unsigned int count = 1);
+
+	/** Moves the given number of rows back, stopping at the first row. */
+	size_t previousRow(size_t pos, unsigned int count = 1);
+
+	/** Returns the position of the last page of the given size. */
+	size_t lastPage(unsigned int rowsPerPage);
+
+	size_t size() const { return text.size(); }
+
+	/** Returns true once the row totals are exact. */
+	bool totalsKnown() const { return counted; }
+
+	/** Returns the number of rows, estimated until totalsKnown(). */
+	unsigned int totalRows();
+
+	/** Returns the index of the row at the given position, estimated
+	  * until totalsKnown(). */
+	unsigned int rowIndex(size_t pos);
+
+private:
+	/** Start and length of a row, relative to its paragraph. */
+	using Row = std::pair<size_t, size_t>;
+
+	size_t textEnd() const;
+	size_t paragraphStart(size_t offset) const;
+	size_t paragraphEnd(size_t start) const;
+	const std::vector<Row> &wrapParagraph(size_t start);
+	static void wrap(const FontStack &font, compat::string_view paragraph,
+			int width, std::vector<Row> &rows);
+
+	void countRows(const FontStack &font, bool background);
+
+	const FontStack &font;
+	const compat::string_view text;
+	const int width;
+
+	/** Wrapped paragraphs around the recently shown positions. */
+	std::unordered_map<size_t, std::vector<Row>> paragraphs;
+
+	/** Font handles of the counting thread. */
+	std::unique_ptr<FontStack> workerFont;
+	std::thread worker;
+	std::atomic<bool> stopping, counted;
+
+	std::mutex progressMutex;
+	/** Paragraph starts and the index of their first row, sampled every
+	  * CHECKPOINT_INTERVAL paragraphs by the counting thread. */
+	std::vector<std::pair<size_t, unsigned int>> checkpoints;
+	size_t bytesCounted;
+	unsigned int rowsCounted;
+};
+
+#endif
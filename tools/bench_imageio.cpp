@@ -0,0 +1,632 @@
+// SPDX-License-Identifier: GPL-2.0
+//
+// bench_imageio: measures and checks the image loading paths.
+//
+// Every image below the given skin directories is decoded through each load
+// path that gmenu2x uses: with and without alpha, scaled to icon size the way
+// OffscreenSurface::loadImage does it, and from inside OPK packages. Large
+// synthetic wallpapers are generated to exercise the paths that skin assets
+// are too small to stress. For each path the decode throughput, the peak
+// resident set size and the number of heap allocations are reported.
+//
+// The decoded pixels are hashed; "-u FILE" records the hashes and "-r FILE"
+// compares against recorded ones, so optimizations of the decoders cannot
+// silently change colors or alpha.
+
+#include "compat-filesystem.h"
+#include "imageio.h"
+
+#include <SDL2/SDL.h>
+#include <png.h>
+#ifdef HAVE_LIBOPK
+#include <opk.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <getopt.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace fs = compat::filesystem;
+
+// Count heap allocations by wrapping the glibc allocator. This also catches
+// the allocations of libpng and SDL, which operator new would not see.
+static size_t allocCount = 0, allocBytes = 0;
+
+#ifdef __GLIBC__
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size)
+{
+	allocCount++;
+	allocBytes += size;
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+	allocCount++;
+	allocBytes += count * size;
+	return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	allocCount++;
+	allocBytes += size;
+	return __libc_realloc(ptr, size);
+}
+
+// The aligned variants don't go through malloc inside glibc, so they need
+// wrapping too; libstdc++ uses them for over-aligned operator new.
+void *__libc_memalign(size_t alignment, size_t size);
+void *__libc_valloc(size_t size);
+
+void *memalign(size_t alignment, size_t size)
+{
+	allocCount++;
+	allocBytes += size;
+	return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size)
+{
+	return memalign(alignment, size);
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size)
+{
+	if (alignment % sizeof(void *) || (alignment & (alignment - 1)))
+		return EINVAL;
+	void *mem = memalign(alignment, size);
+	if (!mem)
+		return ENOMEM;
+	*ptr = mem;
+	return 0;
+}
+
+void *valloc(size_t size)
+{
+	allocCount++;
+	allocBytes += size;
+	return __libc_valloc(size);
+}
+}
+#endif
+
+namespace {
+
+struct Image {
+	/** Path passed to the loader. */
+	std::string path;
+	/** Stable name used in the reference hash file. */
+	std::string name;
+};
+
+struct Result {
+	unsigned int images = 0, failed = 0;
+	uint64_t pixels = 0, bytes = 0;
+	double seconds = 0;
+	size_t allocs = 0, allocBytes = 0;
+	long peakKiB = 0;
+};
+
+using Hashes = std::map<std::string, uint64_t>;
+
+int runs = 5;
+bool verbose = false;
+
+/** Size of the icons that OffscreenSurface::loadImage scales to. */
+constexpr int ICON_SIZE = 32;
+
+/** Forgets the peak RSS so far; returns false if the kernel can't do that. */
+bool resetPeakRSS()
+{
+	FILE *f = fopen("/proc/self/clear_refs", "w");
+	if (!f)
+		return false;
+	bool ok = fputs("5", f) >= 0;
+	return (fclose(f) == 0) && ok;
+}
+
+/** Returns the peak RSS in KiB since the last reset. */
+long peakRSS()
+{
+	FILE *f = fopen("/proc/self/status", "r");
+	if (f) {
+		char line[128];
+		long kib = -1;
+		while (fgets(line, sizeof(line), f)) {
+			if (sscanf(line, "VmHWM: %ld kB", &kib) == 1)
+				break;
+		}
+		fclose(f);
+		if (kib >= 0)
+			return kib;
+	}
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+
+/**
+ * Hashes the significant bits of the pixels of a surface, independent of
+ * its pitch and of the byte order of the machine.
+ */
+uint64_t hashPixels(SDL_Surface *surface)
+{
+	const SDL_PixelFormat *fmt = surface->format;
+	const uint32_t mask = fmt->Rmask | fmt->Gmask | fmt->Bmask | fmt->Amask;
+
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	auto mix = [&hash](uint32_t value) {
+		for (int i = 0; i < 4; i++) {
+			hash ^= (value >> (i * 8)) & 0xFF;
+			hash *= 0x100000001b3ULL;
+		}
+	};
+	mix(surface->w);
+	mix(surface->h);
+	mix(fmt->Amask ? 1 : 0);
+	for (int y = 0; y < surface->h; y++) {
+		auto row = reinterpret_cast<const uint32_t *>(
+				static_cast<const char *>(surface->pixels) + y * surface->pitch);
+		for (int x = 0; x < surface->w; x++)
+			mix(row[x] & mask);
+	}
+	return hash;
+}
+
+uintmax_t fileSize(const std::string &path)
+{
+	std::error_code ec;
+	std::string file = path.substr(0, path.find('#'));
+	std::string qoi = qoiSiblingPath(file);
+	if (!qoi.empty() && fs::exists(qoi, ec))
+		file = qoi;
+	uintmax_t size = fs::file_size(file, ec);
+	return ec ? 0 : size;
+}
+
+/**
+ * Runs the given loader over all images, keeping the fastest of the
+ * configured number of runs. The loader returns the surface to hash,
+ * or nullptr on failure.
+ */
+template <typename Loader>
+Result measure(const char *label, const std::vector<Image> &images,
+		Loader load, Hashes *hashes)
+{
+	Result result;
+	if (images.empty())
+		return result;
+
+	bool resetOk = resetPeakRSS();
+	for (int run = 0; run < runs; run++) {
+		const size_t countBefore = allocCount, bytesBefore = allocBytes;
+		double seconds = 0;
+		unsigned int failed = 0;
+
+		for (auto const& image : images) {
+			auto start = std::chrono::steady_clock::now();
+			SDL_Surface *surface = load(image.path);
+			std::chrono::duration<double> elapsed =
+				std::chrono::steady_clock::now() - start;
+			seconds += elapsed.count();
+
+			if (!surface) {
+				if (run == 0)
+					fprintf(stderr, "%s: %s: unable to load\n",
+							label, image.path.c_str());
+				failed++;
+				continue;
+			}
+
+			if (run == 0) {
+				result.pixels += uint64_t(surface->w) * surface->h;
+				result.bytes += fileSize(image.path);
+				if (hashes)
+					(*hashes)[std::string(label) + " " + image.name] =
+						hashPixels(surface);
+				if (verbose)
+					printf("  %s: %dx%d, %.3f ms\n", image.name.c_str(),
+							surface->w, surface->h, elapsed.count() * 1e3);
+			}
+			SDL_FreeSurface(surface);
+		}
+
+		if (run == 0) {
+			result.failed = failed;
+			result.allocs = allocCount - countBefore;
+			result.allocBytes = allocBytes - bytesBefore;
+		}
+		if (run == 0 || seconds < result.seconds)
+			result.seconds = seconds;
+	}
+	result.images = images.size();
+	result.peakKiB = resetOk ? peakRSS() : -peakRSS();
+	return result;
+}
+
+void report(const char *label, const Result &r)
+{
+	if (!r.images) {
+		printf("%-10s  skipped (no images)\n", label);
+		return;
+	}
+	const double mpix = r.pixels / 1e6, mib = r.bytes / 1048576.0;
+	printf("%-10s %5u images %8.2f Mpix %8.2f ms %8.1f Mpix/s %7.1f MiB/s"
+			" %8zu allocs/run %9.1f KiB/run  peak RSS %6ld KiB%s\n",
+			label, r.images, mpix, r.seconds * 1e3,
+			r.seconds > 0 ? mpix / r.seconds : 0,
+			r.seconds > 0 ? mib / r.seconds : 0,
+			r.allocs, r.allocBytes / 1024.0,
+			r.peakKiB < 0 ? -r.peakKiB : r.peakKiB,
+			r.peakKiB < 0 ? " (process)" : "");
+	if (r.failed)
+		printf("%-10s %u images failed to load\n", label, r.failed);
+}
+
+bool isImage(const fs::path &path)
+{
+	std::string ext = path.extension().string();
+	return strcasecmp(ext.c_str(), ".png") == 0
+		|| strcasecmp(ext.c_str(), ".qoi") == 0;
+}
+
+void collectSkinImages(const std::string &dir, std::vector<Image> &images)
+{
+	std::error_code ec;
+	std::vector<std::string> paths;
+	for (fs::recursive_directory_iterator it(dir, ec), end;
+	     !ec && it != end; it.increment(ec)) {
+		const fs::path &path = it->path();
+		if (!fs::is_regular_file(path, ec) || !isImage(path))
+			continue;
+		// A converted skin is loaded through the PNG name.
+		std::string ext = path.extension().string();
+		if (strcasecmp(ext.c_str(), ".qoi") == 0) {
+			fs::path png = path;
+			png.replace_extension(".png");
+			if (fs::exists(png, ec))
+				continue;
+		}
+		paths.push_back(path.string());
+	}
+	if (ec)
+		fprintf(stderr, "%s: %s\n", dir.c_str(), ec.message().c_str());
+
+	std::sort(paths.begin(), paths.end());
+	for (auto const& path : paths)
+		images.push_back({ path, "skins" + path.substr(dir.size()) });
+}
+
+/** Writes RGBA pixels to a PNG file. */
+bool writePNG(const std::string &path, const std::vector<uint8_t> &rgba,
+		unsigned int width, unsigned int height, bool interlaced)
+{
+	FILE *fp = fopen(path.c_str(), "wb");
+	if (!fp)
+		return false;
+
+	png_structp png = png_create_write_struct(
+			PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+	png_infop info = png ? png_create_info_struct(png) : nullptr;
+	if (!info || setjmp(png_jmpbuf(png))) {
+		png_destroy_write_struct(&png, info ? &info : nullptr);
+		fclose(fp);
+		return false;
+	}
+
+	png_init_io(png, fp);
+	png_set_IHDR(png, info, width, height, 8, PNG_COLOR_TYPE_RGBA,
+			interlaced ? PNG_INTERLACE_ADAM7 : PNG_INTERLACE_NONE,
+			PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+	png_write_info(png, info);
+
+	std::vector<png_bytep> rows(height);
+	for (unsigned int y = 0; y < height; y++)
+		rows[y] = const_cast<png_bytep>(&rgba[size_t(y) * width * 4]);
+	png_write_image(png, rows.data());
+	png_write_end(png, nullptr);
+
+	png_destroy_write_struct(&png, &info);
+	return fclose(fp) == 0;
+}
+
+/**
+ * Generates wallpaper-sized images with gradients, noise and translucent
+ * areas, in every format and layout the loaders handle differently. The
+ * content only depends on the size, so the hashes are reproducible.
+ */
+void generateWallpapers(const std::string &dir, std::vector<Image> &images)
+{
+	static const unsigned int sizes[][2] = {
+		{ 320, 240 }, { 800, 480 }, { 1280, 720 }, { 1920, 1080 },
+	};
+
+	std::error_code ec;
+	fs::create_directories(dir, ec);
+
+	for (auto const& size : sizes) {
+		const unsigned int width = size[0], height = size[1];
+		std::vector<uint8_t> rgba(size_t(width) * height * 4);
+		uint32_t state = 0x9E3779B9u ^ (width * 2654435761u) ^ height;
+		for (unsigned int y = 0; y < height; y++) {
+			for (unsigned int x = 0; x < width; x++) {
+				state ^= state << 13;
+				state ^= state >> 17;
+				state ^= state << 5;
+				uint8_t *p = &rgba[(size_t(y) * width + x) * 4];
+				p[0] = uint8_t(x * 255 / width) ^ (state & 0x0F);
+				p[1] = uint8_t(y * 255 / height);
+				p[2] = uint8_t((x + y) >> 2) ^ ((state >> 8) & 0x07);
+				// Opaque, except for a translucent band and a hole.
+				p[3] = (y > height / 3 && y < height / 2) ? uint8_t(x) : 255;
+				if (x > width / 2 && x < width / 2 + 16 && y < 16)
+					p[3] = 0;
+			}
+		}
+
+		const std::string base = std::to_string(width) + "x" + std::to_string(height);
+		for (bool interlaced : { false, true }) {
+			const std::string name = base + (interlaced ? "-interlaced" : "") + ".png";
+			if (!writePNG(dir + "/" + name, rgba, width, height, interlaced)) {
+				fprintf(stderr, "%s/%s: unable to write\n", dir.c_str(), name.c_str());
+				continue;
+			}
+			images.push_back({ dir + "/" + name, "synthetic/" + name });
+		}
+
+		// Same pixels again as QOI, decoded from the PNG we just wrote.
+		SDL_Surface *surface = loadPNG(dir + "/" + base + ".png");
+		if (surface && saveQOI(surface, dir + "/" + base + ".qoi"))
+			images.push_back({ dir + "/" + base + ".qoi", "synthetic/" + base + ".qoi" });
+		SDL_FreeSurface(surface);
+	}
+}
+
+void collectPackageIcons(const std::string &opkPath,
+		[[maybe_unused]] std::vector<Image> &images)
+{
+#ifdef HAVE_LIBOPK
+	struct OPK *opk = opk_open(opkPath.c_str());
+	if (!opk) {
+		fprintf(stderr, "%s: unable to open package\n", opkPath.c_str());
+		return;
+	}
+
+	const std::string opkName = fs::path(opkPath).filename().string();
+	const char *metadata;
+	while (opk_open_metadata(opk, &metadata) > 0) {
+		const char *key, *val;
+		size_t lkey, lval;
+		while (opk_read_pair(opk, &key, &lkey, &val, &lval) > 0) {
+			if (lkey == 4 && !strncmp(key, "Icon", 4)) {
+				std::string icon = std::string(val, lval) + ".png";
+				images.push_back({ opkPath + "#" + icon, "opk/" + opkName + "#" + icon });
+			}
+		}
+	}
+	opk_close(opk);
+#else
+	fprintf(stderr, "%s: built without OPK support\n", opkPath.c_str());
+#endif
+}
+
+/**
+ * Loads an image and scales it to icon size on the GPU side, following the
+ * same steps as OffscreenSurface::loadImage, then reads the result back.
+ */
+SDL_Surface *loadResized(SDL_Renderer *renderer, const std::string &path)
+{
+	SDL_Surface *raw = loadImageFile(path);
+	if (!raw)
+		return nullptr;
+
+	SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, raw);
+	SDL_FreeSurface(raw);
+	if (!texture)
+		return nullptr;
+
+	SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+	Uint32 format;
+	SDL_QueryTexture(texture, &format, nullptr, nullptr, nullptr);
+	SDL_Texture *stretched = SDL_CreateTexture(renderer, format,
+			SDL_TEXTUREACCESS_TARGET, ICON_SIZE, ICON_SIZE);
+	SDL_Surface *result = nullptr;
+	if (stretched) {
+		SDL_SetTextureBlendMode(stretched, SDL_BLENDMODE_BLEND);
+		SDL_Texture *current = SDL_GetRenderTarget(renderer);
+		SDL_SetRenderTarget(renderer, stretched);
+		SDL_RenderCopy(renderer, texture, nullptr, nullptr);
+
+		result = SDL_CreateRGBSurface(0, ICON_SIZE, ICON_SIZE, 32,
+				0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+		if (result)
+			SDL_RenderReadPixels(renderer, nullptr, SDL_PIXELFORMAT_ARGB8888,
+					result->pixels, result->pitch);
+		SDL_SetRenderTarget(renderer, current);
+		SDL_DestroyTexture(stretched);
+	}
+	SDL_DestroyTexture(texture);
+	return result;
+}
+
+Hashes readReference(const std::string &path)
+{
+	Hashes hashes;
+	std::ifstream in(path);
+	std::string line;
+	while (std::getline(in, line)) {
+		if (line.empty() || line[0] == '#')
+			continue;
+		char label[32];
+		uint64_t hash;
+		int offset;
+		if (sscanf(line.c_str(), "%16" SCNx64 " %31s %n", &hash, label, &offset) == 2)
+			hashes[std::string(label) + " " + line.substr(offset)] = hash;
+	}
+	return hashes;
+}
+
+bool writeReference(const std::string &path, const Hashes &hashes)
+{
+	FILE *f = fopen(path.c_str(), "w");
+	if (!f)
+		return false;
+	fprintf(f, "# Pixel hashes of bench_imageio; regenerate with -u.\n");
+	for (auto const& entry : hashes) {
+		auto space = entry.first.find(' ');
+		fprintf(f, "%016" PRIx64 " %s %s\n", entry.second,
+				entry.first.substr(0, space).c_str(),
+				entry.first.substr(space + 1).c_str());
+	}
+	return fclose(f) == 0;
+}
+
+/** Returns the number of hashes that differ from the reference. */
+unsigned int verify(const Hashes &hashes, const Hashes &reference)
+{
+	unsigned int mismatches = 0, checked = 0, unknown = 0;
+	for (auto const& entry : hashes) {
+		auto it = reference.find(entry.first);
+		if (it == reference.end()) {
+			unknown++;
+			continue;
+		}
+		checked++;
+		if (it->second != entry.second) {
+			printf("MISMATCH %s: %016" PRIx64 ", expected %016" PRIx64 "\n",
+					entry.first.c_str(), entry.second, it->second);
+			mismatches++;
+		}
+	}
+	printf("conformance: %u checked, %u mismatched, %u without reference\n",
+			checked, mismatches, unknown);
+	return mismatches;
+}
+
+void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"Usage: %s [-n RUNS] [-o FILE.opk]... [-t DIR] [-r FILE] [-u FILE] [-v] [SKINDIR]\n"
+		"Measures decoding of all images below SKINDIR (default: data/skins),\n"
+		"of generated wallpapers and of the icons of the given OPK packages.\n\n"
+		"  -n RUNS  measure the fastest of RUNS passes (default: 5)\n"
+		"  -o FILE  also load the icons of an OPK package\n"
+		"  -t DIR   where to generate wallpapers (default: a temporary directory)\n"
+		"  -r FILE  check the pixel hashes against a reference file\n"
+		"  -u FILE  write the pixel hashes to a reference file\n"
+		"  -v       report every image\n", argv0);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+	std::vector<std::string> packages;
+	std::string tempDir, referenceFile, updateFile;
+	int opt;
+	while ((opt = getopt(argc, argv, "n:o:t:r:u:vh")) != -1) {
+		switch (opt) {
+		case 'n': runs = std::max(1, atoi(optarg)); break;
+		case 'o': packages.push_back(optarg); break;
+		case 't': tempDir = optarg; break;
+		case 'r': referenceFile = optarg; break;
+		case 'u': updateFile = optarg; break;
+		case 'v': verbose = true; break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : 2;
+		}
+	}
+	if (argc - optind > 1) {
+		usage(argv[0]);
+		return 2;
+	}
+	std::string skinDir = optind < argc ? argv[optind] : "data/skins";
+	while (skinDir.size() > 1 && skinDir.back() == '/')
+		skinDir.pop_back();
+
+	bool removeTempDir = false;
+	if (tempDir.empty()) {
+		char dir[] = "/tmp/bench_imageio.XXXXXX";
+		if (!mkdtemp(dir)) {
+			perror("mkdtemp");
+			return 1;
+		}
+		tempDir = dir;
+		removeTempDir = true;
+	}
+
+	std::vector<Image> skins, wallpapers, icons;
+	collectSkinImages(skinDir, skins);
+	generateWallpapers(tempDir, wallpapers);
+	for (auto const& package : packages)
+		collectPackageIcons(package, icons);
+
+	Hashes hashes;
+	auto plain = [](const std::string &path) { return loadImageFile(path); };
+	auto noAlpha = [](const std::string &path) { return loadImageFile(path, false); };
+
+	report("plain", measure("plain", skins, plain, &hashes));
+	report("no-alpha", measure("no-alpha", skins, noAlpha, &hashes));
+
+	// A software renderer needs no display, so this also runs headless.
+	// Scaled output depends on the renderer, so it is not hashed.
+	SDL_Surface *target = SDL_CreateRGBSurface(0, 1, 1, 32,
+			0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+	SDL_Renderer *renderer = target ? SDL_CreateSoftwareRenderer(target) : nullptr;
+	if (renderer) {
+		report("resized", measure("resized", skins,
+				[renderer](const std::string &path) {
+					return loadResized(renderer, path);
+				}, nullptr));
+		SDL_DestroyRenderer(renderer);
+	} else {
+		printf("%-10s  skipped (no renderer: %s)\n", "resized", SDL_GetError());
+	}
+	SDL_FreeSurface(target);
+
+	report("wallpaper", measure("wallpaper", wallpapers, plain, &hashes));
+	report("wp-noalpha", measure("wp-noalpha", wallpapers, noAlpha, &hashes));
+	report("opk", measure("opk", icons, plain, &hashes));
+
+	if (removeTempDir) {
+		std::error_code ec;
+		fs::remove_all(tempDir, ec);
+	}
+
+	int status = 0;
+	if (!updateFile.empty() && !writeReference(updateFile, hashes)) {
+		fprintf(stderr, "%s: unable to write\n", updateFile.c_str());
+		status = 1;
+	}
+	if (!referenceFile.empty()) {
+		Hashes reference = readReference(referenceFile);
+		if (reference.empty()) {
+			fprintf(stderr, "%s: no reference hashes\n", referenceFile.c_str());
+			status = 1;
+		} else if (verify(hashes, reference)) {
+			status = 1;
+		}
+	}
+	return status;
+}
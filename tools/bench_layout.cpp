@@ -0,0 +1,279 @@
+// SPDX-License-Identifier: GPL-2.0
+//
+// bench_layout: measures solving the layout of LayoutItem trees.
+//
+// Three trees are solved through Layout::run:
+//   nested  the tree of benchmark_nested in src/layout/benchmark_layout.c,
+//           a column of five rows, 170 items in all,
+//   wide    a single row of N items, like a long bottom bar,
+//   deep    N containers nested in each other.
+// Each tree is measured after three kinds of change:
+//   rebuild  an item is removed and added again, so the nodes of the layout
+//            context are rebuilt before solving, as was done every frame,
+//   resize   the size of an item changes, so the existing nodes are updated
+//            in place before solving,
+//   idle     nothing changes, so nothing is solved.
+// The nested tree is checked against the rects that benchmark_layout.c
+// expects after every run.
+
+#include "layout.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include <getopt.h>
+
+namespace {
+
+struct Tree {
+	const char *name;
+	Layout layout;
+	std::vector<std::shared_ptr<LayoutItem>> items;
+	/** Removed and added again for a rebuild. */
+	std::shared_ptr<LayoutItem> parent, leaf;
+	/** Resized for a resize. */
+	std::shared_ptr<LayoutItem> sized;
+	lay_vec2 size;
+	/** Checks the rects after a run, if not null. */
+	bool (*check)(const Tree &tree);
+};
+
+std::shared_ptr<LayoutItem> newItem(Tree &tree, LayoutItem &parent)
+{
+	auto item = std::make_shared<LayoutItem>();
+	parent.addChild(item);
+	tree.items.push_back(item);
+	return item;
+}
+
+bool rectIs(const LayoutItem &item, short x, short y, short w, short h)
+{
+	const lay_vec4 r = item.getRect();
+	return r[0] == x && r[1] == y && r[2] == w && r[3] == h;
+}
+
+bool checkNested(const Tree &tree)
+{
+	// items[0] is main_child, items[1 + i] are the rows.
+	return rectIs(*tree.items[0], 10, 10, 50, 40)
+		&& rectIs(*tree.items[1], 10, 10, 50, 10)
+		&& rectIs(*tree.items[2], 10, 20, 50, 10)
+		&& rectIs(*tree.items[3], 10, 30, 50, 10)
+		&& rectIs(*tree.items[4], 10, 40, 50, 0)
+		&& rectIs(*tree.items[5], 10, 40, 50, 10);
+}
+
+void buildNested(Tree &tree)
+{
+	auto root = tree.layout.topItem();
+	root->setSize(70, 4 * 10 + 2 * 10);
+
+	auto main = newItem(tree, *root);
+	main->setMargins(10, 10, 10, 10);
+	main->setContainer(LAY_COLUMN);
+	main->setBehave(LAY_FILL);
+
+	std::shared_ptr<LayoutItem> rows[5];
+	for (auto &row : rows) {
+		row = newItem(tree, *main);
+		row->setContainer(LAY_ROW);
+	}
+	rows[0]->setBehave(LAY_FILL);
+	rows[1]->setBehave(LAY_VFILL);
+	rows[3]->setBehave(LAY_HFILL);
+	rows[4]->setBehave(LAY_FILL);
+
+	for (int i = 0; i < 5; i++)
+		newItem(tree, *rows[0])->setBehave(LAY_FILL);
+	for (int i = 0; i < 5; i++) {
+		auto col = newItem(tree, *rows[1]);
+		col->setSize(10, 0);
+		col->setBehave(LAY_VFILL);
+	}
+	for (int i = 0; i < 2; i++) {
+		auto col = newItem(tree, *rows[2]);
+		col->setBehave(LAY_BOTTOM);
+		newItem(tree, *col)->setSize(25, 10 * i);
+	}
+	for (int i = 0; i < 99; i++)
+		newItem(tree, *rows[3]);
+	for (int i = 0; i < 50; i++)
+		newItem(tree, *rows[4])->setBehave(LAY_FILL);
+
+	tree.parent = rows[4];
+	tree.leaf = tree.items.back();
+	// The first item of the fourth row; that row fills the width anyway,
+	// so resizing the item moves nothing that is checked.
+	tree.sized = tree.items[1 + 5 + 5 + 5 + 4];
+	tree.size = (lay_vec2){ 0, 0 };
+	tree.check = checkNested;
+}
+
+void buildWide(Tree &tree, unsigned int n)
+{
+	auto root = tree.layout.topItem();
+	root->setSize(320, 240);
+	root->setContainer(LAY_COLUMN);
+
+	auto row = newItem(tree, *root);
+	row->setContainer(LAY_FLEX | LAY_ROW | LAY_START);
+	row->setBehave(LAY_HFILL);
+	for (unsigned int i = 0; i < n; i++) {
+		auto item = newItem(tree, *row);
+		item->setSize(16, 16);
+		item->setMargins(4, 0, 0, 0);
+	}
+
+	tree.parent = row;
+	tree.leaf = tree.items.back();
+	tree.sized = tree.items[1];
+	tree.size = (lay_vec2){ 16, 16 };
+	tree.check = nullptr;
+}
+
+void buildDeep(Tree &tree, unsigned int n)
+{
+	std::shared_ptr<LayoutItem> item = tree.layout.topItem();
+	item->setSize(320, 240);
+	for (unsigned int i = 0; i < n; i++) {
+		item->setContainer(i % 2 ? LAY_ROW : LAY_COLUMN);
+		item = newItem(tree, *item);
+		item->setMargins(1, 1, 1, 1);
+		item->setBehave(LAY_FILL);
+	}
+	auto parent = tree.items[tree.items.size() - 2];
+
+	tree.parent = parent;
+	tree.leaf = item;
+	tree.sized = item;
+	tree.size = (lay_vec2){ 8, 8 };
+	tree.check = nullptr;
+}
+
+struct Result {
+	const char *tree, *change;
+	unsigned long runs;
+	size_t items;
+	double seconds;
+};
+
+/** Applies the change and runs the layout, for at least the given time. */
+template <typename Fn>
+Result measure(Tree &tree, const char *change, double minSeconds, Fn &&fn)
+{
+	Result result = { tree.name, change, 0, tree.items.size() + 1, 0 };
+	const auto start = std::chrono::steady_clock::now();
+	std::chrono::duration<double> elapsed(0);
+	do {
+		for (int i = 0; i < 100; i++) {
+			fn();
+			tree.layout.run();
+			if (tree.check && !tree.check(tree)) {
+				fprintf(stderr, "%s: wrong layout after %s\n",
+						tree.name, change);
+				exit(1);
+			}
+		}
+		result.runs += 100;
+		elapsed = std::chrono::steady_clock::now() - start;
+	} while (elapsed.count() < minSeconds);
+
+	result.seconds = elapsed.count();
+	return result;
+}
+
+void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"Usage: %s [-n ITEMS] [-t MS] [-j FILE]\n"
+		"Benchmarks solving the layout of a nested tree, and of a wide and\n"
+		"a deep tree of ITEMS items (default: 100). Each measurement runs\n"
+		"for at least MS milliseconds (default: 200). -j writes the results\n"
+		"to FILE as JSON too.\n",
+		argv0);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+	unsigned int n = 100;
+	int ms = 200;
+	const char *json = nullptr;
+	int opt;
+	while ((opt = getopt(argc, argv, "n:t:j:h")) != -1) {
+		switch (opt) {
+		case 'n': n = std::max(2, atoi(optarg)); break;
+		case 't': ms = std::max(1, atoi(optarg)); break;
+		case 'j': json = optarg; break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : 2;
+		}
+	}
+	if (optind != argc) {
+		usage(argv[0]);
+		return 2;
+	}
+
+	Tree nested, wide, deep;
+	nested.name = "nested";
+	buildNested(nested);
+	wide.name = "wide";
+	buildWide(wide, n);
+	deep.name = "deep";
+	buildDeep(deep, n);
+
+	std::vector<Result> results;
+	for (Tree *tree : { &nested, &wide, &deep }) {
+		tree->layout.run();
+
+		results.push_back(measure(*tree, "rebuild", ms / 1000.0, [tree] {
+			tree->parent->removeChild(tree->leaf);
+			tree->parent->addChild(tree->leaf);
+		}));
+		const lay_vec2 size = tree->size;
+		bool toggle = false;
+		results.push_back(measure(*tree, "resize", ms / 1000.0,
+				[tree, size, &toggle] {
+			toggle = !toggle;
+			tree->sized->setSize(size[0] + toggle, size[1]);
+		}));
+		tree->sized->setSize(size);
+		results.push_back(measure(*tree, "idle", ms / 1000.0, [] {}));
+	}
+
+	printf("%-8s %-8s %6s %12s %12s\n",
+			"tree", "change", "items", "us/run", "ns/item");
+	for (auto const& r : results) {
+		const double ns = r.seconds * 1e9 / r.runs;
+		printf("%-8s %-8s %6zu %12.2f %12.1f\n",
+				r.tree, r.change, r.items, ns / 1000, ns / r.items);
+	}
+
+	if (json) {
+		FILE *out = fopen(json, "w");
+		if (!out) {
+			fprintf(stderr, "%s: unable to write\n", json);
+			return 1;
+		}
+		fprintf(out, "{\n  \"results\": [\n");
+		for (size_t i = 0; i < results.size(); i++) {
+			auto const& r = results[i];
+			fprintf(out, "    { \"tree\": \"%s\", \"change\": \"%s\", "
+					"\"items\": %zu, \"ns_per_run\": %.1f }%s\n",
+					r.tree, r.change, r.items, r.seconds * 1e9 / r.runs,
+					i + 1 < results.size() ? "," : "");
+		}
+		fprintf(out, "  ]\n}\n");
+		if (fclose(out) != 0) {
+			fprintf(stderr, "%s: unable to write\n", json);
+			return 1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,429 @@
+// SPDX-License-Identifier: GPL-2.0
+//
+// bench_text: measures text measurement, wrapping and drawing.
+//
+// Runs FontStack::getTextWidth, wordWrap, FontStack::write and
+// FontStack::render on three workloads:
+//   latin      short menu labels and descriptions,
+//   cjk        labels mixing Latin and CJK, which need the fallback fonts,
+//   paragraph  a long paragraph, as shown by the text dialogs.
+// For each, it reports the time per glyph (code point), the heap allocations
+// per call (through operator new and SDL_malloc; FreeType's own allocations
+// are not seen) and the textures created per call. It also reports the
+// resident memory taken by loading the fonts, and by loading them again for
+// a duplicate stack and at a larger size.
+//
+// Nothing is shown: drawing goes to a software renderer on a memory surface.
+// The fonts default to those of gmenu2x, so the results depend on the fonts
+// installed; -j writes the results as JSON, for comparing builds.
+
+#include "font_spec.h"
+#include "font_stack.h"
+#include "surface.h"
+#include "utf8.h"
+#include "utilities.h"
+#include "word_wrap.h"
+
+#include <SDL2/SDL.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <getopt.h>
+
+// Counters, updated by the hooks below.
+static std::atomic<unsigned long> allocations(0);
+static std::atomic<unsigned long> textures(0);
+
+void *operator new(size_t size)
+{
+	allocations++;
+	if (void *p = malloc(size ? size : 1))
+		return p;
+	throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	allocations++;
+	return malloc(size ? size : 1);
+}
+
+void *operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return operator new(size, std::nothrow);
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+// The build links with --wrap for these, so that the texture creations of
+// the sources compiled into this program go through here.
+extern "C" {
+
+SDL_Texture *__real_SDL_CreateTexture(SDL_Renderer *renderer, Uint32 format,
+		int access, int w, int h);
+SDL_Texture *__real_SDL_CreateTextureFromSurface(SDL_Renderer *renderer,
+		SDL_Surface *surface);
+
+SDL_Texture *__wrap_SDL_CreateTexture(SDL_Renderer *renderer, Uint32 format,
+		int access, int w, int h)
+{
+	textures++;
+	return __real_SDL_CreateTexture(renderer, format, access, w, h);
+}
+
+SDL_Texture *__wrap_SDL_CreateTextureFromSurface(SDL_Renderer *renderer,
+		SDL_Surface *surface)
+{
+	textures++;
+	return __real_SDL_CreateTextureFromSurface(renderer, surface);
+}
+
+}
+
+namespace {
+
+SDL_malloc_func realMalloc;
+SDL_calloc_func realCalloc;
+SDL_realloc_func realRealloc;
+SDL_free_func realFree;
+
+void *countingMalloc(size_t size)
+{
+	allocations++;
+	return realMalloc(size);
+}
+
+void *countingCalloc(size_t nmemb, size_t size)
+{
+	allocations++;
+	return realCalloc(nmemb, size);
+}
+
+void *countingRealloc(void *p, size_t size)
+{
+	allocations++;
+	return realRealloc(p, size);
+}
+
+/** Draw target; Surface only offers its constructor to subclasses. */
+class TargetSurface : public Surface {
+public:
+	explicit TargetSurface(SDL_Texture *texture) : Surface(texture) {}
+	~TargetSurface() { SDL_DestroyTexture(texture); }
+};
+
+const char *const latinLabels[] = {
+	"Applications", "Emulators", "Games", "Settings", "Explorer",
+	"Launch an application", "Configure GMenu2X's options",
+	"Activate the TV-out", "Format internal SD card", "Übersicht",
+	"Paramètres système", "Configuración de la batería",
+};
+
+const char *const cjkLabels[] = {
+	"設定 Settings", "ファイル Explorer", "应用程序 Applications",
+	"게임 Games", "Übersetzung 翻訳", "Launch アプリケーション",
+	"电池 Battery 82%", "スキン: Default", "音量と明るさ",
+};
+
+std::string paragraph()
+{
+	static const char *const sentences[] = {
+		"GMenu2X is a frontend for embedded devices running Linux. ",
+		"It launches applications from OPK packages and plain executables, ",
+		"organizes them in sections and shows their manuals, ",
+		"which can be long enough to need scrolling through many pages. ",
+		"Les accents et les caractères spéciaux doivent s'afficher aussi. ",
+	};
+	std::string text;
+	for (unsigned int i = 0; text.size() < 4096; i = (i * 7 + 3) % 5)
+		text += sentences[i];
+	text.pop_back();
+	return text;
+}
+
+struct Workload {
+	const char *name;
+	std::vector<std::string> texts;
+	/** The texts wrapped to the dialog width, for drawing. */
+	std::vector<std::string> wrapped;
+	bool render;
+};
+
+struct Result {
+	const char *workload, *operation;
+	unsigned long calls, glyphs, allocations, textures;
+	double seconds;
+};
+
+/** Returns the resident set size of this process, or -1 if unknown. */
+long residentKiB()
+{
+	FILE *status = fopen("/proc/self/status", "r");
+	if (!status)
+		return -1;
+	char line[128];
+	long kib = -1;
+	while (fgets(line, sizeof(line), status)) {
+		if (sscanf(line, "VmRSS: %ld kB", &kib) == 1)
+			break;
+	}
+	fclose(status);
+	return kib;
+}
+
+size_t countGlyphs(const std::string &text)
+{
+	size_t glyphs = 0;
+	for (size_t pos = 0; pos < text.size(); ) {
+		if (DecodeUtf8(text, &pos) != '\n')
+			glyphs++;
+	}
+	return glyphs;
+}
+
+/**
+ * Calls fn on each text in turn, for at least the given time and after one
+ * untimed pass that fills the glyph caches.
+ */
+template <typename Fn>
+Result measure(const char *workload, const char *operation,
+		const std::vector<std::string> &texts, double minSeconds, Fn &&fn)
+{
+	for (auto const& text : texts)
+		fn(text);
+
+	unsigned long passGlyphs = 0;
+	for (auto const& text : texts)
+		passGlyphs += countGlyphs(text);
+
+	Result result = { workload, operation, 0, 0, 0, 0, 0 };
+	const unsigned long allocationsBefore = allocations;
+	const unsigned long texturesBefore = textures;
+	const auto start = std::chrono::steady_clock::now();
+	std::chrono::duration<double> elapsed(0);
+	do {
+		for (auto const& text : texts)
+			fn(text);
+		result.calls += texts.size();
+		result.glyphs += passGlyphs;
+		elapsed = std::chrono::steady_clock::now() - start;
+	} while (elapsed.count() < minSeconds);
+
+	result.seconds = elapsed.count();
+	result.allocations = allocations - allocationsBefore;
+	result.textures = textures - texturesBefore;
+	return result;
+}
+
+void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"Usage: %s [-f FONT]... [-p POINTS] [-w WIDTH] [-t MS] [-j FILE]\n"
+		"Benchmarks text rendering with the given fonts, the first one at\n"
+		"POINTS (default: %d) and the others as fallbacks at the same size.\n"
+		"Without -f, the default fonts of gmenu2x are used. Texts are\n"
+		"wrapped to WIDTH pixels (default: 305). Each measurement runs for\n"
+		"at least MS milliseconds (default: 200). -j writes the results to\n"
+		"FILE as JSON too.\n",
+		argv0, DEFAULT_FONT_SIZE);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+	std::vector<FontSpec> specs;
+	unsigned int points = 0;
+	int width = 305, ms = 200;
+	const char *json = nullptr;
+	int opt;
+	while ((opt = getopt(argc, argv, "f:p:w:t:j:h")) != -1) {
+		switch (opt) {
+		case 'f': specs.push_back(FontSpec{ optarg, 0 }); break;
+		case 'p': points = std::max(1, atoi(optarg)); break;
+		case 'w': width = std::max(1, atoi(optarg)); break;
+		case 't': ms = std::max(1, atoi(optarg)); break;
+		case 'j': json = optarg; break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : 2;
+		}
+	}
+	if (optind != argc) {
+		usage(argv[0]);
+		return 2;
+	}
+
+	if (specs.empty()) {
+		specs = { FontSpec{ DEFAULT_FONT_PATH, DEFAULT_FONT_SIZE }
+				DEFAULT_FALLBACK_FONTS };
+		if (points) {
+			for (auto &spec : specs)
+				spec.size = points;
+		}
+	} else {
+		for (auto &spec : specs)
+			spec.size = points ? points : DEFAULT_FONT_SIZE;
+	}
+	for (auto const& spec : specs) {
+		if (!fileExists(spec.path))
+			fprintf(stderr, "%s: not found, skipped\n", spec.path.c_str());
+	}
+
+	SDL_GetMemoryFunctions(&realMalloc, &realCalloc, &realRealloc, &realFree);
+	SDL_SetMemoryFunctions(countingMalloc, countingCalloc, countingRealloc,
+			realFree);
+
+	if (SDL_Init(0) < 0) {
+		fprintf(stderr, "Could not initialize SDL: %s\n", SDL_GetError());
+		return 1;
+	}
+	SDL_Surface *framebuffer = SDL_CreateRGBSurfaceWithFormat(
+			0, 320, 240, 32, SDL_PIXELFORMAT_ARGB8888);
+	SDL_Renderer *renderer = framebuffer
+			? SDL_CreateSoftwareRenderer(framebuffer) : nullptr;
+	if (!renderer) {
+		fprintf(stderr, "Could not create renderer: %s\n", SDL_GetError());
+		return 1;
+	}
+	Surface::setGlobalRenderer(renderer);
+
+	{
+		SDL_Texture *texture = SDL_CreateTexture(renderer,
+				SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, 320, 240);
+		if (!texture) {
+			fprintf(stderr, "Could not create texture: %s\n", SDL_GetError());
+			return 1;
+		}
+		SDL_SetRenderTarget(renderer, texture);
+		TargetSurface target(texture);
+
+		const long rssBefore = residentKiB();
+		FontStack font;
+		if (!font.LoadFonts(specs)) {
+			fprintf(stderr, "Unable to load any font\n");
+			return 1;
+		}
+		const long rssLoaded = residentKiB();
+		// What a text rendering thread and a skin with a larger font add.
+		auto duplicate = font.duplicate();
+		std::vector<FontSpec> largerSpecs = specs;
+		for (auto &spec : largerSpecs)
+			spec.size += 4;
+		FontStack larger;
+		larger.LoadFonts(largerSpecs);
+		const long rssVariants = residentKiB();
+		printf("resident: %ld KiB before loading fonts, %ld KiB after, "
+				"%ld KiB with a duplicate and a larger stack\n",
+				rssBefore, rssLoaded, rssVariants);
+
+		std::vector<Workload> workloads = {
+			{ "latin", { std::begin(latinLabels), std::end(latinLabels) },
+			  {}, true },
+			{ "cjk", { std::begin(cjkLabels), std::end(cjkLabels) },
+			  {}, true },
+			// Lines this long do not fit in a texture, and are never
+			// rendered as one.
+			{ "paragraph", { paragraph() }, {}, false },
+		};
+		for (auto &workload : workloads) {
+			for (auto const& text : workload.texts) {
+				workload.wrapped.push_back(workload.render
+						? text : wordWrap(font, text, width));
+			}
+		}
+
+		const double minSeconds = ms / 1000.0;
+		std::vector<Result> results;
+		for (auto const& workload : workloads) {
+			results.push_back(measure(workload.name, "width",
+					workload.texts, minSeconds,
+					[&](const std::string &text) {
+						font.getTextWidth(text);
+					}));
+			results.push_back(measure(workload.name, "wrap",
+					workload.texts, minSeconds,
+					[&](const std::string &text) {
+						wordWrap(font, text, width);
+					}));
+			results.push_back(measure(workload.name, "write",
+					workload.wrapped, minSeconds,
+					[&](const std::string &text) {
+						font.write(target, text, 0, 0);
+					}));
+			if (workload.render) {
+				results.push_back(measure(workload.name, "render",
+						workload.texts, minSeconds,
+						[&](const std::string &text) {
+							font.render(text);
+						}));
+			}
+		}
+
+		printf("%-10s %-7s %10s %12s %12s %14s\n", "workload",
+				"op", "calls", "ns/glyph", "allocs/call",
+				"textures/call");
+		for (const Result &r : results) {
+			printf("%-10s %-7s %10lu %12.2f %12.2f %14.2f\n",
+					r.workload, r.operation, r.calls,
+					r.seconds * 1e9 / r.glyphs,
+					double(r.allocations) / r.calls,
+					double(r.textures) / r.calls);
+		}
+
+		if (json) {
+			FILE *out = fopen(json, "w");
+			if (!out) {
+				fprintf(stderr, "%s: unable to write\n", json);
+				return 1;
+			}
+			fprintf(out, "{\n  \"fonts\": [");
+			for (size_t i = 0; i < specs.size(); i++) {
+				fprintf(out, "%s{ \"path\": \"%s\", \"size\": %u }",
+						i ? ", " : "", specs[i].path.c_str(), specs[i].size);
+			}
+			fprintf(out, "],\n  \"resident_kib\": { \"before\": %ld, "
+					"\"loaded\": %ld, \"variants\": %ld },\n",
+					rssBefore, rssLoaded, rssVariants);
+			fprintf(out, "  \"width\": %d,\n  \"results\": [\n", width);
+			for (size_t i = 0; i < results.size(); i++) {
+				const Result &r = results[i];
+				fprintf(out, "    { \"workload\": \"%s\", \"operation\": \"%s\", "
+						"\"calls\": %lu, \"glyphs\": %lu, "
+						"\"ns_per_glyph\": %.2f, \"allocs_per_call\": %.2f, "
+						"\"textures_per_call\": %.2f }%s\n",
+						r.workload, r.operation, r.calls, r.glyphs,
+						r.seconds * 1e9 / r.glyphs,
+						double(r.allocations) / r.calls,
+						double(r.textures) / r.calls,
+						i + 1 < results.size() ? "," : "");
+			}
+			fprintf(out, "  ]\n}\n");
+			if (fclose(out) != 0) {
+				fprintf(stderr, "%s: unable to write\n", json);
+				return 1;
+			}
+		}
+	}
+
+	SDL_DestroyRenderer(renderer);
+	SDL_FreeSurface(framebuffer);
+	SDL_Quit();
+	return 0;
+}
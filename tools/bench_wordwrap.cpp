@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: GPL-2.0
+//
+// bench_wordwrap: measures wordWrap on a large log.
+//
+// Wraps a log file (or a generated one of the requested size) to the width of
+// the text dialogs and reports the throughput, so that changes to the word
+// wrapping or to text measurement can be compared on the target device.
+// Text measurement dominates, so only timings taken with the real SDL_ttf
+// and the fonts of the skin are meaningful.
+
+#include "font_stack.h"
+#include "utilities.h"
+#include "word_wrap.h"
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <getopt.h>
+
+namespace {
+
+/**
+ * Generates log-like text: short and long lines, paths without spaces that
+ * force character breaks, indentation and some non-ASCII text.
+ */
+std::string generateLog(size_t size)
+{
+	static const char *const words[] = {
+		"INFO", "WARNING", "Loaded", "font", "surface", "section", "link",
+		"/media/data/apps/emulators/some-rather-long-package-name.opk",
+		"Unable", "to", "open", "the", "configuration", "file", "gmenu2x",
+		"Übersetzung", "ファイル", "0x7f3a21c0", "[", "]", "(", ")",
+	};
+	const size_t numWords = sizeof(words) / sizeof(words[0]);
+
+	std::string log;
+	log.reserve(size + 128);
+	unsigned int seed = 1;
+	while (log.size() < size) {
+		seed = seed * 1103515245 + 12345;
+		const unsigned int lineWords = 1 + (seed >> 16) % 40;
+		if ((seed >> 8) % 7 == 0)
+			log += "    ";
+		for (unsigned int i = 0; i < lineWords; i++) {
+			seed = seed * 1103515245 + 12345;
+			log += words[(seed >> 16) % numWords];
+			log += ' ';
+		}
+		log.back() = '\n';
+	}
+	return log;
+}
+
+void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"Usage: %s [-s SIZE] [-w WIDTH] [-p POINTS] [-n RUNS] FONT [LOGFILE]\n"
+		"Wraps LOGFILE, or a generated log of SIZE MiB (default: 4), to\n"
+		"WIDTH pixels (default: 305) using the given font.\n", argv0);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+	size_t size = 4;
+	int width = 305, points = 12, runs = 3;
+	int opt;
+	while ((opt = getopt(argc, argv, "s:w:p:n:h")) != -1) {
+		switch (opt) {
+		case 's': size = std::max(1, atoi(optarg)); break;
+		case 'w': width = std::max(1, atoi(optarg)); break;
+		case 'p': points = std::max(1, atoi(optarg)); break;
+		case 'n': runs = std::max(1, atoi(optarg)); break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : 2;
+		}
+	}
+	if (argc - optind < 1 || argc - optind > 2) {
+		usage(argv[0]);
+		return 2;
+	}
+
+	FontStack font;
+	if (!font.LoadFonts({ FontSpec{ argv[optind], unsigned(points) } })) {
+		fprintf(stderr, "%s: unable to load font\n", argv[optind]);
+		return 1;
+	}
+
+	const std::string text = optind + 1 < argc
+		? readFileAsString(argv[optind + 1])
+		: generateLog(size << 20);
+	if (text.empty()) {
+		fprintf(stderr, "Nothing to wrap\n");
+		return 1;
+	}
+
+	double best = 0;
+	size_t lines = 0;
+	for (int run = 0; run < runs; run++) {
+		auto start = std::chrono::steady_clock::now();
+		std::string wrapped = wordWrap(font, text, width);
+		std::chrono::duration<double> elapsed =
+			std::chrono::steady_clock::now() - start;
+		if (run == 0 || elapsed.count() < best)
+			best = elapsed.count();
+		lines = std::count(wrapped.begin(), wrapped.end(), '\n') + 1;
+	}
+
+	const double mib = text.size() / 1048576.0;
+	printf("%.2f MiB, %zu wrapped lines at %d px: %.1f ms, %.1f MiB/s\n",
+	       mib, lines, width, best * 1e3, mib / best);
+	return 0;
+}
@@ -0,0 +1,143 @@
+// SPDX-License-Identifier: GPL-2.0
+//
+// gmenu2x-mkcatalog: compiles translation files into catalogs.
+//
+// The build runs this on data/translations, so that gmenu2x can map the
+// catalogs instead of parsing the text files. Every written catalog is read
+// back and every term of the text file is looked up in it.
+//
+// Catalogs that were compiled from the current version of their text file,
+// going by the size and modification time recorded in the catalog, are left
+// alone; this is how the build keeps them up to date, since make cannot
+// handle the spaces in some of the file names as dependencies.
+
+#include "compat-filesystem.h"
+#include "translationcatalog.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <system_error>
+
+namespace fs = compat::filesystem;
+
+namespace {
+
+bool readFile(const char *path, std::string &contents)
+{
+	std::ifstream in(path, std::ios::in | std::ios::binary);
+	if (!in)
+		return false;
+	contents.assign(std::istreambuf_iterator<char>(in),
+			std::istreambuf_iterator<char>());
+	return !in.bad();
+}
+
+/** Checks that every term translates as its last definition does. */
+bool verify(const TranslationCatalog &catalog, compat::string_view text)
+{
+	const auto trim = [](compat::string_view s) {
+		auto b = s.find_first_not_of(" \t\r");
+		if (b == compat::string_view::npos)
+			return compat::string_view();
+		return s.substr(b, s.find_last_not_of(" \t\r") - b + 1);
+	};
+
+	std::map<compat::string_view, compat::string_view> terms;
+	for (size_t pos = 0; pos < text.size(); ) {
+		size_t end = text.find('\n', pos);
+		if (end == compat::string_view::npos)
+			end = text.size();
+		auto line = trim(text.substr(pos, end - pos));
+		pos = end + 1;
+
+		auto eq = line.find('=');
+		if (line.empty() || line[0] == '#' || eq == compat::string_view::npos)
+			continue;
+		terms[trim(line.substr(0, eq))] = trim(line.substr(eq + 1));
+	}
+
+	bool ok = true;
+	for (auto const& term : terms) {
+		int id = catalog.find(term.first);
+		if (id < 0 || catalog.translation(id) != term.second) {
+			fprintf(stderr, "term '%.*s' not found\n",
+					int(term.first.size()), term.first.data());
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+bool compileFile(const std::string &source, const std::string &dest)
+{
+	std::string text;
+	if (!readFile(source.c_str(), text)) {
+		fprintf(stderr, "%s: unable to read\n", source.c_str());
+		return false;
+	}
+
+	const std::string catalog = TranslationCatalog::compile(
+			text, TranslationCatalog::sourceOf(text));
+	{
+		std::ofstream out(dest, std::ios::out | std::ios::binary | std::ios::trunc);
+		out.write(catalog.data(), catalog.size());
+		if (!out) {
+			fprintf(stderr, "%s: unable to write\n", dest.c_str());
+			return false;
+		}
+	}
+
+	TranslationCatalog check;
+	if (!check.open(dest, source) || !verify(check, text)) {
+		fprintf(stderr, "%s: catalog does not match %s\n",
+				dest.c_str(), source.c_str());
+		std::remove(dest.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool isUpToDate(const fs::path &source, const fs::path &dest)
+{
+	std::error_code ec;
+	if (!fs::exists(dest, ec))
+		return false;
+	TranslationCatalog catalog;
+	return catalog.open(dest.string(), source.string());
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+	if (argc != 3) {
+		fprintf(stderr,
+			"Usage: %s TRANSLATION CATALOG\n"
+			"       %s TRANSLATION_DIR CATALOG_DIR\n", argv[0], argv[0]);
+		return 2;
+	}
+
+	std::error_code ec;
+	if (!fs::is_directory(argv[1], ec))
+		return compileFile(argv[1], argv[2]) ? 0 : 1;
+
+	fs::create_directories(argv[2], ec);
+	unsigned int failed = 0;
+	for (fs::directory_iterator it(argv[1], ec), end;
+	     !ec && it != end; it.increment(ec)) {
+		if (!fs::is_regular_file(it->path(), ec))
+			continue;
+		const fs::path dest = fs::path(argv[2]) / it->path().filename();
+		if (!isUpToDate(it->path(), dest)
+				&& !compileFile(it->path().string(), dest.string()))
+			failed++;
+	}
+	if (ec) {
+		fprintf(stderr, "%s: %s\n", argv[1], ec.message().c_str());
+		return 1;
+	}
+	return failed ? 1 : 0;
+}
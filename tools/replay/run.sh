@@ -0,0 +1,86 @@
+#!/bin/sh
+# SPDX-License-Identifier: GPL-2.0
+#
+# Replays the scripts of this directory against a fixture home directory.
+#
+# The fixture is built in OUTDIR/home from scratch on every run:
+#   sections/applications  40 links,
+#   sections/emulators     a link whose selector lists 10000 files,
+#   sections/games         4 links,
+#   gmenu2x.log            5000 lines, so the settings have a log viewer,
+# with the skins of the source tree and the default input.conf.
+# Each SCRIPT.replay writes its recording to OUTDIR/SCRIPT.json. Every
+# script is replayed twice, the second time into OUTDIR/SCRIPT.again.json,
+# and the run fails if the frame checksums of both differ.
+
+set -e
+
+if [ $# -lt 2 ]; then
+	echo "Usage: $0 GMENU2X OUTDIR [SCRIPT...]" >&2
+	exit 2
+fi
+
+gmenu2x=$(realpath "$1")
+out=$(realpath -m "$2")
+shift 2
+here=$(cd "$(dirname "$0")" && pwd)
+data=$here/../../data
+[ $# -gt 0 ] || set -- "$here"/*.replay
+
+home=$out/home
+g2x=$home/.gmenu2x
+rm -rf "$home" "$out/roms"
+mkdir -p "$g2x/sections/applications" "$g2x/sections/emulators" \
+	"$g2x/sections/games" "$out/roms"
+
+ln -s "$(realpath "$data/skins")" "$g2x/skins"
+cp "$data/input.conf" "$g2x/input.conf"
+cat > "$g2x/gmenu2x.conf" <<CONF
+skin="Default"
+saveSelection=0
+backlightTimeout=0
+outputLogs=0
+CONF
+
+i=1
+while [ $i -le 40 ]; do
+	printf 'title=Application %d\nexec=/bin/true\n' $i \
+		> "$g2x/sections/applications/app$i"
+	i=$((i + 1))
+done
+i=1
+while [ $i -le 4 ]; do
+	printf 'title=Game %d\nexec=/bin/true\n' $i > "$g2x/sections/games/game$i"
+	i=$((i + 1))
+done
+printf 'title=ROMs\nexec=/bin/true\nselectordir=%s\nselectorbrowser=false\n' \
+	"$out/roms" > "$g2x/sections/emulators/roms"
+(cd "$out/roms" && seq -f 'rom-%05g.bin' 1 10000 | xargs touch)
+seq -f 'Line %g of the output of the last launched program.' 1 5000 \
+	> "$g2x/gmenu2x.log"
+
+checksums() {
+	grep -o '"checksum": "[0-9a-f]*"' "$1"
+}
+
+status=0
+for script in "$@"; do
+	name=$(basename "$script" .replay)
+	echo "Replaying $name"
+	for run in "$name" "$name.again"; do
+		HOME=$home "$gmenu2x" --replay "$script" --record "$out/$run.json" \
+			> "$out/$run.log" 2>&1 || {
+			echo "$run failed, see $out/$run.log" >&2
+			status=1
+			continue 2
+		}
+	done
+	checksums "$out/$name.json" > "$out/$name.checksums"
+	checksums "$out/$name.again.json" > "$out/$name.again.checksums"
+	if ! cmp -s "$out/$name.checksums" "$out/$name.again.checksums"; then
+		echo "$name is not reproducible, compare $out/$name.json" \
+			"and $out/$name.again.json" >&2
+		status=1
+	fi
+done
+exit $status
@@ -0,0 +1,196 @@
+// SPDX-License-Identifier: GPL-2.0
+//
+// gmenu2x-skinconv: converts the PNG images of a skin to QOI.
+//
+// gmenu2x loads "foo.qoi" in place of "foo.png" when both exist, so the
+// converted skin keeps working with older versions that only read PNG.
+// For every image the decode time of both formats is measured and a summary
+// is printed, so the gain can be checked on the target device.
+
+#include "compat-filesystem.h"
+#include "imageio.h"
+
+#include <SDL2/SDL.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <getopt.h>
+
+namespace fs = compat::filesystem;
+
+namespace {
+
+struct Totals {
+	unsigned int files = 0, failed = 0;
+	uintmax_t pngBytes = 0, qoiBytes = 0;
+	double pngSeconds = 0, qoiSeconds = 0;
+};
+
+bool convert = true, force = false, verbose = false;
+
+// Decode each image a few times and keep the fastest run, to reduce the
+// influence of the page cache and of other processes.
+constexpr int DECODE_RUNS = 3;
+
+template <typename Loader>
+SDL_Surface *timeDecode(Loader load, const std::string &path, double &seconds)
+{
+	SDL_Surface *result = nullptr;
+	seconds = 0;
+	for (int i = 0; i < DECODE_RUNS; i++) {
+		auto start = std::chrono::steady_clock::now();
+		SDL_Surface *surface = load(path, true);
+		std::chrono::duration<double> elapsed =
+			std::chrono::steady_clock::now() - start;
+		if (!surface)
+			return nullptr;
+
+		if (!result || elapsed.count() < seconds)
+			seconds = elapsed.count();
+		if (result)
+			SDL_FreeSurface(result);
+		result = surface;
+	}
+	return result;
+}
+
+bool samePixels(SDL_Surface *a, SDL_Surface *b)
+{
+	if (a->w != b->w || a->h != b->h)
+		return false;
+	for (int y = 0; y < a->h; y++) {
+		if (memcmp(static_cast<char *>(a->pixels) + y * a->pitch,
+		           static_cast<char *>(b->pixels) + y * b->pitch,
+		           a->w * 4) != 0)
+			return false;
+	}
+	return true;
+}
+
+void processImage(const std::string &pngPath, Totals &totals)
+{
+	std::string qoiPath = qoiSiblingPath(pngPath);
+	std::error_code ec;
+
+	double pngSeconds, qoiSeconds;
+	SDL_Surface *png = timeDecode(loadPNG, pngPath, pngSeconds);
+	if (!png) {
+		fprintf(stderr, "%s: unable to decode\n", pngPath.c_str());
+		totals.failed++;
+		return;
+	}
+
+	if (convert && (force || !fs::exists(qoiPath, ec))) {
+		if (!saveQOI(png, qoiPath)) {
+			SDL_FreeSurface(png);
+			totals.failed++;
+			return;
+		}
+	}
+
+	SDL_Surface *qoi = timeDecode(loadQOI, qoiPath, qoiSeconds);
+	if (!qoi) {
+		// Not converted (yet); measure the PNG only.
+		if (verbose)
+			printf("%s: PNG %.2f ms\n", pngPath.c_str(), pngSeconds * 1e3);
+		SDL_FreeSurface(png);
+		return;
+	}
+
+	if (!samePixels(png, qoi)) {
+		fprintf(stderr, "%s: QOI pixels differ from PNG\n", qoiPath.c_str());
+		totals.failed++;
+	} else {
+		totals.files++;
+		totals.pngBytes += fs::file_size(pngPath, ec);
+		totals.qoiBytes += fs::file_size(qoiPath, ec);
+		totals.pngSeconds += pngSeconds;
+		totals.qoiSeconds += qoiSeconds;
+
+		if (verbose)
+			printf("%s: %dx%d, PNG %.2f ms, QOI %.2f ms\n",
+			       pngPath.c_str(), png->w, png->h,
+			       pngSeconds * 1e3, qoiSeconds * 1e3);
+	}
+
+	SDL_FreeSurface(png);
+	SDL_FreeSurface(qoi);
+}
+
+bool isPNG(const fs::path &path)
+{
+	std::string ext = path.extension().string();
+	return strcasecmp(ext.c_str(), ".png") == 0;
+}
+
+void processDirectory(const std::string &dir, Totals &totals)
+{
+	std::error_code ec;
+	std::vector<std::string> images;
+	for (fs::recursive_directory_iterator it(dir, ec), end;
+	     !ec && it != end; it.increment(ec)) {
+		if (fs::is_regular_file(it->path(), ec) && isPNG(it->path()))
+			images.push_back(it->path().string());
+	}
+	if (ec) {
+		fprintf(stderr, "%s: %s\n", dir.c_str(), ec.message().c_str());
+		totals.failed++;
+		return;
+	}
+
+	for (auto const& image : images)
+		processImage(image, totals);
+}
+
+void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"Usage: %s [-n] [-f] [-v] DIRECTORY...\n"
+		"Converts all PNG images below the given skin directories to QOI\n"
+		"and reports the decode time of both formats.\n\n"
+		"  -n  do not write QOI files, only measure existing ones\n"
+		"  -f  overwrite existing QOI files\n"
+		"  -v  report every image\n", argv0);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+	int opt;
+	while ((opt = getopt(argc, argv, "nfvh")) != -1) {
+		switch (opt) {
+		case 'n': convert = false; break;
+		case 'f': force = true; break;
+		case 'v': verbose = true; break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : 2;
+		}
+	}
+	if (optind == argc) {
+		usage(argv[0]);
+		return 2;
+	}
+
+	Totals totals;
+	for (int i = optind; i < argc; i++)
+		processDirectory(argv[i], totals);
+
+	printf("%u images, PNG %.1f KiB in %.1f ms, QOI %.1f KiB in %.1f ms",
+	       totals.files,
+	       totals.pngBytes / 1024.0, totals.pngSeconds * 1e3,
+	       totals.qoiBytes / 1024.0, totals.qoiSeconds * 1e3);
+	if (totals.qoiSeconds > 0)
+		printf(" (%.1fx faster)", totals.pngSeconds / totals.qoiSeconds);
+	printf("\n");
+	if (totals.failed)
+		printf("%u images failed\n", totals.failed);
+
+	return totals.failed ? 1 : 0;
+}